@@ -0,0 +1,54 @@
+/* Benchmark harness
+ *
+ * Copyright (C) 2016 Yibo Cai
+ */
+#pragma once
+
+/* Benchmarked operation
+ * - run(arg) is timed
+ * - reset(arg), if not null, restores input before each run, not timed
+ */
+struct bench_op {
+	const char *suite;
+	const char *name;
+	long size;
+
+	void (*run)(void *arg);
+	void (*reset)(void *arg);
+	void *arg;
+};
+
+enum {
+	BENCH_FMT_TEXT,
+	BENCH_FMT_CSV,
+	BENCH_FMT_JSON,
+};
+
+struct bench_cfg {
+	int fmt;		/* Output format */
+	FILE *out;		/* Output file */
+	int samples;		/* Samples per operation */
+	double warmup_ns;	/* Warmup time per operation */
+	double sample_ns;	/* Minimal time of one sample */
+	int quick;		/* Smaller sizes for a fast run */
+};
+
+extern struct bench_cfg bench_cfg;
+
+void bench_begin(void);
+void bench_end(void);
+void bench_run(const struct bench_op *op);
+
+/* Largest size to sweep, cut down in quick mode */
+static inline long bench_max(long max)
+{
+	return bench_cfg.quick ? max / 16 : max;
+}
+
+/* Suites */
+void bench_integer(void);
+void bench_decimal(void);
+void bench_fft(void);
+void bench_matrix(void);
+void bench_sort(void);
+void bench_container(void);
@@ -0,0 +1,233 @@
+/* Benchmark sort and containers
+ *
+ * Copyright (C) 2016 Yibo Cai
+ */
+#include <tt/tt.h>
+#include <tt/common/sort.h>
+#include <tt/common/stack.h>
+#include <tt/common/queue.h>
+#include <tt/common/heap.h>
+#include <tt/common/tree.h>
+#include <common/lib.h>
+#include "bench.h"
+
+#include <string.h>
+
+static int cmp_int(const struct tt_key *num, const void *v1, const void *v2)
+{
+	const int i1 = *(const int *)v1, i2 = *(const int *)v2;
+
+	return (i1 > i2) - (i1 < i2);
+}
+
+struct sort_arg {
+	struct tt_sort_input input;
+	int *data, *save;
+};
+
+static void run_sort(void *arg)
+{
+	struct sort_arg *sa = arg;
+	tt_sort(&sa->input);
+}
+
+static void reset_sort(void *arg)
+{
+	struct sort_arg *sa = arg;
+	memcpy(sa->data, sa->save, sa->input.count * sizeof(int));
+}
+
+static const struct {
+	const char *name;
+	enum tt_sort_alg alg;
+	long max;
+} sort_algs[] = {
+	{ "insert", TT_SORT_INSERT, 1 << 12 },
+	{ "merge", TT_SORT_MERGE, 1 << 20 },
+	{ "heap", TT_SORT_HEAP, 1 << 20 },
+	{ "quick", TT_SORT_QUICK, 1 << 20 },
+};
+
+/* Element count of random integers */
+void bench_sort(void)
+{
+	const long max = bench_max(1 << 20);
+	struct sort_arg sa = {
+		.input = {
+			.num = {
+				.size = sizeof(int),
+				.cmp = cmp_int,
+			},
+		},
+		.data = malloc(max * sizeof(int)),
+		.save = malloc(max * sizeof(int)),
+	};
+	if (!sa.data || !sa.save)
+		goto out;
+	for (long i = 0; i < max; i++)
+		sa.save[i] = rand();
+	sa.input.data = sa.data;
+
+	struct bench_op op = {
+		.suite = "sort",
+		.run = run_sort,
+		.reset = reset_sort,
+		.arg = &sa,
+	};
+	for (int i = 0; i < ARRAY_SIZE(sort_algs); i++) {
+		op.name = sort_algs[i].name;
+		sa.input.alg = sort_algs[i].alg;
+		for (long n = 256; n <= _tt_min(max, sort_algs[i].max); n *= 4) {
+			sa.input.count = n;
+			op.size = n;
+			bench_run(&op);
+		}
+	}
+
+out:
+	free(sa.data);
+	free(sa.save);
+}
+
+struct container_arg {
+	struct tt_stack stack;
+	struct tt_queue queue;
+	struct tt_heap heap;
+	struct tt_bintree tree;
+	int *keys;
+	long n;
+};
+
+/* Push n then pop n */
+static void run_stack(void *arg)
+{
+	struct container_arg *ca = arg;
+	int v;
+
+	for (long i = 0; i < ca->n; i++)
+		tt_stack_push(&ca->stack, &ca->keys[i]);
+	for (long i = 0; i < ca->n; i++)
+		tt_stack_pop(&ca->stack, &v);
+}
+
+/* Enqueue n then dequeue n */
+static void run_queue(void *arg)
+{
+	struct container_arg *ca = arg;
+	int v;
+
+	for (long i = 0; i < ca->n; i++)
+		tt_queue_enque(&ca->queue, &ca->keys[i]);
+	for (long i = 0; i < ca->n; i++)
+		tt_queue_deque(&ca->queue, &v);
+}
+
+/* Insert n then extract n */
+static void run_heap(void *arg)
+{
+	struct container_arg *ca = arg;
+	int v;
+
+	for (long i = 0; i < ca->n; i++)
+		tt_heap_insert(&ca->heap, &ca->keys[i]);
+	for (long i = 0; i < ca->n; i++)
+		tt_heap_extract(&ca->heap, &v);
+}
+
+/* Insert n, search n, then free */
+static void run_tree(void *arg)
+{
+	struct container_arg *ca = arg;
+
+	for (long i = 0; i < ca->n; i++)
+		tt_bintree_insert(&ca->tree, &ca->keys[i], NULL);
+	for (long i = 0; i < ca->n; i++)
+		tt_bintree_search(&ca->tree, &ca->keys[i]);
+	tt_bintree_free(&ca->tree);
+}
+
+/* Operation count n */
+void bench_container(void)
+{
+	const long max = bench_max(1 << 18);
+	struct container_arg ca = {
+		.keys = malloc(max * sizeof(int)),
+	};
+	void *heap_data = malloc(max * sizeof(int));
+	if (!ca.keys || !heap_data)
+		goto out;
+	for (long i = 0; i < max; i++)
+		ca.keys[i] = rand();
+
+	struct bench_op op = {
+		.suite = "container",
+		.arg = &ca,
+	};
+
+	for (ca.n = 1024; ca.n <= max; ca.n *= 16) {
+		op.size = ca.n;
+
+		/* Fixed and dynamic stack */
+		ca.stack = (struct tt_stack) {
+			.cap = ca.n,
+			.esize = sizeof(int),
+		};
+		tt_stack_init(&ca.stack);
+		op.name = "stack_fixed";
+		op.run = run_stack;
+		bench_run(&op);
+		tt_stack_free(&ca.stack);
+
+		ca.stack.cap = 0;
+		tt_stack_init(&ca.stack);
+		op.name = "stack_dynamic";
+		bench_run(&op);
+		tt_stack_free(&ca.stack);
+
+		/* Fixed and dynamic queue */
+		ca.queue = (struct tt_queue) {
+			.cap = ca.n,
+			.esize = sizeof(int),
+		};
+		tt_queue_init(&ca.queue);
+		op.name = "queue_fixed";
+		op.run = run_queue;
+		bench_run(&op);
+		tt_queue_free(&ca.queue);
+
+		ca.queue.cap = 0;
+		tt_queue_init(&ca.queue);
+		op.name = "queue_dynamic";
+		bench_run(&op);
+		tt_queue_free(&ca.queue);
+
+		ca.heap = (struct tt_heap) {
+			.num = {
+				.size = sizeof(int),
+				.cmp = cmp_int,
+			},
+			.data = heap_data,
+			.cap = ca.n,
+			.htype = TT_HEAP_MIN,
+		};
+		tt_heap_init(&ca.heap);
+		op.name = "heap";
+		op.run = run_heap;
+		bench_run(&op);
+
+		ca.tree = (struct tt_bintree) {
+			.knum = {
+				.size = sizeof(int),
+				.cmp = cmp_int,
+			},
+		};
+		tt_bintree_init(&ca.tree);
+		op.name = "rbtree";
+		op.run = run_tree;
+		bench_run(&op);
+	}
+
+out:
+	free(ca.keys);
+	free(heap_data);
+}
@@ -0,0 +1,3 @@
+bench-objs		:= main.o harness.o integer.o decimal.o number.o common.o
+
+bin-y += bench
@@ -0,0 +1,382 @@
+/* Benchmark arbitrary precision decimal
+ *
+ * Copyright (C) 2016 Yibo Cai
+ */
+#include <tt/tt.h>
+#include <tt/apn/decimal.h>
+#include <common/lib.h>
+#include "bench.h"
+
+#include <string.h>
+
+struct dec_arg {
+	struct tt_dec *r, *a, *b;
+	struct tt_dec *f;	/* Argument of functions, 1 <= f < 10 */
+	char *str;
+	int len;
+	int exp;		/* Quantum of quantize, drops prec/4 digits */
+	struct tt_dec_ctx ctx;	/* Rounds to half of precision */
+	uint64_t ieee[2];
+	int fmt;
+	double d;
+};
+
+/* Random decimal string of "digs" digits */
+static void rand_dec_str(char *s, int digs)
+{
+	*s++ = rand() % 9 + '1';
+	for (int i = 1; i < digs; i++) {
+		*s++ = rand() % 10 + '0';
+		if (i == digs / 2)
+			*s++ = '.';
+	}
+	sprintf(s, "e%d", rand() % 20 - 10);
+}
+
+static void run_add(void *arg)
+{
+	struct dec_arg *da = arg;
+	tt_dec_add(da->r, da->a, da->b);
+}
+
+static void run_sub(void *arg)
+{
+	struct dec_arg *da = arg;
+	tt_dec_sub(da->r, da->a, da->b);
+}
+
+static void run_mul(void *arg)
+{
+	struct dec_arg *da = arg;
+	tt_dec_mul(da->r, da->a, da->b);
+}
+
+static void run_div(void *arg)
+{
+	struct dec_arg *da = arg;
+	tt_dec_div(da->r, da->a, da->b);
+}
+
+static void run_cmp(void *arg)
+{
+	struct dec_arg *da = arg;
+	tt_dec_cmp(da->a, da->b);
+}
+
+static void run_from_string(void *arg)
+{
+	struct dec_arg *da = arg;
+	tt_dec_from_string(da->r, da->str);
+}
+
+static void run_to_string(void *arg)
+{
+	struct dec_arg *da = arg;
+	tt_dec_to_string(da->a, da->str, da->len);
+}
+
+static void run_quantize(void *arg)
+{
+	struct dec_arg *da = arg;
+	tt_dec_quantize(da->r, da->a, da->exp, 0);
+}
+
+static void run_reduce(void *arg)
+{
+	struct dec_arg *da = arg;
+	tt_dec_reduce(da->r, da->a);
+}
+
+static void run_add_ctx(void *arg)
+{
+	struct dec_arg *da = arg;
+	tt_dec_add_ctx(da->r, da->a, da->b, &da->ctx);
+}
+
+static void run_sub_ctx(void *arg)
+{
+	struct dec_arg *da = arg;
+	tt_dec_sub_ctx(da->r, da->a, da->b, &da->ctx);
+}
+
+static void run_mul_ctx(void *arg)
+{
+	struct dec_arg *da = arg;
+	tt_dec_mul_ctx(da->r, da->a, da->b, &da->ctx);
+}
+
+static void run_div_ctx(void *arg)
+{
+	struct dec_arg *da = arg;
+	tt_dec_div_ctx(da->r, da->a, da->b, &da->ctx);
+}
+
+static void run_to_ieee(void *arg)
+{
+	struct dec_arg *da = arg;
+	tt_dec_to_ieee(da->a, da->ieee, da->fmt);
+}
+
+static void run_from_ieee(void *arg)
+{
+	struct dec_arg *da = arg;
+	tt_dec_from_ieee(da->r, da->ieee, da->fmt);
+}
+
+static void run_from_float(void *arg)
+{
+	struct dec_arg *da = arg;
+	tt_dec_from_float(da->r, da->d);
+}
+
+#ifdef __STDC_IEC_559__
+static void run_to_float(void *arg)
+{
+	struct dec_arg *da = arg;
+	tt_dec_to_float(da->a, &da->d);
+}
+#endif
+
+static void run_sqrt(void *arg)
+{
+	struct dec_arg *da = arg;
+	tt_dec_sqrt(da->r, da->a);
+}
+
+static void run_exp(void *arg)
+{
+	struct dec_arg *da = arg;
+	tt_dec_exp(da->r, da->f);
+}
+
+static void run_ln(void *arg)
+{
+	struct dec_arg *da = arg;
+	tt_dec_ln(da->r, da->a);
+}
+
+static void run_pow(void *arg)
+{
+	struct dec_arg *da = arg;
+	tt_dec_pow(da->r, da->a, da->f);
+}
+
+/* Sum of products of n pairs of short decimals, like quantity and price */
+struct dot_arg {
+	struct tt_dec *r, *t;
+	struct tt_dec **a, **b;
+	int n;
+};
+
+static void run_dot(void *arg)
+{
+	struct dot_arg *da = arg;
+	tt_dec_dot(da->r, da->a, da->b, da->n);
+}
+
+/* Same by multiply and add, rounding each step */
+static void run_mul_add(void *arg)
+{
+	struct dot_arg *da = arg;
+
+	tt_dec_from_uint(da->r, 0);
+	for (int i = 0; i < da->n; i++) {
+		tt_dec_mul(da->t, da->a[i], da->b[i]);
+		tt_dec_add(da->r, da->r, da->t);
+	}
+}
+
+static void bench_dot(struct bench_op *op)
+{
+	char s[32];
+
+	for (long n = 10; n <= bench_max(100000); n *= 10) {
+		struct dot_arg da = {
+			.r = tt_dec_alloc(0),
+			.t = tt_dec_alloc(0),
+			.a = calloc(n, sizeof(struct tt_dec *)),
+			.b = calloc(n, sizeof(struct tt_dec *)),
+			.n = n,
+		};
+		if (!da.r || !da.t || !da.a || !da.b)
+			break;
+		for (int i = 0; i < n; i++) {
+			da.a[i] = tt_dec_alloc(0);
+			da.b[i] = tt_dec_alloc(0);
+			if (!da.a[i] || !da.b[i])
+				break;
+			tt_dec_from_uint(da.a[i], rand() % 1000000);
+			sprintf(s, "%d.%02d", rand() % 10000, rand() % 100);
+			tt_dec_from_string(da.b[i], s);
+		}
+
+		op->arg = &da;
+		op->size = n;
+		op->name = "dot";
+		op->run = run_dot;
+		bench_run(op);
+		op->name = "mul_add";
+		op->run = run_mul_add;
+		bench_run(op);
+
+		for (int i = 0; i < n; i++) {
+			if (da.a[i])
+				tt_dec_free(da.a[i]);
+			if (da.b[i])
+				tt_dec_free(da.b[i]);
+		}
+		free(da.a);
+		free(da.b);
+		tt_dec_free(da.r);
+		tt_dec_free(da.t);
+	}
+}
+
+static const struct {
+	const char *name;
+	void (*run)(void *arg);
+} dec_ops[] = {
+	{ "add", run_add },
+	{ "sub", run_sub },
+	{ "mul", run_mul },
+	{ "div", run_div },
+	{ "cmp", run_cmp },
+	{ "from_string", run_from_string },
+	{ "to_string", run_to_string },
+	{ "quantize", run_quantize },
+	{ "reduce", run_reduce },
+	{ "add_ctx", run_add_ctx },
+	{ "sub_ctx", run_sub_ctx },
+	{ "mul_ctx", run_mul_ctx },
+	{ "div_ctx", run_div_ctx },
+};
+
+/* Elementary functions, far slower, swept to smaller precision */
+#define FUNC_PREC_MAX	2000
+
+static const struct {
+	const char *name;
+	void (*run)(void *arg);
+} dec_funcs[] = {
+	{ "sqrt", run_sqrt },
+	{ "exp", run_exp },
+	{ "ln", run_ln },
+	{ "pow", run_pow },
+};
+
+/* IEEE interchange formats, size is digits of format */
+static const struct {
+	const char *to, *from;
+	int fmt, digs;
+} ieee_fmts[] = {
+	{ "to_bid32", "from_bid32", TT_DEC_BID32, 7 },
+	{ "to_bid64", "from_bid64", TT_DEC_BID64, 16 },
+	{ "to_dpd32", "from_dpd32", TT_DEC_DPD32, 7 },
+	{ "to_dpd64", "from_dpd64", TT_DEC_DPD64, 16 },
+#ifdef __SIZEOF_INT128__
+	{ "to_bid128", "from_bid128", TT_DEC_BID128, 34 },
+	{ "to_dpd128", "from_dpd128", TT_DEC_DPD128, 34 },
+#endif
+};
+
+/* Fixed width conversions, IEEE decimal and binary float */
+static void bench_convert(struct bench_op *op)
+{
+	char s[64];
+	struct dec_arg da = {
+		.r = tt_dec_alloc(0),
+		.a = tt_dec_alloc(0),
+	};
+
+	if (!da.r || !da.a)
+		goto out;
+	op->arg = &da;
+
+	for (int i = 0; i < ARRAY_SIZE(ieee_fmts); i++) {
+		rand_dec_str(s, ieee_fmts[i].digs);
+		tt_dec_from_string(da.a, s);
+		da.fmt = ieee_fmts[i].fmt;
+		tt_dec_to_ieee(da.a, da.ieee, da.fmt);
+
+		op->size = ieee_fmts[i].digs;
+		op->name = ieee_fmts[i].to;
+		op->run = run_to_ieee;
+		bench_run(op);
+		op->name = ieee_fmts[i].from;
+		op->run = run_from_ieee;
+		bench_run(op);
+	}
+
+	/* Shortest round trip digits of a random double, up to 17 */
+	da.d = (double)rand() / RAND_MAX * 1000;
+	tt_dec_from_float(da.a, da.d);
+	op->size = 17;
+	op->name = "from_float";
+	op->run = run_from_float;
+	bench_run(op);
+#ifdef __STDC_IEC_559__
+	op->name = "to_float";
+	op->run = run_to_float;
+	bench_run(op);
+#endif
+
+out:
+	if (da.r)
+		tt_dec_free(da.r);
+	if (da.a)
+		tt_dec_free(da.a);
+}
+
+/* Precision in decimal digits */
+void bench_decimal(void)
+{
+	struct bench_op op = {
+		.suite = "decimal",
+	};
+
+	for (long prec = 20; prec <= bench_max(20000); prec *= 10) {
+		struct dec_arg da = {
+			.r = tt_dec_alloc(prec),
+			.a = tt_dec_alloc(prec),
+			.b = tt_dec_alloc(prec),
+			.f = tt_dec_alloc(prec),
+			.len = prec + 32,
+			.ctx = { .prec = prec / 2 },
+		};
+		da.str = malloc(da.len);
+		if (!da.r || !da.a || !da.b || !da.f || !da.str)
+			break;
+
+		rand_dec_str(da.str, prec);
+		tt_dec_from_string(da.a, da.str);
+		da.exp = atoi(strrchr(da.str, 'e') + 1) -
+			(prec - 1 - prec / 2) + prec / 4;
+		rand_dec_str(da.str, prec);
+		tt_dec_from_string(da.b, da.str);
+		rand_dec_str(da.str, prec);
+		sprintf(strrchr(da.str, 'e'), "e%ld", -(prec / 2));
+		tt_dec_from_string(da.f, da.str);
+
+		op.arg = &da;
+		op.size = prec;
+		for (int i = 0; i < ARRAY_SIZE(dec_ops); i++) {
+			op.name = dec_ops[i].name;
+			op.run = dec_ops[i].run;
+			bench_run(&op);
+		}
+		for (int i = 0; prec <= bench_max(FUNC_PREC_MAX) &&
+				i < ARRAY_SIZE(dec_funcs); i++) {
+			op.name = dec_funcs[i].name;
+			op.run = dec_funcs[i].run;
+			bench_run(&op);
+		}
+
+		tt_dec_free(da.r);
+		tt_dec_free(da.a);
+		tt_dec_free(da.b);
+		tt_dec_free(da.f);
+		free(da.str);
+	}
+	bench_dot(&op);
+	bench_convert(&op);
+}
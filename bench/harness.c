@@ -0,0 +1,145 @@
+/* Benchmark harness: warmup, calibration, statistics and report
+ *
+ * Copyright (C) 2016 Yibo Cai
+ */
+#include <tt/tt.h>
+#include "bench.h"
+
+#include <math.h>
+#include <time.h>
+
+struct bench_cfg bench_cfg = {
+	.fmt = BENCH_FMT_TEXT,
+	.samples = 21,
+	.warmup_ns = 20e6,
+	.sample_ns = 1e6,
+};
+
+static int records;
+
+static double now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static int cmp_double(const void *a, const void *b)
+{
+	const double d = *(const double *)a - *(const double *)b;
+
+	return (d > 0) - (d < 0);
+}
+
+/* Nearest rank percentile of sorted samples */
+static double percentile(const double *s, int n, int p)
+{
+	int i = (int)ceil(p / 100.0 * n) - 1;
+
+	return s[i < 0 ? 0 : i];
+}
+
+/* Time of "reps" runs in ns */
+static double run_reps(const struct bench_op *op, long reps)
+{
+	double t = 0;
+
+	if (op->reset) {
+		for (long i = 0; i < reps; i++) {
+			op->reset(op->arg);
+			double t0 = now_ns();
+			op->run(op->arg);
+			t += now_ns() - t0;
+		}
+	} else {
+		double t0 = now_ns();
+		for (long i = 0; i < reps; i++)
+			op->run(op->arg);
+		t = now_ns() - t0;
+	}
+
+	return t;
+}
+
+void bench_begin(void)
+{
+	FILE *fp = bench_cfg.out;
+
+	records = 0;
+	if (bench_cfg.fmt == BENCH_FMT_CSV)
+		fprintf(fp, "suite,op,size,samples,reps,min_ns,median_ns,"
+				"p90_ns,p99_ns,max_ns,ops_per_sec\n");
+	else if (bench_cfg.fmt == BENCH_FMT_JSON)
+		fprintf(fp, "[");
+	else
+		fprintf(fp, "%-10s %-14s %10s %14s %14s %14s %14s\n",
+				"suite", "op", "size", "median(ns)",
+				"p90(ns)", "p99(ns)", "ops/s");
+}
+
+void bench_end(void)
+{
+	if (bench_cfg.fmt == BENCH_FMT_JSON)
+		fprintf(bench_cfg.out, "\n]\n");
+	fflush(bench_cfg.out);
+}
+
+void bench_run(const struct bench_op *op)
+{
+	const int n = bench_cfg.samples;
+	double *s = malloc(n * sizeof(double));
+	if (s == NULL)
+		return;
+
+	/* Warmup, calibrate repetitions for one sample */
+	long reps = 1;
+	double t, warm = 0;
+	while (1) {
+		t = run_reps(op, reps);
+		warm += t;
+		if (t >= bench_cfg.sample_ns) {
+			if (warm >= bench_cfg.warmup_ns)
+				break;
+		} else {
+			reps *= 2;
+		}
+	}
+
+	for (int i = 0; i < n; i++)
+		s[i] = run_reps(op, reps) / reps;
+	qsort(s, n, sizeof(double), cmp_double);
+
+	const double med = percentile(s, n, 50);
+	const double p90 = percentile(s, n, 90);
+	const double p99 = percentile(s, n, 99);
+	FILE *fp = bench_cfg.out;
+
+	switch (bench_cfg.fmt) {
+	case BENCH_FMT_CSV:
+		fprintf(fp, "%s,%s,%ld,%d,%ld,%.1f,%.1f,%.1f,%.1f,%.1f,%.1f\n",
+				op->suite, op->name, op->size, n, reps,
+				s[0], med, p90, p99, s[n-1], 1e9 / med);
+		break;
+	case BENCH_FMT_JSON:
+		fprintf(fp, "%s\n  {\"suite\": \"%s\", \"op\": \"%s\", "
+				"\"size\": %ld, \"samples\": %d, "
+				"\"reps\": %ld, \"min_ns\": %.1f, "
+				"\"median_ns\": %.1f, \"p90_ns\": %.1f, "
+				"\"p99_ns\": %.1f, \"max_ns\": %.1f, "
+				"\"ops_per_sec\": %.1f}",
+				records ? "," : "", op->suite, op->name,
+				op->size, n, reps, s[0], med, p90, p99,
+				s[n-1], 1e9 / med);
+		break;
+	default:
+		fprintf(fp, "%-10s %-14s %10ld %14.1f %14.1f %14.1f %14.1f\n",
+				op->suite, op->name, op->size, med, p90, p99,
+				1e9 / med);
+		break;
+	}
+	fflush(fp);
+
+	records++;
+	free(s);
+}
@@ -0,0 +1,376 @@
+/* Benchmark arbitrary precision integer
+ *
+ * Copyright (C) 2016 Yibo Cai
+ */
+#include <tt/tt.h>
+#include <tt/apn/integer.h>
+#include <common/lib.h>
+#include <apn/integer/integer.h>
+#include "bench.h"
+
+#include <string.h>
+
+struct int_arg {
+	struct tt_int *r, *q, *a, *b;
+	char *str;
+	int n;
+	unsigned char *buf;	/* Exported bytes */
+	size_t len;
+	struct tt_int **mods, **rems;
+};
+
+/* Moduli of mod_multi and crt, one word primes */
+#define MODS_MAX	1024
+
+static void rand_int(struct tt_int *ti, int msb)
+{
+	_tt_int_zero(ti);
+	_tt_int_realloc(ti, msb);
+
+	for (int i = 0; i < msb; i++) {
+		ti->buf[i] = ((uint64_t)rand() << 32) | rand();
+		ti->buf[i] &= ~_tt_word_top_bit;
+	}
+	if (ti->buf[msb-1] == 0)
+		ti->buf[msb-1] = 1;
+	ti->msb = msb;
+}
+
+static void run_add(void *arg)
+{
+	struct int_arg *ia = arg;
+	tt_int_add(ia->r, ia->a, ia->b);
+}
+
+static void run_sub(void *arg)
+{
+	struct int_arg *ia = arg;
+	tt_int_sub(ia->r, ia->a, ia->b);
+}
+
+static void run_mul(void *arg)
+{
+	struct int_arg *ia = arg;
+	tt_int_mul(ia->r, ia->a, ia->b);
+}
+
+static void run_sqr(void *arg)
+{
+	struct int_arg *ia = arg;
+	tt_int_mul(ia->r, ia->a, ia->a);
+}
+
+static void run_addmul(void *arg)
+{
+	struct int_arg *ia = arg;
+	tt_int_addmul(ia->r, ia->a, ia->b);
+}
+
+/* a: 2n words, b: n words */
+static void run_div(void *arg)
+{
+	struct int_arg *ia = arg;
+	tt_int_div(ia->q, ia->r, ia->a, ia->b);
+}
+
+/* a = q * b */
+static void run_divexact(void *arg)
+{
+	struct int_arg *ia = arg;
+	tt_int_divexact(ia->r, ia->a, ia->b);
+}
+
+static void run_and(void *arg)
+{
+	struct int_arg *ia = arg;
+	tt_int_and(ia->r, ia->a, ia->b);
+}
+
+static void run_or(void *arg)
+{
+	struct int_arg *ia = arg;
+	tt_int_or(ia->r, ia->a, ia->b);
+}
+
+static void run_xor(void *arg)
+{
+	struct int_arg *ia = arg;
+	tt_int_xor(ia->r, ia->a, ia->b);
+}
+
+static void run_not(void *arg)
+{
+	struct int_arg *ia = arg;
+	tt_int_not(ia->r, ia->a);
+}
+
+static void run_popcount(void *arg)
+{
+	struct int_arg *ia = arg;
+	tt_int_popcount(ia->a);
+}
+
+static void run_cmp(void *arg)
+{
+	struct int_arg *ia = arg;
+	tt_int_cmp(ia->a, ia->b);
+}
+
+/* Shift r in place, restored from a before each run */
+static void run_shift(void *arg)
+{
+	struct int_arg *ia = arg;
+	tt_int_shift(ia->r, 100);
+}
+
+static void reset_shift(void *arg)
+{
+	struct int_arg *ia = arg;
+	_tt_int_copy(ia->r, ia->a);
+}
+
+/* b: one word, n: exponent */
+static void run_pow(void *arg)
+{
+	struct int_arg *ia = arg;
+	tt_int_pow(ia->r, ia->b, ia->n);
+}
+
+static void run_sqrt(void *arg)
+{
+	struct int_arg *ia = arg;
+	tt_int_sqrt(ia->r, ia->a);
+}
+
+static void run_root(void *arg)
+{
+	struct int_arg *ia = arg;
+	tt_int_root(ia->r, ia->a, 3);
+}
+
+static void run_gcd(void *arg)
+{
+	struct int_arg *ia = arg;
+	tt_int_gcd(ia->r, ia->a, ia->b);
+}
+
+static void run_to_string(void *arg)
+{
+	struct int_arg *ia = arg;
+	char *s = NULL;
+
+	if (tt_int_to_string(ia->a, &s, 10) == 0)
+		free(s);
+}
+
+static void run_from_string(void *arg)
+{
+	struct int_arg *ia = arg;
+	tt_int_from_string(ia->r, ia->str);
+}
+
+/* Big endian bytes */
+static void run_export(void *arg)
+{
+	struct int_arg *ia = arg;
+	size_t count = ia->len;
+
+	tt_int_export(ia->a, ia->buf, &count, 1, 1, 0, 0);
+}
+
+static void run_import(void *arg)
+{
+	struct int_arg *ia = arg;
+	tt_int_import(ia->r, ia->buf, ia->len, 1, 1, 0, 0);
+}
+
+/* a mod n moduli */
+static void run_mod_multi(void *arg)
+{
+	struct int_arg *ia = arg;
+	tt_int_mod_multi(ia->rems, ia->a, ia->mods, ia->n);
+}
+
+static void run_crt(void *arg)
+{
+	struct int_arg *ia = arg;
+	tt_int_crt(ia->r, ia->rems, ia->mods, ia->n);
+}
+
+static void run_factorial(void *arg)
+{
+	struct int_arg *ia = arg;
+	tt_int_factorial(ia->r, ia->n);
+}
+
+static void run_binomial(void *arg)
+{
+	struct int_arg *ia = arg;
+	tt_int_binomial(ia->r, ia->n * 2, ia->n);
+}
+
+static void run_primorial(void *arg)
+{
+	struct int_arg *ia = arg;
+	tt_int_primorial(ia->r, ia->n);
+}
+
+/* Consecutive primes from 2^30, fit one word of any build */
+static int gen_mods(struct int_arg *ia)
+{
+	uint64_t p = 1ULL << 30;
+
+	ia->mods = calloc(MODS_MAX, sizeof(struct tt_int *));
+	ia->rems = calloc(MODS_MAX, sizeof(struct tt_int *));
+	if (!ia->mods || !ia->rems)
+		return TT_ENOMEM;
+
+	for (int i = 0; i < MODS_MAX; i++) {
+		ia->mods[i] = tt_int_alloc();
+		ia->rems[i] = tt_int_alloc();
+		if (!ia->mods[i] || !ia->rems[i])
+			return TT_ENOMEM;
+		do {
+			tt_int_from_uint(ia->mods[i], ++p);
+		} while (!tt_int_isprime(ia->mods[i]));
+	}
+	return 0;
+}
+
+static void free_mods(struct int_arg *ia)
+{
+	for (int i = 0; i < MODS_MAX; i++) {
+		if (ia->mods && ia->mods[i])
+			tt_int_free(ia->mods[i]);
+		if (ia->rems && ia->rems[i])
+			tt_int_free(ia->rems[i]);
+	}
+	free(ia->mods);
+	free(ia->rems);
+}
+
+static const struct {
+	const char *name;
+	void (*run)(void *arg);
+	long max;	/* Max operand words */
+} int_ops[] = {
+	{ "add", run_add, 4096 },
+	{ "sub", run_sub, 4096 },
+	{ "mul", run_mul, 4096 },
+	{ "sqr", run_sqr, 4096 },
+	{ "addmul", run_addmul, 4096 },
+	{ "div", run_div, 4096 },
+	{ "divexact", run_divexact, 1024 },
+	{ "and", run_and, 4096 },
+	{ "or", run_or, 4096 },
+	{ "xor", run_xor, 4096 },
+	{ "not", run_not, 4096 },
+	{ "popcount", run_popcount, 4096 },
+	{ "cmp", run_cmp, 4096 },
+	{ "shift", run_shift, 4096 },
+	{ "pow", run_pow, 4096 },
+	{ "sqrt", run_sqrt, 1024 },
+	{ "root", run_root, 1024 },
+	{ "gcd", run_gcd, 1024 },
+	{ "to_string", run_to_string, 1024 },
+	{ "from_string", run_from_string, 1024 },
+	{ "export", run_export, 4096 },
+	{ "import", run_import, 4096 },
+	{ "mod_multi", run_mod_multi, MODS_MAX },
+	{ "crt", run_crt, MODS_MAX },
+};
+
+/* Products of n numbers */
+static const struct {
+	const char *name;
+	void (*run)(void *arg);
+} int_prods[] = {
+	{ "factorial", run_factorial },
+	{ "binomial", run_binomial },
+	{ "primorial", run_primorial },
+};
+
+/* Operand sizes in words */
+void bench_integer(void)
+{
+	struct int_arg ia = {
+		.r = tt_int_alloc(),
+		.q = tt_int_alloc(),
+		.a = tt_int_alloc(),
+		.b = tt_int_alloc(),
+	};
+	struct bench_op op = {
+		.suite = "integer",
+		.arg = &ia,
+	};
+
+	if (gen_mods(&ia))
+		goto out;
+
+	for (int i = 0; i < ARRAY_SIZE(int_ops); i++) {
+		op.name = int_ops[i].name;
+		op.run = int_ops[i].run;
+		op.reset = op.run == run_shift ? reset_shift : NULL;
+
+		for (long n = 1; n <= bench_max(int_ops[i].max); n *= 4) {
+			rand_int(ia.a, n);
+			rand_int(ia.b, n);
+
+			if (op.run == run_div) {
+				rand_int(ia.a, n * 2);
+			} else if (op.run == run_divexact) {
+				rand_int(ia.q, n);
+				tt_int_mul(ia.a, ia.q, ia.b);
+			} else if (op.run == run_addmul) {
+				rand_int(ia.r, n * 2);
+			} else if (op.run == run_from_string) {
+				tt_int_to_string(ia.a, &ia.str, 10);
+			} else if (op.run == run_pow) {
+				/* Power of n words */
+				rand_int(ia.b, 1);
+				ia.n = n;
+			} else if (op.run == run_export ||
+					op.run == run_import) {
+				ia.len = n * sizeof(uint64_t);
+				ia.buf = malloc(ia.len);
+				if (!ia.buf)
+					break;
+				tt_int_export(ia.a, ia.buf, &ia.len,
+						1, 1, 0, 0);
+			} else if (op.run == run_mod_multi) {
+				ia.n = n;
+			} else if (op.run == run_crt) {
+				for (int j = 0; j < n; j++)
+					tt_int_from_uint(ia.rems[j], rand());
+				ia.n = n;
+			}
+
+			op.size = n;
+			bench_run(&op);
+
+			free(ia.str);
+			ia.str = NULL;
+			free(ia.buf);
+			ia.buf = NULL;
+		}
+	}
+
+	op.reset = NULL;
+	for (int i = 0; i < ARRAY_SIZE(int_prods); i++) {
+		op.name = int_prods[i].name;
+		op.run = int_prods[i].run;
+
+		for (long n = 100; n <= bench_max(100000); n *= 10) {
+			ia.n = n;
+			op.size = n;
+			bench_run(&op);
+		}
+	}
+
+out:
+	free_mods(&ia);
+	tt_int_free(ia.r);
+	tt_int_free(ia.q);
+	tt_int_free(ia.a);
+	tt_int_free(ia.b);
+}
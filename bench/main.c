@@ -0,0 +1,109 @@
+/* Benchmark suite
+ *
+ * Usage: bench [-f text|csv|json] [-o file] [-n samples] [-q] [suite...]
+ * - run all suites if none is given
+ *
+ * Copyright (C) 2016 Yibo Cai
+ */
+#include <tt/tt.h>
+#include <common/lib.h>
+#include "bench.h"
+
+#include <string.h>
+#include <getopt.h>
+
+static const struct {
+	const char *name;
+	void (*run)(void);
+} suites[] = {
+	{ "integer", bench_integer },
+	{ "decimal", bench_decimal },
+	{ "fft", bench_fft },
+	{ "matrix", bench_matrix },
+	{ "sort", bench_sort },
+	{ "container", bench_container },
+};
+
+static void usage(void)
+{
+	fprintf(stderr, "Usage: bench [-f text|csv|json] [-o file] "
+			"[-n samples] [-q] [suite...]\nSuites:");
+	for (int i = 0; i < ARRAY_SIZE(suites); i++)
+		fprintf(stderr, " %s", suites[i].name);
+	fprintf(stderr, "\n");
+}
+
+int main(int argc, char **argv)
+{
+	int opt;
+
+	bench_cfg.out = stdout;
+	while ((opt = getopt(argc, argv, "f:o:n:qh")) != -1) {
+		switch (opt) {
+		case 'f':
+			if (strcmp(optarg, "csv") == 0)
+				bench_cfg.fmt = BENCH_FMT_CSV;
+			else if (strcmp(optarg, "json") == 0)
+				bench_cfg.fmt = BENCH_FMT_JSON;
+			else if (strcmp(optarg, "text") == 0)
+				bench_cfg.fmt = BENCH_FMT_TEXT;
+			else
+				goto err;
+			break;
+		case 'o':
+			bench_cfg.out = fopen(optarg, "w");
+			if (bench_cfg.out == NULL) {
+				tt_error("Cannot open %s", optarg);
+				return 1;
+			}
+			break;
+		case 'n':
+			if (_tt_atoi(optarg, &bench_cfg.samples) ||
+					bench_cfg.samples <= 0)
+				goto err;
+			break;
+		case 'q':
+			bench_cfg.quick = 1;
+			bench_cfg.samples = 5;
+			bench_cfg.warmup_ns = 2e6;
+			bench_cfg.sample_ns = 2e5;
+			break;
+		default:
+			goto err;
+		}
+	}
+
+	/* Check suite names */
+	for (int i = optind; i < argc; i++) {
+		int j;
+		for (j = 0; j < ARRAY_SIZE(suites); j++)
+			if (strcmp(argv[i], suites[j].name) == 0)
+				break;
+		if (j == ARRAY_SIZE(suites)) {
+			tt_error("Unknown suite: %s", argv[i]);
+			goto err;
+		}
+	}
+
+	tt_log_set_level(TT_LOG_WARN);
+	srand(1);
+
+	bench_begin();
+	for (int j = 0; j < ARRAY_SIZE(suites); j++) {
+		bool run = optind == argc;
+		for (int i = optind; i < argc; i++)
+			if (strcmp(argv[i], suites[j].name) == 0)
+				run = true;
+		if (run)
+			suites[j].run();
+	}
+	bench_end();
+
+	if (bench_cfg.out != stdout)
+		fclose(bench_cfg.out);
+	return 0;
+
+err:
+	usage();
+	return 1;
+}
@@ -0,0 +1,167 @@
+/* Benchmark FFT, DFT and matrix
+ *
+ * Copyright (C) 2016 Yibo Cai
+ */
+#include <tt/tt.h>
+#include <tt/num/dft.h>
+#include <tt/num/matrix.h>
+#include <common/lib.h>
+#include "bench.h"
+
+#include <string.h>
+
+struct fft_arg {
+	double (*in)[2], (*out)[2];
+	double *real;
+	uint n;
+};
+
+static void run_fft(void *arg)
+{
+	struct fft_arg *fa = arg;
+	tt_fft(fa->out, fa->in, fa->n);
+}
+
+static void run_ifft(void *arg)
+{
+	struct fft_arg *fa = arg;
+	tt_ifft(fa->out, fa->in, fa->n);
+}
+
+static void run_fft_real(void *arg)
+{
+	struct fft_arg *fa = arg;
+	tt_fft_real(fa->out, fa->real, fa->n);
+}
+
+static void run_dft(void *arg)
+{
+	struct fft_arg *fa = arg;
+	tt_dft(fa->out, fa->in, fa->n);
+}
+
+static const struct {
+	const char *name;
+	void (*run)(void *arg);
+	long max;
+} fft_ops[] = {
+	{ "fft", run_fft, 1 << 20 },
+	{ "ifft", run_ifft, 1 << 20 },
+	{ "fft_real", run_fft_real, 1 << 20 },
+	{ "dft", run_dft, 1 << 10 },
+};
+
+/* Transform points */
+void bench_fft(void)
+{
+	const long max = bench_max(1 << 20);
+	struct fft_arg fa = {
+		.in = malloc(max * sizeof(*fa.in)),
+		.out = malloc(max * sizeof(*fa.out)),
+		.real = malloc(max * sizeof(double)),
+	};
+	if (!fa.in || !fa.out || !fa.real)
+		goto out;
+
+	for (long i = 0; i < max; i++) {
+		fa.in[i][0] = fa.real[i] = rand() / (double)RAND_MAX;
+		fa.in[i][1] = rand() / (double)RAND_MAX;
+	}
+
+	struct bench_op op = {
+		.suite = "fft",
+		.arg = &fa,
+	};
+	for (int i = 0; i < ARRAY_SIZE(fft_ops); i++) {
+		op.name = fft_ops[i].name;
+		op.run = fft_ops[i].run;
+		for (long n = 64; n <= _tt_min(max, fft_ops[i].max); n *= 4) {
+			fa.n = n;
+			op.size = n;
+			bench_run(&op);
+		}
+	}
+
+out:
+	free(fa.in);
+	free(fa.out);
+	free(fa.real);
+}
+
+struct mtx_arg {
+	struct tt_mtx a, b, r, a0, b0;
+};
+
+static void run_mtx_mul(void *arg)
+{
+	struct mtx_arg *ma = arg;
+	tt_mtx_mul(&ma->r, &ma->a, &ma->b);
+}
+
+static void run_gaussj(void *arg)
+{
+	struct mtx_arg *ma = arg;
+	tt_mtx_gaussj(&ma->a, &ma->b);
+}
+
+/* Gauss-Jordan ruins input */
+static void reset_gaussj(void *arg)
+{
+	struct mtx_arg *ma = arg;
+	const int n = ma->a.rows;
+
+	memcpy(ma->a.v, ma->a0.v, n * n * sizeof(double));
+	memcpy(ma->b.v, ma->b0.v, n * sizeof(double));
+}
+
+static void mtx_init(struct tt_mtx *m, int rows, int cols)
+{
+	m->rows = rows;
+	m->cols = cols;
+	m->v = malloc(rows * cols * sizeof(double));
+	for (int i = 0; m->v && i < rows * cols; i++)
+		m->v[i] = rand() / (double)RAND_MAX;
+}
+
+/* Square matrix dimension */
+void bench_matrix(void)
+{
+	struct bench_op op = {
+		.suite = "matrix",
+	};
+
+	for (long n = 8; n <= bench_max(512); n *= 2) {
+		struct mtx_arg ma;
+		mtx_init(&ma.a, n, n);
+		mtx_init(&ma.b, n, n);
+		mtx_init(&ma.r, n, n);
+		mtx_init(&ma.a0, n, n);
+		mtx_init(&ma.b0, n, 1);
+		if (!ma.a.v || !ma.b.v || !ma.r.v || !ma.a0.v || !ma.b0.v)
+			goto next;
+
+		op.arg = &ma;
+		op.size = n;
+
+		op.name = "mul";
+		op.run = run_mtx_mul;
+		op.reset = NULL;
+		bench_run(&op);
+
+		/* Solve a.x = b, b is a column vector */
+		ma.b.cols = 1;
+		for (int i = 0; i < n; i++)
+			ma.a0.v[i*n+i] += n;	/* Well conditioned */
+		op.name = "gaussj";
+		op.run = run_gaussj;
+		op.reset = reset_gaussj;
+		bench_run(&op);
+
+next:
+		free(ma.a.v);
+		free(ma.b.v);
+		free(ma.r.v);
+		free(ma.a0.v);
+		free(ma.b0.v);
+	}
+}
@@ -21,8 +21,26 @@
  */
 #define CONFIG_DEBUG_LEVEL	2
 
+/* Per-operation performance counters, see tt/common/stats.h
+ * - enabled by "make STATS=1"
+ */
+#ifndef CONFIG_STATS
+#define CONFIG_STATS		0
+#endif
+
 /* APN decimal significand length */
 #define CONFIG_DEC_DIGITS	60		/* 28B */
 #define CONFIG_DEC_DIGITS_MAX	100000000	/* 42MB */
 
+/* APN decimal significand word: 0 - 9 digits in uint32, 1 - 19 digits in
+ * uint64 (requires 128-bit integer)
+ */
+#ifndef CONFIG_DEC_DIG64
+#ifdef __SIZEOF_INT128__
+#define CONFIG_DEC_DIG64	1
+#else
+#define CONFIG_DEC_DIG64	0
+#endif
+#endif
+
 #endif	/* HAVE_TT_CONFIG_H */
@@ -11,14 +11,45 @@ void tt_dec_free(struct tt_dec *dec);
 
 /* Conversion */
 int tt_dec_from_string(struct tt_dec *dec, const char *str);
+/* Parse exactly len chars, str needs no NUL terminator */
+int tt_dec_from_strn(struct tt_dec *dec, const char *str, size_t len);
 int tt_dec_from_sint(struct tt_dec *dec, int64_t num);
 int tt_dec_from_uint(struct tt_dec *dec, uint64_t num);
 int tt_dec_from_float(struct tt_dec *dec, double num);
 int tt_dec_to_string(const struct tt_dec *dec, char *str, uint len);
+
+/* Incremental parsing of long text
+ * - feed chunks of any size, finish returns same result as from_string
+ * - digits go straight to significand of dec, dec is zeroed on alloc
+ * - trailing white space is allowed, as at end of file
+ */
+struct tt_dec_parser;
+struct tt_dec_parser *tt_dec_parser_alloc(struct tt_dec *dec);
+void tt_dec_parser_free(struct tt_dec_parser *ps);
+int tt_dec_parser_feed(struct tt_dec_parser *ps, const char *buf, size_t len);
+int tt_dec_parser_finish(struct tt_dec_parser *ps);
+int tt_dec_from_fd(struct tt_dec *dec, int fd);
 #ifdef __STDC_IEC_559__
 int tt_dec_to_float(const struct tt_dec *dec, double *num);
 #endif
 
+/* IEEE 754-2008 decimal interchange formats
+ * - BID: binary integer coefficient, DPD: densely packed decimal
+ * - buffer holds uint32_t, uint64_t, or uint64_t[2] (low half first) in
+ *   host byte order
+ * - 128-bit formats need compiler support of 128-bit integer
+ */
+enum {
+	TT_DEC_BID32,
+	TT_DEC_BID64,
+	TT_DEC_BID128,
+	TT_DEC_DPD32,
+	TT_DEC_DPD64,
+	TT_DEC_DPD128,
+};
+int tt_dec_to_ieee(const struct tt_dec *dec, void *buf, int fmt);
+int tt_dec_from_ieee(struct tt_dec *dec, const void *buf, int fmt);
+
 /* Operations */
 int tt_dec_add(struct tt_dec *dst, const struct tt_dec *src1,
 		const struct tt_dec *src2);
@@ -29,6 +60,87 @@ int tt_dec_mul(struct tt_dec *dst, const struct tt_dec *src1,
 int tt_dec_div(struct tt_dec *dst, const struct tt_dec *src1,
 		const struct tt_dec *src2);
 
+/* Fused sums, terms are added exactly and rounded once to precision of dst
+ * - dot: dst = a[0] * b[0] + ... + a[n-1] * b[n-1]
+ * - sum: dst = a[0] + ... + a[n-1]
+ * - dst may share any input, scratch of dst is reused by repeated calls
+ * - zero terms are skipped, exact result has smallest exponent of others
+ * - return 0 if exact, TT_APN_EROUNDED if rounded, or error code
+ */
+int tt_dec_dot(struct tt_dec *dst, struct tt_dec **a, struct tt_dec **b, int n);
+int tt_dec_sum(struct tt_dec *dst, struct tt_dec **a, int n);
+
+/* Quantization, dst may share src
+ * - quantize: dst = src with exponent exp, digits dropped are rounded by
+ *   method rnd (TT_ROUND_*, 0 means current method of calling thread)
+ * - rescale: quantize to exponent of ref
+ * - reduce: strip trailing zeros, round to precision of dst if longer,
+ *   Inf is kept
+ * - zero result has exponent at most 0
+ * - return 0 if exact, TT_APN_EROUNDED if rounded, TT_APN_EINVAL and NaN
+ *   stored if result does not fit precision of dst, or src is NaN or
+ *   quantized Inf
+ * - no memory allocated
+ */
+int tt_dec_quantize(struct tt_dec *dst, const struct tt_dec *src, int exp,
+		int rnd);
+int tt_dec_rescale(struct tt_dec *dst, const struct tt_dec *src,
+		const struct tt_dec *ref, int rnd);
+int tt_dec_reduce(struct tt_dec *dst, const struct tt_dec *src);
+
+/* Elementary functions, correctly rounded to precision of dst
+ * - return 0 if exact, TT_APN_EROUNDED if rounded, or error code
+ */
+int tt_dec_sqrt(struct tt_dec *dst, const struct tt_dec *src);
+int tt_dec_exp(struct tt_dec *dst, const struct tt_dec *src);
+int tt_dec_ln(struct tt_dec *dst, const struct tt_dec *src);
+int tt_dec_log10(struct tt_dec *dst, const struct tt_dec *src);
+int tt_dec_pow(struct tt_dec *dst, const struct tt_dec *base,
+		const struct tt_dec *exp);
+
+/* Constants, correctly rounded to precision of dec
+ * - computed values are cached, requests of lower precision are cheap
+ * - return TT_APN_EROUNDED or error code
+ */
+int tt_dec_pi(struct tt_dec *dec);
+int tt_dec_e(struct tt_dec *dec);
+int tt_dec_ln2(struct tt_dec *dec);
+
+/* Operations with context
+ * - prec: maximum digits of result, 0 or above destination precision means
+ *   destination precision, operands may be wider, exact result is rounded
+ *   once
+ * - rounding: TT_ROUND_*, 0 means current method of calling thread
+ * - traps: conditions returned as error, untrapped ones return 0 and leave
+ *   rounded result, Inf or NaN in destination
+ * - flags: conditions met, sticky till cleared by caller
+ * - NULL ctx: context of calling thread, tt_dec_ctx()
+ * - operations without context trap everything, use destination precision
+ *   and rounding method of calling thread
+ */
+enum {
+	TT_DEC_F_ROUNDED = 1,		/* TT_APN_EROUNDED */
+	TT_DEC_F_OVERFLOW = 2,		/* TT_APN_EOVERFLOW */
+	TT_DEC_F_DIV_0 = 4,		/* TT_APN_EDIV_0 */
+	TT_DEC_F_INVALID = 8,		/* TT_APN_EINVAL, TT_APN_EDIV_UNDEF */
+	TT_DEC_F_ALL = 15,
+};
+struct tt_dec_ctx {
+	uint prec;
+	uint rounding;
+	uint traps;
+	uint flags;
+};
+struct tt_dec_ctx *tt_dec_ctx(void);
+int tt_dec_add_ctx(struct tt_dec *dst, const struct tt_dec *src1,
+		const struct tt_dec *src2, struct tt_dec_ctx *ctx);
+int tt_dec_sub_ctx(struct tt_dec *dst, const struct tt_dec *src1,
+		const struct tt_dec *src2, struct tt_dec_ctx *ctx);
+int tt_dec_mul_ctx(struct tt_dec *dst, const struct tt_dec *src1,
+		const struct tt_dec *src2, struct tt_dec_ctx *ctx);
+int tt_dec_div_ctx(struct tt_dec *dst, const struct tt_dec *src1,
+		const struct tt_dec *src2, struct tt_dec_ctx *ctx);
+
 /* Logical */
 int tt_dec_cmp(const struct tt_dec *src1, const struct tt_dec *src2);
 int tt_dec_cmp_abs(const struct tt_dec *src1, const struct tt_dec *src2);
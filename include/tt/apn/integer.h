@@ -14,6 +14,10 @@ int tt_int_from_string(struct tt_int *ti, const char *str);
 int tt_int_from_sint(struct tt_int *ti, int64_t num);
 int tt_int_from_uint(struct tt_int *ti, uint64_t num);
 int tt_int_to_string(const struct tt_int *ti, char **str, int radix);
+int tt_int_import(struct tt_int *ti, const void *data, size_t count,
+		int order, size_t size, int endian, size_t nails);
+int tt_int_export(const struct tt_int *ti, void *data, size_t *count,
+		int order, size_t size, int endian, size_t nails);
 
 /* Operations */
 int tt_int_add(struct tt_int *dst, const struct tt_int *src1,
@@ -24,14 +28,48 @@ int tt_int_mul(struct tt_int *dst, const struct tt_int *src1,
 		const struct tt_int *src2);
 int tt_int_div(struct tt_int *quo, struct tt_int *rem,
 		const struct tt_int *src1, const struct tt_int *src2);
+int tt_int_divexact(struct tt_int *quo, const struct tt_int *src1,
+		const struct tt_int *src2);
 int tt_int_shift(struct tt_int *ti, int shift);
+int tt_int_addmul(struct tt_int *dst, const struct tt_int *src1,
+		const struct tt_int *src2);
+int tt_int_submul(struct tt_int *dst, const struct tt_int *src1,
+		const struct tt_int *src2);
+int tt_int_mul_ui(struct tt_int *dst, const struct tt_int *src, uint64_t num);
+int tt_int_addmul_ui(struct tt_int *dst, const struct tt_int *src,
+		uint64_t num);
+int tt_int_div_ui(struct tt_int *quo, uint64_t *rem,
+		const struct tt_int *src, uint64_t num);
 
 /* Logical */
 int tt_int_cmp(const struct tt_int *src1, const struct tt_int *src2);
 int tt_int_cmp_abs(const struct tt_int *src1, const struct tt_int *src2);
+bool tt_int_isdivisible(const struct tt_int *src1, const struct tt_int *src2);
+
+/* Bitwise (two's complement semantics) */
+int tt_int_and(struct tt_int *dst, const struct tt_int *src1,
+		const struct tt_int *src2);
+int tt_int_or(struct tt_int *dst, const struct tt_int *src1,
+		const struct tt_int *src2);
+int tt_int_xor(struct tt_int *dst, const struct tt_int *src1,
+		const struct tt_int *src2);
+int tt_int_not(struct tt_int *dst, const struct tt_int *src);
+int tt_int_test_bit(const struct tt_int *ti, int bit);
+int tt_int_set_bit(struct tt_int *ti, int bit);
+int tt_int_clr_bit(struct tt_int *ti, int bit);
+int tt_int_flip_bit(struct tt_int *ti, int bit);
+int tt_int_popcount(const struct tt_int *ti);
+int tt_int_scan0(const struct tt_int *ti, int start);
+int tt_int_scan1(const struct tt_int *ti, int start);
+int tt_int_ctz(const struct tt_int *ti);
 
 /* Math */
 int tt_int_factorial(struct tt_int *ti, const int n);
+int tt_int_binomial(struct tt_int *ti, uint n, uint k);
+int tt_int_primorial(struct tt_int *ti, uint n);
+int tt_int_pow(struct tt_int *ti, const struct tt_int *base, uint exp);
+int tt_int_sqrt(struct tt_int *root, const struct tt_int *ti);
+int tt_int_root(struct tt_int *root, const struct tt_int *ti, uint n);
 
 /* Number theory */
 int tt_int_gcd(struct tt_int *g,
@@ -40,4 +78,8 @@ int tt_int_extgcd(struct tt_int *g, struct tt_int *u, struct tt_int *v,
 		const struct tt_int *a, const struct tt_int *b);
 int tt_int_mod_inv(struct tt_int *m,
 		const struct tt_int *a, const struct tt_int *b);
+int tt_int_mod_multi(struct tt_int **rem, const struct tt_int *ti,
+		struct tt_int **mods, int n);
+int tt_int_crt(struct tt_int *x, struct tt_int **rems,
+		struct tt_int **mods, int n);
 bool tt_int_isprime(const struct tt_int *ti);
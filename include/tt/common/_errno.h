@@ -13,6 +13,8 @@
 #define TT_EUNDERFLOW		-4	/* Buffer underflow */
 #define TT_ESTOP		 5	/* Stop operation */
 #define TT_ENOBUFS		-6	/* Buffer too small */
+#define TT_ENOTSUP		-7	/* Not supported */
+#define TT_EIO			-8	/* I/O error */
 
 /* Numerical */
 #define TT_NUM_ESINGULAR	-101	/* Singular matrix */
@@ -13,6 +13,7 @@ enum {
 	TT_LOG_TARGET_STDERR,
 	TT_LOG_TARGET_FD,
 	TT_LOG_TARGET_NULL,
+	TT_LOG_TARGET_TRACE,	/* Per-thread binary ring, see tt_log_dump() */
 
 	TT_LOG_TARGET_MAX,
 };
@@ -32,12 +33,28 @@ int tt_log_set_level(int level);
 
 void tt_log_set_fd(int fd);
 
-void tt_log(int level, const char *func, const char *format, ...);
+/* Format and write out trace records, oldest first, records are consumed
+ * - call it when no other threads are logging
+ * - return 0, or TT_EIO if writing fd fails
+ */
+int tt_log_dump(int fd);
+
+void tt_log(int level, const char *func, const char *format, ...)
+	__attribute__ ((format(printf, 3, 4)));
 
 #define __unlikely(x)	(__builtin_expect(!!(x), 0))
 
-#define tt_warn(...)	tt_log(TT_LOG_WARN, __func__, __VA_ARGS__)
-#define tt_error(...)	tt_log(TT_LOG_ERROR, __func__, __VA_ARGS__)
+/* Current level, checked inline so filtered messages cost one compare */
+extern int _tt_log_level;
+
+#define _tt_log(level, ...)					\
+	do {							\
+		if (__unlikely((level) <= _tt_log_level))	\
+			tt_log(level, __func__, __VA_ARGS__);	\
+	} while (0)
+
+#define tt_warn(...)	_tt_log(TT_LOG_WARN, __VA_ARGS__)
+#define tt_error(...)	_tt_log(TT_LOG_ERROR, __VA_ARGS__)
 
 #if (CONFIG_DEBUG_LEVEL == 0)
 /* level = 0, all disabled */
@@ -55,7 +72,7 @@ void tt_log(int level, const char *func, const char *format, ...);
 			abort();				\
 		}						\
 	} while (0)
-#define tt_info(...)	tt_log(TT_LOG_INFO, __func__, __VA_ARGS__)
+#define tt_info(...)	_tt_log(TT_LOG_INFO, __VA_ARGS__)
 #if (CONFIG_DEBUG_LEVEL == 1)
 /* level = 1, assert_fa(), debug() disabled */
 #define tt_assert_fa(b)	do {} while (0)
@@ -63,6 +80,6 @@ void tt_log(int level, const char *func, const char *format, ...);
 #else
 /* level = 2, all enabled */
 #define tt_assert_fa(b)	tt_assert(b)
-#define tt_debug(...)	tt_log(TT_LOG_DEBUG, __func__, __VA_ARGS__)
+#define tt_debug(...)	_tt_log(TT_LOG_DEBUG, __VA_ARGS__)
 #endif
 #endif
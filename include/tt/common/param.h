@@ -0,0 +1,20 @@
+/* Tunable algorithm parameters
+ *
+ * Copyright (C) 2016 Yibo Cai
+ */
+#pragma once
+
+struct tt_param {
+	int kara_cross;		/* Karatsuba multiplication cross point */
+	int bindiv_cross;	/* Divide and conquer division cross point */
+	int dec9_cross_idx;	/* Integer to decimal conversion cross point */
+	int fft_wn_pts;		/* FFT twiddle factor table size, 2^n */
+	int dec_kara_cross;	/* Decimal Karatsuba cross point, in words */
+	int dec_ntt_cross;	/* Decimal NTT multiplication cross point */
+	int dec_newton_cross;	/* Decimal Newton division cross point */
+};
+
+/* Not thread safe, set parameters before any computation */
+void tt_param_get(struct tt_param *param);
+int tt_param_set(const struct tt_param *param);
+int tt_param_load(const char *file);
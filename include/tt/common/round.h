@@ -13,4 +13,5 @@ enum {
 	TT_ROUND_MAX,
 };
 
+/* Set rounding method of calling thread, 0 - default, return old method */
 int tt_set_rounding(uint rnd);
@@ -0,0 +1,106 @@
+/* Performance counters
+ *
+ * Built in only if CONFIG_STATS is set ("make STATS=1")
+ *
+ * Copyright (C) 2016 Yibo Cai
+ */
+#pragma once
+
+enum {
+	/* Integer */
+	TT_STAT_INT_ADD,
+	TT_STAT_INT_SUB,
+	TT_STAT_INT_MUL,
+	TT_STAT_INT_DIV,
+	TT_STAT_INT_DIVEXACT,
+	TT_STAT_INT_ADDMUL,
+	TT_STAT_INT_MUL_UI,
+	TT_STAT_INT_DIV_UI,
+	TT_STAT_INT_SHIFT,
+	TT_STAT_INT_LOGIC,
+	TT_STAT_INT_FROM_STRING,
+	TT_STAT_INT_TO_STRING,
+	TT_STAT_INT_IMPORT,
+	TT_STAT_INT_EXPORT,
+	TT_STAT_INT_POW,
+	TT_STAT_INT_ROOT,
+	TT_STAT_INT_FACTORIAL,
+	TT_STAT_INT_BINOMIAL,
+	TT_STAT_INT_PRIMORIAL,
+	TT_STAT_INT_GCD,
+	TT_STAT_INT_EXTGCD,
+	TT_STAT_INT_ISPRIME,
+	TT_STAT_INT_MOD_MULTI,
+	TT_STAT_INT_CRT,
+	TT_STAT_INT_ALLOC,		/* calls: allocations, bytes */
+
+	/* Integer algorithm tiers, calls only */
+	TT_STAT_INT_MUL_CLASSIC,
+	TT_STAT_INT_MUL_KARA,
+	TT_STAT_INT_DIV_CLASSIC,
+	TT_STAT_INT_DIV_BIN,
+
+	/* Decimal */
+	TT_STAT_DEC_ADD,
+	TT_STAT_DEC_SUB,
+	TT_STAT_DEC_MUL,
+	TT_STAT_DEC_DIV,
+	TT_STAT_DEC_CMP,
+	TT_STAT_DEC_FROM_STRING,
+	TT_STAT_DEC_TO_STRING,
+	TT_STAT_DEC_FROM_FLOAT,
+	TT_STAT_DEC_TO_FLOAT,
+	TT_STAT_DEC_SQRT,
+	TT_STAT_DEC_EXP,
+	TT_STAT_DEC_LN,
+	TT_STAT_DEC_LOG10,
+	TT_STAT_DEC_POW,
+	TT_STAT_DEC_CONST,
+	TT_STAT_DEC_QUANTIZE,
+	TT_STAT_DEC_REDUCE,
+	TT_STAT_DEC_DOT,
+	TT_STAT_DEC_SUM,
+	TT_STAT_DEC_ALLOC,		/* calls: allocations, bytes */
+
+	/* Decimal algorithm tiers, calls only */
+	TT_STAT_DEC_MUL_CLASSIC,
+	TT_STAT_DEC_MUL_KARA,
+	TT_STAT_DEC_MUL_NTT,
+	TT_STAT_DEC_DIV_CLASSIC,
+	TT_STAT_DEC_DIV_NEWTON,
+	TT_STAT_DEC_FAST,		/* 128-bit significand fast path */
+
+	/* Numerical */
+	TT_STAT_FFT,
+	TT_STAT_IFFT,
+	TT_STAT_FFT_REAL,
+	TT_STAT_FFT_TBL,		/* calls: lookup tables built, bytes */
+	TT_STAT_DFT,
+	TT_STAT_IDFT,
+	TT_STAT_DFT_REAL,
+	TT_STAT_MTX_MUL,
+	TT_STAT_MTX_GAUSSJ,
+
+	/* Common */
+	TT_STAT_SORT,
+
+	TT_STAT_MAX,
+};
+
+struct tt_stat {
+	uint64_t calls;
+	uint64_t cycles;	/* Including nested calls */
+	uint64_t bytes;
+};
+
+struct tt_stats {
+	struct tt_stat stat[TT_STAT_MAX];
+};
+
+/* Called on leaving each counted function */
+typedef void (*tt_stats_hook)(int id, uint64_t cycles, void *context);
+
+int tt_stats_snapshot(struct tt_stats *stats);
+void tt_stats_reset(void);
+void tt_stats_set_hook(tt_stats_hook hook, void *context);
+const char *tt_stats_name(int id);
@@ -4,53 +4,148 @@
  */
 #include <tt/tt.h>
 #include <tt/apn/decimal.h>
+#include <tt/common/param.h>
+#include <tt/common/round.h>
 #include <common/lib.h>
+#include <common/stats.h>
 #include "decimal.h"
 
 #include <string.h>
+#include <limits.h>
 
 #pragma GCC diagnostic ignored "-Wunused-variable"
 
-/* 10^n, n = 0 ~ 8 */
-static const uint one_tbl[] = {
+/* Cross points in words, tunable at runtime */
+#define KARA_CROSS	(_tt_param.dec_kara_cross)
+#define NTT_CROSS	(_tt_param.dec_ntt_cross)
+#define NEWTON_CROSS	(_tt_param.dec_newton_cross)
+
+/* 10^n, n = 0 ~ _TT_DEC_DIGS-1 */
+static const _tt_dec_word one_tbl[] = {
 	1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000,
+#if CONFIG_DEC_DIG64
+	1000000000ULL, 10000000000ULL, 100000000000ULL, 1000000000000ULL,
+	10000000000000ULL, 100000000000000ULL, 1000000000000000ULL,
+	10000000000000000ULL, 100000000000000000ULL, 1000000000000000000ULL,
+#endif
 };
 
-/* Get MSB of dig[0] ~ dig[uints-1] */
-static int get_msb(const uint *dig, const int uints)
+/* floor(2^bits / 10^n), bits = word bits, n = 1 ~ _TT_DEC_DIGS-1 */
+static const _tt_dec_word inv_tbl[] = {
+#if CONFIG_DEC_DIG64
+	0, 1844674407370955161ULL, 184467440737095516ULL,
+	18446744073709551ULL, 1844674407370955ULL, 184467440737095ULL,
+	18446744073709ULL, 1844674407370ULL, 184467440737ULL,
+	18446744073ULL, 1844674407ULL, 184467440ULL, 18446744ULL, 1844674ULL,
+	184467ULL, 18446ULL, 1844ULL, 184ULL, 18ULL,
+#else
+	0, 429496729, 42949672, 4294967, 429496, 42949, 4294, 429, 42,
+#endif
+};
+
+/* Split dig by 10^n without hardware divide
+ * - n = 1 ~ _TT_DEC_DIGS-1
+ * - estimated quotient is at most 1 less than exact value
+ * - return dig % 10^n, *q = dig / 10^n
+ */
+static inline _tt_dec_word divmod_pow10(_tt_dec_word dig, int n,
+		_tt_dec_word *q)
+{
+	const _tt_dec_word d = one_tbl[n];
+	_tt_dec_word qt = ((_tt_dec_dword)dig * inv_tbl[n]) >>
+		(_tt_dec_word_sz * 8);
+	_tt_dec_word r = dig - qt * d;
+
+	if (r >= d) {
+		qt++;
+		r -= d;
+	}
+	*q = qt;
+	return r;
+}
+
+/* Digits in a non-zero word */
+static inline int word_digs(_tt_dec_word w)
 {
-	int msb = 1;
+	int n = 0;
 
-	for (int i = uints - 1; i >= 0; i--) {
-		uint u = dig[i];
-		if (u) {
-			msb = i * 9;
-			do {
-				msb++;
-				u /= 10;
-			} while (u);
+	do {
+		n++;
+		w /= 10;
+	} while (w);
 
-			break;
-		}
+	return n;
+}
+
+/* Get MSB of dig[0] ~ dig[words-1] */
+static int get_msb(const _tt_dec_word *dig, const int words)
+{
+	for (int i = words - 1; i >= 0; i--)
+		if (dig[i])
+			return i * _TT_DEC_DIGS + word_digs(dig[i]);
+
+	return 1;
+}
+
+/* Split double word t < _TT_DEC_BASE^2 to quotient and remainder of base
+ * - quotient fits in one word: x86_64 issues a single divq instead of
+ *   calling __udivti3
+ * - other 64-bit targets lack 128/64 division, 10^19 is normalized (top
+ *   bit set) so multiply by a pre-computed inverse instead (Moller,
+ *   Granlund: Improved division by invariant integers, algorithm 4)
+ * - return t % _TT_DEC_BASE, *hi = t / _TT_DEC_BASE
+ */
+static inline _tt_dec_word divmod_base(_tt_dec_dword t, _tt_dec_word *hi)
+{
+#if CONFIG_DEC_DIG64 && defined(__x86_64__)
+	uint64_t q, r;
+	__asm__("divq %4" : "=a" (q), "=d" (r)
+			: "a" ((uint64_t)t), "d" ((uint64_t)(t >> 64)),
+			"r" ((uint64_t)_TT_DEC_BASE));
+	*hi = q;
+	return r;
+#elif CONFIG_DEC_DIG64
+	/* floor((2^128 - 1) / 10^19) - 2^64 */
+	const uint64_t v = 15581492618384294730ULL;
+	const uint64_t u1 = t >> 64, u0 = t;
+
+	const __uint128_t p = (__uint128_t)v * u1 + t;
+	uint64_t q1 = (p >> 64) + 1, q0 = p;
+	uint64_t r = u0 - q1 * _TT_DEC_BASE;
+	if (r > q0) {
+		q1--;
+		r += _TT_DEC_BASE;
+	}
+	if (_tt_unlikely(r >= _TT_DEC_BASE)) {
+		q1++;
+		r -= _TT_DEC_BASE;
 	}
 
-	return msb;
+	*hi = q1;
+	return r;
+#else
+	*hi = t / _TT_DEC_BASE;
+	return t % _TT_DEC_BASE;
+#endif
 }
 
-/* Add two uint(9 digit decimals)
+/* Add two words
  * - carry: input: 0, 1
- * - carry: output: 1 => sum > 999,999,999
+ * - carry: output: 1 => sum >= _TT_DEC_BASE
  * return adjust digit
  */
-static uint add_dig(uint dig, uint dig2, char *carry)
+static inline _tt_dec_word add_dig(_tt_dec_word dig, _tt_dec_word dig2,
+		char *carry)
 {
-	dig += (dig2 + *carry);
+	/* Compare against base - dig2, dig + dig2 may exceed word range */
+	const _tt_dec_word room = _TT_DEC_BASE - dig2;
 
-	/* Check overflow */
-	if (dig >= 1000000000) {
-		dig -= 1000000000;
+	dig += *carry;
+	if (dig >= room) {
+		dig -= room;
 		*carry = 1;
 	} else {
+		dig += dig2;
 		*carry = 0;
 	}
 
@@ -62,21 +157,22 @@ static uint add_dig(uint dig, uint dig2, char *carry)
  * - dig must have enough space to hold result(include possible carry)
  * - return result digit length
  */
-static int add_digs(uint *dig, const int msb, const uint *dig2, const int msb2)
+static int add_digs(_tt_dec_word *dig, const int msb,
+		const _tt_dec_word *dig2, const int msb2)
 {
 	int i;
 	char carry = 0;
 
 	/* Add dig2 to dig */
-	const int uints2 = (msb2 + 8) / 9;
-	for (i = 0; i < uints2; i++)
+	const int words2 = _tt_dec_words(msb2);
+	for (i = 0; i < words2; i++)
 		dig[i] = add_dig(dig[i], dig2[i], &carry);
 
 	/* Process remaining high digits in dig */
-	const int uints = (msb + 8) / 9;
-	for (; i < uints; i++) {
+	const int words = _tt_dec_words(msb);
+	for (; i < words; i++) {
 		if (carry == 0) {
-			i = uints;
+			i = words;
 			break;
 		}
 		dig[i] = add_dig(dig[i], 0, &carry);
@@ -84,18 +180,13 @@ static int add_digs(uint *dig, const int msb, const uint *dig2, const int msb2)
 
 	/* Check new MSB */
 	if (carry) {
-		/* Carry at uint boundary */
+		/* Carry at word boundary */
 		dig[i] = 1;
 		return _tt_max(msb, msb2) + 1;
 	} else {
-		/* Get new msb, i => valid uints */
+		/* Get new msb, i => valid words */
 		tt_assert_fa(i > 0);
-		uint u = dig[i-1];
-		int msbr = (i - 1) * 9;
-		do {
-			msbr++;
-			u /= 10;
-		} while (u);
+		int msbr = (i - 1) * _TT_DEC_DIGS + word_digs(dig[i-1]);
 
 		const int msbs = _tt_max(msb, msb2);
 		tt_assert_fa(msbr == msbs || msbr == (msbs+1));
@@ -103,22 +194,25 @@ static int add_digs(uint *dig, const int msb, const uint *dig2, const int msb2)
 	}
 }
 
-/* Sub two uint(9 digit decimals)
+/* Sub two words
  * - carry: input: 0, 1
  * - carry: output: 1 => sub < 0
  * return adjust digit
  */
-static uint sub_dig(uint dig, uint dig2, char *carry)
+static inline _tt_dec_word sub_dig(_tt_dec_word dig, _tt_dec_word dig2,
+		char *carry)
 {
-	int sub = dig - dig2 - *carry;
-	if (sub < 0) {
-		sub += 1000000000;
+	/* dig2 + carry <= _TT_DEC_BASE, no overflow */
+	dig2 += *carry;
+	if (dig < dig2) {
+		dig += _TT_DEC_BASE - dig2;
 		*carry = 1;
 	} else {
+		dig -= dig2;
 		*carry = 0;
 	}
 
-	return sub;
+	return dig;
 }
 
 /* dig = dig1 - dig2
@@ -129,8 +223,8 @@ static uint sub_dig(uint dig, uint dig2, char *carry)
  * - dig must be zeroed if not shared with dig1 or dig2
  * - return result digit length
  */
-static int sub_digs(uint *dig, const uint *dig1, const int msb1,
-		const uint *dig2, const int msb2)
+static int sub_digs(_tt_dec_word *dig, const _tt_dec_word *dig1, const int msb1,
+		const _tt_dec_word *dig2, const int msb2)
 {
 	tt_assert_fa(msb1 >= msb2);
 
@@ -138,110 +232,470 @@ static int sub_digs(uint *dig, const uint *dig1, const int msb1,
 	char carry = 0;
 
 	/* dig1 - dig2 */
-	const int uints2 = (msb2 + 8) / 9;
-	for (i = 0; i < uints2; i++)
+	const int words2 = _tt_dec_words(msb2);
+	for (i = 0; i < words2; i++)
 		dig[i] = sub_dig(dig1[i], dig2[i], &carry);
 
 	/* Process remaining high digits in dig1 */
-	const int uints1 = (msb1 + 8) / 9;
-	for (; i < uints1; i++)
+	const int words1 = _tt_dec_words(msb1);
+	for (; i < words1; i++)
 		dig[i] = sub_dig(dig1[i], 0, &carry);
 	tt_assert_fa(carry == 0);
 
 	/* Check new MSB */
-	int msbr = get_msb(dig, uints1);
+	int msbr = get_msb(dig, words1);
 	tt_assert_fa((msbr <= msb1 || msb1 <= 0) && msbr >= 1);
 
 	return msbr;
 }
 
-/* *dig += ui * 10^(9*shift)
- * - ui in binary format
- * - *dig in decimal format
- * - shift: offset in uints, >= 0
- * - return MSB
+/* dig[0, words) += dig2[0, words2), words >= words2, return carry */
+static char add_words(_tt_dec_word *dig, int words,
+		const _tt_dec_word *dig2, int words2)
+{
+	int i;
+	char carry = 0;
+
+	for (i = 0; i < words2; i++)
+		dig[i] = add_dig(dig[i], dig2[i], &carry);
+	for (; i < words && carry; i++)
+		dig[i] = add_dig(dig[i], 0, &carry);
+
+	return carry;
+}
+
+/* dig[0, words) -= dig2[0, words2), words >= words2, return borrow */
+static char sub_words(_tt_dec_word *dig, int words,
+		const _tt_dec_word *dig2, int words2)
+{
+	int i;
+	char carry = 0;
+
+	for (i = 0; i < words2; i++)
+		dig[i] = sub_dig(dig[i], dig2[i], &carry);
+	for (; i < words && carry; i++)
+		dig[i] = sub_dig(dig[i], 0, &carry);
+
+	return carry;
+}
+
+/* digr += dig1 * dig2
+ * - digr: words1 + words2 words, high words1 words must be zero
  */
-#ifdef __SIZEOF_INT128__
-static inline int shift_add_u128(uint *dig, int msb, __uint128_t ui128,
-		int shift)
+static void mul_words_classic(_tt_dec_word *digr, const _tt_dec_word *dig1,
+		int words1, const _tt_dec_word *dig2, int words2)
 {
-	/* Convert *ui128 to decimal */
-	uint dec[5] = { 0, 0, 0, 0, 0 };
-	int msb2 = _tt_dec_uint128_to_dec(dec, ui128);
+	/* Row by row, t <= (base-1)^2 + 2*(base-1) < base^2 never overflows */
+	for (int i = 0; i < words1; i++) {
+		const _tt_dec_word d1 = dig1[i];
+		if (d1 == 0)
+			continue;
+
+		_tt_dec_word carry = 0;
+		_tt_dec_word *r = digr + i;
+		for (int j = 0; j < words2; j++) {
+			_tt_dec_dword t = (_tt_dec_dword)d1 * dig2[j] +
+				r[j] + carry;
+			r[j] = divmod_base(t, &carry);
+		}
+		r[words2] = carry;
+	}
+}
 
-	/* Add dec[] to &dig[shift] */
-	return add_digs(dig+shift, msb-shift*9, dec, msb2) + shift*9;
+/* Karatsuba multiplication
+ * - digr = dig1 * dig2, digr: words1 + words2 words, zeroed
+ * - words1 >= words2
+ * - workbuf: 6 * words1 + 256 words is enough
+ *
+ * dig1 = a1 * B^h + a0, dig2 = b1 * B^h + b0, B = _TT_DEC_BASE
+ * dig1 * dig2 = a1b1 * B^2h + ((a0+a1)(b0+b1) - a0b0 - a1b1) * B^h + a0b0
+ */
+static void mul_words_kara(_tt_dec_word *digr, const _tt_dec_word *dig1,
+		int words1, const _tt_dec_word *dig2, int words2,
+		_tt_dec_word *workbuf)
+{
+	if (words2 < KARA_CROSS) {
+		mul_words_classic(digr, dig1, words1, dig2, words2);
+		return;
+	}
+
+	const int h = (words1 + 1) / 2;
+	const int words = words1 + words2;
+
+	if (words2 <= h) {
+		/* Unbalanced, split dig1 into pieces of words2 words */
+		_tt_dec_word *t = workbuf;
+		workbuf += words2 * 2;
+		for (int i = 0; i < words1; i += words2) {
+			const int n = _tt_min(words2, words1 - i);
+			memset(t, 0, (n + words2) * _tt_dec_word_sz);
+			if (n == words2)
+				mul_words_kara(t, dig1 + i, n, dig2, words2,
+						workbuf);
+			else
+				mul_words_kara(t, dig2, words2, dig1 + i, n,
+						workbuf);
+			add_words(digr + i, words - i, t, n + words2);
+		}
+		return;
+	}
+
+	/* a0b0 -> digr[0, 2h), a1b1 -> digr[2h, words) */
+	const int words1h = words1 - h, words2h = words2 - h;
+	_tt_dec_word *sa = workbuf, *sb = sa + h + 1, *t = sb + h + 1;
+	workbuf = t + h * 2 + 2;
+
+	mul_words_kara(digr, dig1, h, dig2, h, workbuf);
+	mul_words_kara(digr + h * 2, dig1 + h, words1h, dig2 + h, words2h,
+			workbuf);
+
+	/* t = (a0+a1)(b0+b1) - a0b0 - a1b1 */
+	memcpy(sa, dig1, h * _tt_dec_word_sz);
+	sa[h] = add_words(sa, h, dig1 + h, words1h);
+	memcpy(sb, dig2, h * _tt_dec_word_sz);
+	sb[h] = add_words(sb, h, dig2 + h, words2h);
+	memset(t, 0, (h * 2 + 2) * _tt_dec_word_sz);
+	mul_words_kara(t, sa, h + 1, sb, h + 1, workbuf);
+	sub_words(t, h * 2 + 2, digr, h * 2);
+	sub_words(t, h * 2 + 2, digr + h * 2, words1h + words2h);
+
+	/* Middle term < B^(words-h), higher words of t are 0 */
+	const int tw = _tt_min(h * 2 + 2, words - h);
+	tt_assert_fa(tw == h * 2 + 2 || t[tw] == 0);
+	add_words(digr + h, words - h, t, tw);
 }
-#else
-static inline int shift_add_u64(uint *dig, int msb, uint64_t ui64, int shift)
+
+/* digr = dig1 * dig2
+ * - digr: words1 + words2 words, zeroed
+ * - return 0 or error code
+ */
+static int mul_words(_tt_dec_word *digr, const _tt_dec_word *dig1,
+		int words1, const _tt_dec_word *dig2, int words2)
 {
-	/* Convert ui64 to decimal */
-	uint dec[3] = { 0, 0, 0 };
-	int msb2 = _tt_dec_uint_to_dec(dec, ui64);
+	if (words1 < words2) {
+		__tt_swap(dig1, dig2);
+		__tt_swap(words1, words2);
+	}
+
+	if (words2 < KARA_CROSS) {
+		_tt_stat_count(TT_STAT_DEC_MUL_CLASSIC);
+		mul_words_classic(digr, dig1, words1, dig2, words2);
+	} else if (words2 < NTT_CROSS) {
+		_tt_stat_count(TT_STAT_DEC_MUL_KARA);
+		_tt_dec_word *workbuf = malloc((words1 * 6 + 256) *
+				_tt_dec_word_sz);
+		if (workbuf == NULL)
+			return TT_ENOMEM;
+		mul_words_kara(digr, dig1, words1, dig2, words2, workbuf);
+		free(workbuf);
+	} else {
+		_tt_stat_count(TT_STAT_DEC_MUL_NTT);
+		return _tt_dec_mul_ntt(digr, dig1, words1, dig2, words2);
+	}
 
-	/* Add dec[] to &dig[shift] */
-	return add_digs(dig+shift, msb-shift*9, dec, msb2) + shift*9;
+	return 0;
 }
-#endif
 
 /* digr = dig1 * dig2
  * - msb: digit length, > 0
  * - dig1, dig2 are not zero
  * - digr must have enough space to hold result
  * - digr is zeroed
- * - return result digit length
+ * - return result digit length, or error code
  */
-static int mul_digs(uint *digr, const uint *dig1, const int msb1,
-		const uint *dig2, const int msb2)
+static int mul_digs(_tt_dec_word *digr, const _tt_dec_word *dig1,
+		const int msb1, const _tt_dec_word *dig2, const int msb2)
 {
-	int msb = 1;
-	const int uints1 = (msb1 + 8) / 9;
-	const int uints2 = (msb2 + 8) / 9;
+	const int words1 = _tt_dec_words(msb1);
+	const int words2 = _tt_dec_words(msb2);
 
-	for (int i = 0; i < uints1 + uints2; i++) {
-		int jmax = i;
-		if (jmax >= uints1)
-			jmax = uints1 - 1;
-		int jmin = i - uints2 + 1;
-		if (jmin < 0)
-			jmin = 0;
+	int ret = mul_words(digr, dig1, words1, dig2, words2);
+	if (ret)
+		return ret;
 
-#ifdef __SIZEOF_INT128__
-		/* XXX: int128 may overflow if both operands >= 10^(9*10^20) */
-		__uint128_t tmp128 = 0;
-		for (int j = jmax, k = i - jmax; j >= jmin; j--, k++)
-			tmp128 += (uint64_t)dig1[j] * dig2[k];
-		if (tmp128)
-			msb = shift_add_u128(digr, msb, tmp128, i);
-#else
-		uint64_t tmp64 = 0;
-		int cnt = 0;
-		for (int j = jmax, k = i - jmax; j >= jmin; j--, k++) {
-			tmp64 += (uint64_t)dig1[j] * dig2[k];
-			cnt++;
-			if (cnt == 10) {
-				/* Consume before tmp64 overflow */
-				msb = shift_add_u64(digr, msb, tmp64, i);
-				tmp64 = 0;
-				cnt = 0;
-			}
+	int msb = get_msb(digr, words1 + words2);
+	tt_assert_fa(msb >= _tt_max(msb1, msb2) && msb <= (msb1 + msb2));
+
+	return msb;
+}
+
+/* Words without leading zero words, at least 1 */
+static inline int trim_words(const _tt_dec_word *dig, int words)
+{
+	while (words > 1 && dig[words-1] == 0)
+		words--;
+	return words;
+}
+
+/* Compare words, leading zero words are ignored */
+static int cmp_words(const _tt_dec_word *dig1, int words1,
+		const _tt_dec_word *dig2, int words2)
+{
+	words1 = trim_words(dig1, words1);
+	words2 = trim_words(dig2, words2);
+	if (words1 != words2)
+		return words1 < words2 ? -1 : 1;
+
+	for (int i = words1 - 1; i >= 0; i--)
+		if (dig1[i] != dig2[i])
+			return dig1[i] < dig2[i] ? -1 : 1;
+
+	return 0;
+}
+
+/* dig *= m, return carry word */
+static _tt_dec_word mul_words_1(_tt_dec_word *dig, int words, _tt_dec_word m)
+{
+	_tt_dec_word carry = 0;
+
+	for (int i = 0; i < words; i++)
+		dig[i] = divmod_base((_tt_dec_dword)dig[i] * m + carry, &carry);
+
+	return carry;
+}
+
+/* Knuth algorithm D, one quotient word per step
+ * - qt = dd / ds, qt: words_dd - words_ds + 1 words
+ * - dd: words_dd + 1 words, destroyed
+ * - ds: words_ds words, top word is not zero, destroyed
+ * - return 1 if remainder is zero
+ */
+static int div_words_knuth(_tt_dec_word *qt, _tt_dec_word *dd, int words_dd,
+		_tt_dec_word *ds, int words_ds)
+{
+	const int n = words_ds;
+	_tt_dec_word rm = 0;
+
+	if (n == 1) {
+		const _tt_dec_word d = ds[0];
+		for (int j = words_dd - 1; j >= 0; j--) {
+			const _tt_dec_dword t = (_tt_dec_dword)rm *
+				_TT_DEC_BASE + dd[j];
+			qt[j] = t / d;
+			rm = t % d;
 		}
-		if (cnt)
-			msb = shift_add_u64(digr, msb, tmp64, i);
-#endif
+		return rm == 0;
 	}
 
-	tt_assert_fa(msb >= msb1 && msb <= (msb1 + msb2));
+	/* Normalize, top word of divisor >= base/2 */
+	const _tt_dec_word f = _TT_DEC_BASE / (ds[n-1] + 1);
+	dd[words_dd] = 0;
+	if (f > 1) {
+		rm = mul_words_1(ds, n, f);
+		tt_assert_fa(rm == 0);
+		dd[words_dd] = mul_words_1(dd, words_dd, f);
+	}
+	const _tt_dec_word v1 = ds[n-1], v2 = ds[n-2];
+
+	for (int j = words_dd - n; j >= 0; j--) {
+		_tt_dec_word *u = dd + j;
+
+		/* Estimate quotient word, at most 1 too large */
+		const _tt_dec_dword t = (_tt_dec_dword)u[n] * _TT_DEC_BASE +
+			u[n-1];
+		_tt_dec_dword qhat = t / v1, rhat = t % v1;
+		if (qhat >= _TT_DEC_BASE) {
+			qhat = _TT_DEC_BASE - 1;
+			rhat = t - qhat * v1;
+		}
+		while (rhat < _TT_DEC_BASE &&
+				qhat * v2 > rhat * _TT_DEC_BASE + u[n-2]) {
+			qhat--;
+			rhat += v1;
+		}
 
-	return msb;
+		/* u -= qhat * ds */
+		_tt_dec_word carry = 0;
+		char borrow = 0;
+		for (int i = 0; i < n; i++) {
+			const _tt_dec_word lo = divmod_base(qhat * ds[i] +
+					carry, &carry);
+			u[i] = sub_dig(u[i], lo, &borrow);
+		}
+		u[n] = sub_dig(u[n], carry, &borrow);
+
+		/* Add back */
+		if (borrow) {
+			qhat--;
+			add_words(u, n + 1, ds, n);
+		}
+		qt[j] = qhat;
+	}
+
+	for (int i = 0; i < n; i++)
+		if (dd[i])
+			return 0;
+	return 1;
+}
+
+/* x ~= B^(2n) / ds from below, B = _TT_DEC_BASE
+ * - ds: n words, top word >= B/2
+ * - x: n + 1 words
+ * - return 0 or error code
+ *
+ * Newton iteration x' = x + x * (B^(2n) - ds * x) / B^(2n) never goes
+ * above 1/ds, so all terms are positive. The initial guess is reciprocal of
+ * (top half words of ds) + 1, also from below, precision doubles per step.
+ */
+static int recip_words(_tt_dec_word *x, const _tt_dec_word *ds, int n)
+{
+	const int p = (n + 2) / 2;
+	const int sz = p * 2 + 2 + n * 2 + 2 + n * 3 + 2;
+
+	_tt_dec_word *workbuf = calloc(sz, _tt_dec_word_sz);
+	if (workbuf == NULL)
+		return TT_ENOMEM;
+
+	int ret = 0;
+	if (n < 4) {
+		/* B^(2n) / ds by long division */
+		_tt_dec_word *dd = workbuf, *v = dd + n * 2 + 2;
+		_tt_dec_word *q = v + n;
+		dd[n*2] = 1;
+		memcpy(v, ds, n * _tt_dec_word_sz);
+		div_words_knuth(q, dd, n * 2 + 1, v, n);
+		tt_assert_fa(q[n+1] == 0);
+		memcpy(x, q, (n + 1) * _tt_dec_word_sz);
+		goto out;
+	}
+
+	/* Initial guess from top p words, n <= 2p - 1 */
+	_tt_dec_word *vp = workbuf, *xp = vp + p + 1;
+	_tt_dec_word *e = xp + p + 1, *t = e + n * 2;
+	const _tt_dec_word one = 1;
+	memcpy(vp, ds + n - p, p * _tt_dec_word_sz);
+	if (add_words(vp, p, &one, 1)) {
+		/* Top words are all B-1, B^(2p) / B^p */
+		xp[p] = 1;
+	} else {
+		ret = recip_words(xp, vp, p);
+		if (ret)
+			goto out;
+	}
+	memset(x, 0, (n + 1) * _tt_dec_word_sz);
+	memcpy(x + n - p, xp, (p + 1) * _tt_dec_word_sz);
+
+	/* e = B^(2n) - ds * x >= 0 */
+	ret = mul_words(t, ds, n, x, n + 1);
+	if (ret)
+		goto out;
+	if (t[n*2])
+		goto out;	/* x = B^(2n) / ds */
+	memset(e, 0, n * 2 * _tt_dec_word_sz);
+	sub_words(e, n * 2, t, n * 2);
+	const int ew = trim_words(e, n * 2);
+
+	/* x += x * e / B^(2n) */
+	memset(t, 0, (n + 1 + ew) * _tt_dec_word_sz);
+	ret = mul_words(t, x, n + 1, e, ew);
+	if (ret)
+		goto out;
+	if (n + 1 + ew > n * 2)
+		add_words(x, n + 1, t + n * 2, n + 1 + ew - n * 2);
+
+out:
+	free(workbuf);
+	return ret;
+}
+
+/* Newton division, qt = dd / ds
+ * - quotient from reciprocal of top words of divisor, corrected by exact
+ *   remainder dd - qt * ds
+ * - parameters same as div_words_knuth(), ds is not changed
+ * - return 0 or error code, *exact = 1 if remainder is zero
+ */
+static int div_words_newton(_tt_dec_word *qt, _tt_dec_word *dd, int words_dd,
+		const _tt_dec_word *ds, int words_ds, int *exact)
+{
+	const int n = words_ds, qw = words_dd - n + 1;
+
+	/* Divisor precision k words: truncate or pad ds and dd */
+	const int k = qw + 2;
+	const int uw = words_dd - n + k;
+	const int sz = k + (uw + 1) + (k + 1) + (uw + k + 2) +
+		(qw + 2 + n);
+
+	_tt_dec_word *workbuf = calloc(sz, _tt_dec_word_sz);
+	if (workbuf == NULL)
+		return TT_ENOMEM;
+	_tt_dec_word *vt = workbuf, *ut = vt + k, *x = ut + uw + 1;
+	_tt_dec_word *t = x + k + 1, *prod = t + uw + k + 2;
+
+	if (n >= k) {
+		memcpy(vt, ds + n - k, k * _tt_dec_word_sz);
+		memcpy(ut, dd + n - k, uw * _tt_dec_word_sz);
+	} else {
+		memcpy(vt + k - n, ds, n * _tt_dec_word_sz);
+		memcpy(ut + k - n, dd, words_dd * _tt_dec_word_sz);
+	}
+	const _tt_dec_word f = _TT_DEC_BASE / (vt[k-1] + 1);
+	if (f > 1) {
+		mul_words_1(vt, k, f);
+		ut[uw] = mul_words_1(ut, uw, f);
+	}
+
+	/* q = ut * x / B^(2k), at most a few off */
+	int ret = recip_words(x, vt, k);
+	if (ret)
+		goto out;
+	ret = mul_words(t, ut, uw + 1, x, k + 1);
+	if (ret)
+		goto out;
+	_tt_dec_word *q = t + k * 2;
+	const int qw2 = uw + 2 - k;
+	tt_assert_fa(qw2 == qw + 1);
+
+	/* Correct q with remainder dd - q * ds */
+	const _tt_dec_word one = 1;
+	ret = mul_words(prod, q, qw2, ds, n);
+	if (ret)
+		goto out;
+	while (cmp_words(prod, qw2 + n, dd, words_dd) > 0) {
+		sub_words(q, qw2, &one, 1);
+		sub_words(prod, qw2 + n, ds, n);
+	}
+	sub_words(dd, words_dd, prod, trim_words(prod, qw2 + n));
+	while (cmp_words(dd, words_dd, ds, n) >= 0) {
+		add_words(q, qw2, &one, 1);
+		sub_words(dd, words_dd, ds, n);
+	}
+
+	tt_assert_fa(q[qw] == 0);
+	memcpy(qt, q, qw * _tt_dec_word_sz);
+	*exact = trim_words(dd, words_dd) == 1 && dd[0] == 0;
+
+out:
+	free(workbuf);
+	return ret;
+}
+
+/* qt = dd / ds
+ * - dd: words_dd + 1 words, destroyed
+ * - ds: words_ds words, top word is not zero, destroyed
+ * - qt: words_dd - words_ds + 1 words
+ * - return 0 or error code, *exact = 1 if remainder is zero
+ */
+static int div_words(_tt_dec_word *qt, _tt_dec_word *dd, int words_dd,
+		_tt_dec_word *ds, int words_ds, int *exact)
+{
+	const int qw = words_dd - words_ds + 1;
+
+	if (_tt_min(qw, words_ds) < NEWTON_CROSS) {
+		_tt_stat_count(TT_STAT_DEC_DIV_CLASSIC);
+		*exact = div_words_knuth(qt, dd, words_dd, ds, words_ds);
+		return 0;
+	}
+
+	_tt_stat_count(TT_STAT_DEC_DIV_NEWTON);
+	return div_words_newton(qt, dd, words_dd, ds, words_ds, exact);
 }
 
 /* Compare digits
  * - msb: digit length, may <= 0
  * - return: 1 - dig1 > dig2, 0 - dig1 == dig2, -1 - dig1 < dig2
  */
-static int cmp_digs(const uint *dig1, const int msb1,
-		const uint *dig2, const int msb2)
+static int cmp_digs(const _tt_dec_word *dig1, const int msb1,
+		const _tt_dec_word *dig2, const int msb2)
 {
 	if (msb1 <= 0 && msb2 <= 0)
 		return 0;
@@ -251,8 +705,8 @@ static int cmp_digs(const uint *dig1, const int msb1,
 		return 1;
 
 	/* Compare digits: msb1 = msb2 > 0 */
-	const int uints = (msb1 + 8) / 9;
-	for (int i = uints - 1; i >= 0; i--) {
+	const int words = _tt_dec_words(msb1);
+	for (int i = words - 1; i >= 0; i--) {
 		if (dig1[i] > dig2[i])
 			return 1;
 		else if (dig1[i] < dig2[i])
@@ -261,26 +715,6 @@ static int cmp_digs(const uint *dig1, const int msb1,
 	return 0;
 }
 
-/* Left shift adj digits
- * - adj = 1~8
- * - return shifted value
- */
-static inline uint lshift_dig_1_8(uint dig32, int adj)
-{
-	uint64_t dig64 = dig32;
-	dig64 *= one_tbl[adj];
-	return dig64 % 1000000000;
-}
-
-/* Right shift adj digits
- * - adj = 1~8
- * - retrun shifted value
- */
-static inline uint rshift_dig_1_8(uint dig32, int adj)
-{
-	return dig32 / one_tbl[adj];
-}
-
 /* Shift "src" adj digits and copy to "dst"
  * - msb: digits in src
  * - dst_sz: buffer size of dst
@@ -291,9 +725,10 @@ static inline uint rshift_dig_1_8(uint dig32, int adj)
  * - dst must have enough space to hold shifted src
  * - return result digit length
  */
-static int shift_digs(uint *dst, uint dst_sz, const uint *src, int msb, int adj)
+static int shift_digs(_tt_dec_word *dst, uint dst_sz, const _tt_dec_word *src,
+		int msb, int adj)
 {
-	int uints = (msb + 8) / 9;	/* Valid uints in src */
+	int words = _tt_dec_words(msb);	/* Valid words in src */
 	int msb_r = msb + adj;		/* Result length for debugging */
 
 	/* Check shift direction */
@@ -303,7 +738,7 @@ static int shift_digs(uint *dst, uint dst_sz, const uint *src, int msb, int adj)
 		if (adj >= msb) {
 			/* All digits truncated, just fill with 0 */
 			if (dst == src)
-				memset(dst, 0, uints * 4);
+				memset(dst, 0, words * _tt_dec_word_sz);
 			return 1;
 		}
 		append0 = 0;	/* Truncate */
@@ -311,82 +746,249 @@ static int shift_digs(uint *dst, uint dst_sz, const uint *src, int msb, int adj)
 		append0 = 1;	/* Append */
 	} else {
 		if (dst != src)
-			memcpy(dst, src, uints * 4);
+			memcpy(dst, src, words * _tt_dec_word_sz);
 		return msb;	/* No shift */
 	}
 
 	/* Shift */
-	int adj9 = adj / 9;	/* Align to uint */
-	adj %= 9;
+	int adjw = adj / _TT_DEC_DIGS;	/* Align to word */
+	adj %= _TT_DEC_DIGS;
 	int i;
-	const uint *cur = src;	/* Current digit buffer */
+	const _tt_dec_word *cur = src;	/* Current digit buffer */
 	if (append0) { /* Left shift */
-		/* Align-9 */
-		if (adj9) {
-			for (i = uints-1; i >= 0; i--)
-				dst[i+adj9] = src[i];
-			memset(dst, 0, adj9 * 4);
+		/* Word aligned */
+		if (adjw) {
+			for (i = words-1; i >= 0; i--)
+				dst[i+adjw] = src[i];
+			memset(dst, 0, adjw * _tt_dec_word_sz);
 
-			msb += adj9 * 9;
-			uints += adj9;
+			msb += adjw * _TT_DEC_DIGS;
+			words += adjw;
 
 			cur = dst;
 		}
 
 		/* Unaligned */
-		if (adj) {	/* adj = 1~8 */
-			/* Check digits in first uint */
-			int u1_dig = (msb - 1) % 9 + 1;
-			if ((u1_dig + adj) > 9)
-				uints++;
+		if (adj) {
+			/* Check digits in first word */
+			int w1_dig = (msb - 1) % _TT_DEC_DIGS + 1;
+			if ((w1_dig + adj) > _TT_DEC_DIGS)
+				words++;
 			msb += adj;
 
-			/* Shift left */
-			for (i = uints-1; i > 0; i--) {
-				dst[i] = lshift_dig_1_8(cur[i], adj);
-				/* Append msb of lower uint */
-				dst[i] += cur[i-1] / one_tbl[9-adj];
+			/* Shift left, low part of a word moves up, high
+			 * part goes to next word
+			 */
+			const int n = _TT_DEC_DIGS - adj;
+			_tt_dec_word hi = 0;
+			for (i = 0; i < words; i++) {
+				const _tt_dec_word hi_prev = hi;
+				const _tt_dec_word lo = divmod_pow10(cur[i], n,
+						&hi);
+				dst[i] = lo * one_tbl[adj] + hi_prev;
 			}
-			dst[0] = lshift_dig_1_8(cur[0], adj);
 		}
 	} else { /* Right shift */
-		/* Align-9 */
-		if (adj9) {
-			for (i = adj9; i < uints; i++)
-				dst[i-adj9] = src[i];
-			int remains = dst_sz - (uints - adj9) * 4;
-			if (remains > 0)
-				memset(dst + uints - adj9, 0, remains);
-
-			msb -= adj9 * 9;
-			uints -= adj9;
-
-			cur = dst;
-		}
-
-		/* Unaligned */
-		if (adj) {	/* adj = 1~8 */
-			/* Shift right */
-			for (i = 0; i < uints - 1; i++) {
-				dst[i] = rshift_dig_1_8(cur[i], adj);
-				/* Prepend lsb of higher uint */
-				dst[i] += (cur[i+1] % one_tbl[adj]) *
-					one_tbl[9-adj];
+		/* Write result words only, dst may be just large enough for
+		 * them, low part of a word goes to previous word, high part
+		 * moves down
+		 */
+		const _tt_dec_word *s = src + adjw;
+		const int n = words - adjw;
+		msb -= adjw * _TT_DEC_DIGS + adj;
+		words = _tt_dec_words(msb);
+
+		if (adj) {
+			const _tt_dec_word scale = one_tbl[_TT_DEC_DIGS-adj];
+			_tt_dec_word hi;
+			divmod_pow10(s[0], adj, &hi);	/* Drop low digits */
+			for (i = 0; i < words; i++) {
+				const _tt_dec_word hi_cur = hi;
+				_tt_dec_word lo = 0;
+				if (i + 1 < n)
+					lo = divmod_pow10(s[i+1], adj, &hi);
+				dst[i] = hi_cur + lo * scale;
 			}
-			dst[uints-1] = rshift_dig_1_8(cur[uints-1], adj);
-
-			/* Check digits in first uint */
-			int u1_dig = (msb - 1) % 9 + 1;
-			if (u1_dig <= adj)
-				uints--;
-			msb -= adj;
+		} else {
+			memmove(dst, s, words * _tt_dec_word_sz);
 		}
+
+		/* Clear stale high words of in place shift */
+		if (dst == src)
+			memset(dst + words, 0, (n + adjw - words) *
+					_tt_dec_word_sz);
 	}
 
 	tt_assert_fa(msb_r == msb);
 	return msb;
 }
 
+#ifdef __SIZEOF_INT128__
+/* Fast path on 128-bit significands
+ * - operands and result have at most FAST_DIGS digits and need no rounding,
+ *   so results are identical to word array kernels
+ * - anything else falls back to generic code
+ */
+#define FAST_DIGS	38
+
+#define E19	((__uint128_t)10000000000000000000ULL)
+
+/* 10^n, n = 0 ~ FAST_DIGS */
+static const __uint128_t pow10_128[] = {
+	1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL,
+	10000000ULL, 100000000ULL, 1000000000ULL, 10000000000ULL,
+	100000000000ULL, 1000000000000ULL, 10000000000000ULL,
+	100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL,
+	100000000000000000ULL, 1000000000000000000ULL,
+	E19, E19 * 10ULL, E19 * 100ULL, E19 * 1000ULL, E19 * 10000ULL,
+	E19 * 100000ULL, E19 * 1000000ULL, E19 * 10000000ULL,
+	E19 * 100000000ULL, E19 * 1000000000ULL, E19 * 10000000000ULL,
+	E19 * 100000000000ULL, E19 * 1000000000000ULL,
+	E19 * 10000000000000ULL, E19 * 100000000000000ULL,
+	E19 * 1000000000000000ULL, E19 * 10000000000000000ULL,
+	E19 * 100000000000000000ULL, E19 * 1000000000000000000ULL, E19 * E19,
+};
+
+/* Significand of at most FAST_DIGS digits */
+static inline __uint128_t get_u128(const struct tt_dec *dec)
+{
+#if CONFIG_DEC_DIG64
+	__uint128_t v = dec->_dig[0];
+
+	if (dec->_msb > _TT_DEC_DIGS)
+		v += (__uint128_t)dec->_dig[1] * _TT_DEC_BASE;
+	return v;
+#else
+	__uint128_t v = 0;
+
+	for (int i = _tt_dec_words(dec->_msb) - 1; i >= 0; i--)
+		v = v * _TT_DEC_BASE + dec->_dig[i];
+	return v;
+#endif
+}
+
+/* Digits of v, at least 1 */
+static inline int u128_digs(__uint128_t v)
+{
+	const uint64_t hi = v >> 64, lo = v;
+	const int bits = hi ? 128 - __builtin_clzll(hi) :
+		64 - __builtin_clzll(lo | 1);
+
+	/* floor(log10(2^(bits-1))) <= digits-1, 1233/4096 ~ log10(2) */
+	const int n = bits * 1233 >> 12;
+	return _tt_max(n + (v >= pow10_128[n]), 1);
+}
+
+/* Store v < 10^FAST_DIGS of msb digits to dec */
+static inline void put_u128(struct tt_dec *dec, __uint128_t v, int msb)
+{
+	/* Words beyond _msb are always zero */
+	const int words_old = _tt_dec_words(dec->_msb);
+	_tt_dec_word *dig = dec->_dig;
+
+#if CONFIG_DEC_DIG64
+	dig[0] = divmod_base(v, &dig[1]);
+	if (words_old > 2)
+		memset(dig + 2, 0, (words_old - 2) * _tt_dec_word_sz);
+#else
+	int i = 0;
+	for (; v >> 64; i++) {
+		dig[i] = v % _TT_DEC_BASE;
+		v /= _TT_DEC_BASE;
+	}
+	for (uint64_t v64 = v; v64; i++) {
+		dig[i] = v64 % _TT_DEC_BASE;
+		v64 /= _TT_DEC_BASE;
+	}
+	if (words_old > i)
+		memset(dig + i, 0, (words_old - i) * _tt_dec_word_sz);
+	if (i == 0)
+		dig[0] = 0;
+#endif
+	dec->_msb = msb;
+}
+
+/* dst = src1 + src2, signs have been applied
+ * - src1, src2 are finite
+ * - return 0 on success, -1 to fall back
+ */
+static int add_sub_fast(struct tt_dec *dst, const struct tt_dec *src1,
+		int sign1, const struct tt_dec *src2, int sign2)
+{
+	/* Same rules as generic code: src1 has bigger exponent */
+	if (src1->_exp < src2->_exp) {
+		__tt_swap(src1, src2);
+		__tt_swap(sign1, sign2);
+	}
+
+	const int msb1 = src1->_msb, msb2 = src2->_msb;
+	const int prec = _tt_min(dst->_prec, FAST_DIGS);
+	if (msb1 > prec || msb2 > prec)
+		return -1;
+
+	/* Zero needn't shift */
+	const int adj = src1->_exp - src2->_exp;
+	__uint128_t v1 = get_u128(src1);
+	if (v1) {
+		if (adj > prec - msb1)
+			return -1;
+		v1 *= pow10_128[adj];
+	}
+	const __uint128_t v2 = get_u128(src2);
+
+	/* Result may carry to 39 digits, still fits in 128 bits */
+	__uint128_t v;
+	int sign = sign1;
+	if (sign1 == sign2) {
+		v = v1 + v2;
+	} else if (v1 >= v2) {
+		v = v1 - v2;
+	} else {
+		v = v2 - v1;
+		sign = sign2;
+	}
+	const int msb = u128_digs(v);
+	if (msb > prec)
+		return -1;
+
+	_tt_stat_count(TT_STAT_DEC_FAST);
+	put_u128(dst, v, msb);
+	dst->_sign = sign;
+	dst->_exp = src2->_exp;
+	dst->_inf_nan = 0;
+
+	return 0;
+}
+
+/* dst = src1 * src2, significands only
+ * - src1, src2 are finite and not zero, sign and exponent are set
+ * - return 0 on success, -1 to fall back
+ */
+static int mul_fast(struct tt_dec *dst, const struct tt_dec *src1,
+		const struct tt_dec *src2)
+{
+	const int msb1 = src1->_msb, msb2 = src2->_msb;
+	if (msb1 + msb2 > FAST_DIGS)
+		return -1;
+
+	/* Both fit in one 64-bit multiply */
+	__uint128_t v;
+	if (msb1 + msb2 <= 19)
+		v = (uint64_t)get_u128(src1) * (uint64_t)get_u128(src2);
+	else
+		v = get_u128(src1) * get_u128(src2);
+
+	const int msb = u128_digs(v);
+	if (msb > dst->_prec)
+		return -1;
+
+	_tt_stat_count(TT_STAT_DEC_FAST);
+	put_u128(dst, v, msb);
+
+	return 0;
+}
+#endif
+
 /* dst = src1 +/- src2
  * - sub: 0 -> add, 1 -> sub
  * - dst may share with src1 or src2
@@ -411,17 +1013,18 @@ static int add_sub_dec(struct tt_dec *dst, const struct tt_dec *src1,
 		dst->_sign = (src1->_inf_nan == TT_DEC_INF ? sign1 : sign2);
 		return TT_APN_EOVERFLOW;
 	}
-	dst->_inf_nan = 0;
 
-	/* Allocate a new DEC if dst and src overlaps */
-	struct tt_dec *dst2 = dst;
-	if (dst == src1 || dst == src2) {
-		dst2 = tt_dec_alloc(dst->_prec);
-		if (!dst2)
-			return TT_ENOMEM;
-	} else {
-		_tt_dec_zero(dst);
-	}
+#ifdef __SIZEOF_INT128__
+	if (add_sub_fast(dst, src1, sign1, src2, sign2) == 0)
+		return 0;
+#endif
+
+	/* Aligned src2 goes to scratch, src1 to dst, may be in place */
+	_tt_dec_word *tmpdig = _tt_dec_scratch(dst,
+			dst->_digsz / _tt_dec_word_sz);
+	if (!tmpdig)
+		return TT_ENOMEM;
+	dst->_inf_nan = 0;
 
 	/* Check exponent alignment.
 	 * Swap src1 and src2 if exponent of src1 is smaller, and make src1
@@ -441,8 +1044,8 @@ static int add_sub_dec(struct tt_dec *dst, const struct tt_dec *src1,
 		msb_dst += exp_adj1;
 	if (msb_dst < src2->_msb)
 		msb_dst = src2->_msb;
-	if (msb_dst > dst2->_prec) {
-		int adj_adj = msb_dst - dst2->_prec;
+	if (msb_dst > dst->_prec) {
+		int adj_adj = msb_dst - dst->_prec;
 		exp_adj1 -= adj_adj;
 		exp_adj2 -= adj_adj;
 	}
@@ -451,7 +1054,7 @@ static int add_sub_dec(struct tt_dec *dst, const struct tt_dec *src1,
 		ret = TT_APN_EROUNDED;
 
 	/* Set result exponent, may adjust later */
-	dst2->_exp = src1->_exp - exp_adj1;
+	const int exp_dst = src1->_exp - exp_adj1;
 
 	/* Use rounding guard digits to gain precision */
 	int adj_adj = 0;
@@ -466,11 +1069,11 @@ static int add_sub_dec(struct tt_dec *dst, const struct tt_dec *src1,
 		}
 	}
 
-	/* If both operands need shift, make src1 align-9 shifting */
-	if ((exp_adj1 % 9) && (exp_adj2 % 9)) {
-		int align_adj = 9 - exp_adj1 % 9;
-		if (align_adj > 9)	/* exp_adj may be negative */
-			align_adj -= 9;
+	/* If both operands need shift, make src1 word aligned shifting */
+	if ((exp_adj1 % _TT_DEC_DIGS) && (exp_adj2 % _TT_DEC_DIGS)) {
+		int align_adj = _TT_DEC_DIGS - exp_adj1 % _TT_DEC_DIGS;
+		if (align_adj > _TT_DEC_DIGS)	/* exp_adj may be negative */
+			align_adj -= _TT_DEC_DIGS;
 		exp_adj1 += align_adj;
 		exp_adj2 += align_adj;
 		adj_adj += align_adj;
@@ -482,82 +1085,73 @@ static int add_sub_dec(struct tt_dec *dst, const struct tt_dec *src1,
 	if (_tt_dec_is_zero(src2))
 		exp_adj2 = 0;
 
-	/* Copy adjusted significand of src1 to dst */
-	tt_assert_fa(dst2->_prec_full > (src1->_msb + exp_adj1));
-	shift_digs(dst2->_dig32, dst2->_digsz, src1->_dig32, src1->_msb, exp_adj1);
+	/* Copy adjusted significand of src2 to scratch first, dst may share
+	 * src2 and is overwritten by src1 then
+	 */
+	const int msb1 = src1->_msb, msb2 = src2->_msb;
+	tt_assert_fa(dst->_prec_full > (msb2 + exp_adj2));
+	shift_digs(tmpdig, dst->_digsz, src2->_dig, msb2, exp_adj2);
 
-	/* Copy adjusted significand of src2 to temporary buffer */
-	uint *tmpdig = malloc(dst2->_digsz);
-	if (!tmpdig) {
-		if (dst2 != dst)
-			free(dst2);
-		return TT_ENOMEM;
-	}
-	memset(tmpdig, 0, dst2->_digsz);
-	tt_assert_fa(dst2->_prec_full > (src2->_msb + exp_adj2));
-	shift_digs(tmpdig, dst2->_digsz, src2->_dig32, src2->_msb, exp_adj2);
+	/* Shift src1 to dst, in place if they are same */
+	tt_assert_fa(dst->_prec_full > (msb1 + exp_adj1));
+	if (src1 != dst)
+		memset(dst->_dig, 0, dst->_digsz);
+	shift_digs(dst->_dig, dst->_digsz, src1->_dig, msb1, exp_adj1);
+	dst->_exp = exp_dst;
 
 	/* Compare sign, decide to do "+" or "-" */
 	int msb;
 	if (sign1 == sign2) {
 		/* Adding... */
-		dst2->_sign = sign1;
+		dst->_sign = sign1;
 		/* Add aligned significands */
-		msb = add_digs(dst2->_dig32, src1->_msb + exp_adj1,
-				tmpdig, src2->_msb + exp_adj2);
+		msb = add_digs(dst->_dig, msb1 + exp_adj1,
+				tmpdig, msb2 + exp_adj2);
 	} else {
 		/* Substracting... */
 		/* Pick bigger value */
-		int cmp12 = cmp_digs(dst2->_dig32, src1->_msb + exp_adj1,
-				tmpdig, src2->_msb + exp_adj2);
+		int cmp12 = cmp_digs(dst->_dig, msb1 + exp_adj1,
+				tmpdig, msb2 + exp_adj2);
 		/* Substract aligned significands */
 		if (cmp12 >= 0) {
-			dst2->_sign = sign1;
-			msb = sub_digs(dst2->_dig32,
-					dst2->_dig32, src1->_msb + exp_adj1,
-					tmpdig, src2->_msb + exp_adj2);
+			dst->_sign = sign1;
+			msb = sub_digs(dst->_dig,
+					dst->_dig, msb1 + exp_adj1,
+					tmpdig, msb2 + exp_adj2);
 		} else {
-			dst2->_sign = sign2;
-			msb = sub_digs(dst2->_dig32,
-					tmpdig, src2->_msb + exp_adj2,
-					dst2->_dig32, src1->_msb + exp_adj1);
+			dst->_sign = sign2;
+			msb = sub_digs(dst->_dig,
+					tmpdig, msb2 + exp_adj2,
+					dst->_dig, msb1 + exp_adj1);
 		}
 	}
 
 	/* Check rounding */
 	if (adj_adj) {
-		if (_tt_round(_tt_dec_get_dig(dst2->_dig32, adj_adj) & 1,
-				_tt_dec_get_dig(dst2->_dig32, adj_adj-1), 0)) {
+		if (_tt_round(_tt_dec_get_dig(dst->_dig, adj_adj) & 1,
+				_tt_dec_get_dig(dst->_dig, adj_adj-1), 0)) {
 			/* Construct 10^adj_adj */
 			tt_assert_fa(adj_adj < 36);
-			uint one[4] = { 0, 0, 0, 0 };
-			one[adj_adj / 9] = one_tbl[adj_adj % 9];
-			msb = add_digs(dst2->_dig32, msb, one, adj_adj+1);
+			_tt_dec_word one[5] = { 0, 0, 0, 0, 0 };
+			one[adj_adj / _TT_DEC_DIGS] =
+				one_tbl[adj_adj % _TT_DEC_DIGS];
+			msb = add_digs(dst->_dig, msb, one, adj_adj+1);
 		}
 	}
 	/* Adjust significand, msb */
-	dst2->_msb = msb - adj_adj;
+	dst->_msb = msb - adj_adj;
 	/* Only happen on substracting */
-	if (dst2->_msb <= 0)
-		dst2->_msb = 1;
-	tt_assert_fa(dst2->_msb >= 1 && dst2->_msb <= (dst2->_prec+1));
+	if (dst->_msb <= 0)
+		dst->_msb = 1;
+	tt_assert_fa(dst->_msb >= 1 && dst->_msb <= (dst->_prec+1));
 	/* Only happen on adding */
-	if (dst2->_msb > dst2->_prec) {
+	if (dst->_msb > dst->_prec) {
 		adj_adj++;
-		dst2->_msb--;
-		dst2->_exp++;
+		dst->_msb--;
+		dst->_exp++;
 		ret = TT_APN_EROUNDED;
 	}
-	shift_digs(dst2->_dig32, dst2->_digsz, dst2->_dig32, msb, -adj_adj);
-
-	free(tmpdig);
-
-	/* Switch buffer if dst overlap with src */
-	if (dst2 != dst) {
-		free(dst->_dig32);
-		memcpy(dst, dst2, sizeof(struct tt_dec));
-		free(dst2);
-	}
+	shift_digs(dst->_dig, dst->_digsz, dst->_dig, msb, -adj_adj);
 
 	return ret;
 }
@@ -566,6 +1160,7 @@ static int add_sub_dec(struct tt_dec *dst, const struct tt_dec *src1,
 int tt_dec_add(struct tt_dec *dst, const struct tt_dec *src1,
 		const struct tt_dec *src2)
 {
+	_tt_stat_func(TT_STAT_DEC_ADD);
 	return add_sub_dec(dst, src1, src2, 0);
 }
 
@@ -573,6 +1168,7 @@ int tt_dec_add(struct tt_dec *dst, const struct tt_dec *src1,
 int tt_dec_sub(struct tt_dec *dst, const struct tt_dec *src1,
 		const struct tt_dec *src2)
 {
+	_tt_stat_func(TT_STAT_DEC_SUB);
 	return add_sub_dec(dst, src1, src2, 1);
 }
 
@@ -580,6 +1176,7 @@ int tt_dec_sub(struct tt_dec *dst, const struct tt_dec *src1,
 int tt_dec_mul(struct tt_dec *dst, const struct tt_dec *src1,
 		const struct tt_dec *src2)
 {
+	_tt_stat_func(TT_STAT_DEC_MUL);
 	int ret = 0;
 
 	dst->_sign = src1->_sign ^ src2->_sign;
@@ -606,24 +1203,32 @@ int tt_dec_mul(struct tt_dec *dst, const struct tt_dec *src1,
 				dst->_exp = 0;
 		}
 		dst->_msb = 1;
-		memset(dst->_dig32, 0, dst->_digsz);
+		memset(dst->_dig, 0, dst->_digsz);
 		return 0;
 	}
 
 	dst->_exp = src1->_exp + src2->_exp;
 
-	/* Allocate result buffer
+#ifdef __SIZEOF_INT128__
+	if (mul_fast(dst, src1, src2) == 0)
+		return 0;
+#endif
+
+	/* Result buffer in scratch of dst
 	 * - add one extra rounding guard digits
-	 * - add 18 digits for extra 0 introduced by uint boundary
+	 * - add two words for extra 0 introduced by word boundary
 	 */
-	const int uints = (src1->_msb + src2->_msb + 1 + 18 + 8) / 9;
-	uint *digr = calloc(uints, 4);
+	const int words = _tt_dec_words(src1->_msb + src2->_msb + 1 +
+			_TT_DEC_DIGS * 2);
+	_tt_dec_word *digr = _tt_dec_scratch(dst, words);
 	if (!digr)
 		return TT_ENOMEM;
 
 	/* Multiply */
-	int msb = mul_digs(digr, src1->_dig32, src1->_msb,
-			src2->_dig32, src2->_msb);
+	int msb = mul_digs(digr, src1->_dig, src1->_msb,
+			src2->_dig, src2->_msb);
+	if (msb < 0)
+		return msb;
 
 	/* Adjust significand, msb */
 	int adj = 0;
@@ -633,19 +1238,20 @@ int tt_dec_mul(struct tt_dec *dst, const struct tt_dec *src1,
 		/* Check rounding */
 		if (_tt_round(_tt_dec_get_dig(digr, adj) & 1,
 				_tt_dec_get_dig(digr, adj-1), 0)) {
-			/* Shift digr to have 1~9 extra digs */
-			if (adj >= 10) {
-				int shift = (adj - 1) / 9;
-				shift *= 9;
-				shift_digs(digr, uints*4, digr, msb, -shift);
+			/* Shift digr to have 1~_TT_DEC_DIGS extra digs */
+			if (adj > _TT_DEC_DIGS) {
+				int shift = (adj - 1) / _TT_DEC_DIGS;
+				shift *= _TT_DEC_DIGS;
+				shift_digs(digr, words * _tt_dec_word_sz, digr,
+						msb, -shift);
 				adj -= shift;
 				msb -= shift;
 				dst->_exp += shift;
 			}
 			/* Add 10^adj */
-			tt_assert_fa(adj >=1 && adj <= 9);
-			uint one[2] = { 0, 0 };
-			one[adj / 9] = one_tbl[adj % 9];
+			tt_assert_fa(adj >=1 && adj <= _TT_DEC_DIGS);
+			_tt_dec_word one[2] = { 0, 0 };
+			one[adj / _TT_DEC_DIGS] = one_tbl[adj % _TT_DEC_DIGS];
 			msb = add_digs(digr, msb, one, adj+1);
 			/* Get new exponent adjust */
 			adj = msb - dst->_prec;
@@ -660,10 +1266,9 @@ int tt_dec_mul(struct tt_dec *dst, const struct tt_dec *src1,
 	}
 
 	/* Copy to dst */
-	memset(dst->_dig32, 0, dst->_digsz);
-	shift_digs(dst->_dig32, dst->_digsz, digr, msb, -adj);
+	memset(dst->_dig, 0, dst->_digsz);
+	shift_digs(dst->_dig, dst->_digsz, digr, msb, -adj);
 
-	free(digr);
 	return ret;
 }
 
@@ -671,6 +1276,7 @@ int tt_dec_mul(struct tt_dec *dst, const struct tt_dec *src1,
 int tt_dec_div(struct tt_dec *dst, const struct tt_dec *src1,
 		const struct tt_dec *src2)
 {
+	_tt_stat_func(TT_STAT_DEC_DIV);
 	int ret = 0, sign = src1->_sign ^ src2->_sign;
 
 	dst->_sign = sign;
@@ -715,172 +1321,596 @@ int tt_dec_div(struct tt_dec *dst, const struct tt_dec *src1,
 		}
 		dst->_inf_nan = 0;
 		dst->_msb = 1;
-		memset(dst->_dig32, 0, dst->_digsz);
+		memset(dst->_dig, 0, dst->_digsz);
 		return 0;
 	}
 
-	/* Allocate a new DEC if dst overlaps src */
-	struct tt_dec *quotient = dst;
-	if (quotient == src1 || quotient == src2) {
-		quotient = tt_dec_alloc(quotient->_prec);
-		if (!quotient)
-			return TT_ENOMEM;
-	} else {
-		_tt_dec_zero(quotient);
+	/* q = src1 * 10^s / src2 has prec+1 or prec+2 digits
+	 * - s < 0: truncate dividend, dropped digits make result inexact
+	 */
+	const int prec = dst->_prec;
+	const int msb1 = src1->_msb, msb2 = src2->_msb;
+	const int s = prec + 1 - (msb1 - msb2);
+	const int exp = src1->_exp - src2->_exp - s;
+
+	const int words_dd = _tt_dec_words(msb1 + s);
+	const int words_ds = _tt_dec_words(msb2);
+	const int words_qt = words_dd - words_ds + 1;
+	_tt_dec_word *dividend = _tt_dec_scratch(dst,
+			words_dd + 1 + words_ds + words_qt);
+	if (!dividend)
+		return TT_ENOMEM;
+	_tt_dec_word *divisor = dividend + words_dd + 1;
+	_tt_dec_word *qt = divisor + words_ds;
+
+	int exact = 1;
+	if (s < 0)
+		for (int i = 0; i < -s && exact; i++)
+			exact = _tt_dec_get_dig(src1->_dig, i) == 0;
+	shift_digs(dividend, (words_dd + 1) * _tt_dec_word_sz,
+			src1->_dig, msb1, s);
+	memcpy(divisor, src2->_dig, words_ds * _tt_dec_word_sz);
+
+	int exact_qt;
+	ret = div_words(qt, dividend, words_dd, divisor, words_ds, &exact_qt);
+	if (ret)
+		return ret;
+	exact &= exact_qt;
+
+	/* Drop extra digit, and trailing zeros of exact quotient */
+	int msb = get_msb(qt, words_qt);
+	tt_assert_fa(msb == prec + 1 || msb == prec + 2);
+	int adj = 0;
+	if (msb > prec + 1) {
+		exact &= _tt_dec_get_dig(qt, 0) == 0;
+		adj = 1;
 	}
+	if (exact)
+		while (_tt_dec_get_dig(qt, adj) == 0)
+			adj++;
 
-	quotient->_sign = sign;
-	quotient->_exp = src1->_exp - src2->_exp;
+	dst->_inf_nan = 0;
+	dst->_exp = exp + adj;
+	memset(dst->_dig, 0, dst->_digsz);
+	msb = shift_digs(dst->_dig, dst->_digsz, qt, msb, -adj);
 
-	/* Allocate dividend, divisor buffer */
-	const int uints = (_tt_max(src1->_msb, src2->_msb) + 1 + 8) / 9;
-	uint *dividend = calloc(uints, 4);
-	uint *divisor = calloc(uints, 4);
-	if (!dividend || !divisor) {
-		ret = TT_ENOMEM;
-		goto out;
-	}
-	memcpy(dividend, src1->_dig32, _tt_min(src1->_digsz, uints*4));
-	memcpy(divisor, src2->_dig32, _tt_min(src2->_digsz, uints*4));
-
-	int msb_dividend = src1->_msb;
-	int msb_divisor = src2->_msb;
-
-	/* Get highest digit */
-	int top_dividend = _tt_dec_get_dig(dividend, msb_dividend-1);
-	int top_divisor = _tt_dec_get_dig(divisor, msb_divisor-1);
-	tt_assert_fa(top_divisor && top_dividend);
-
-	/* Make dividend/divisor within [1, 10) */
-	int adj = msb_dividend - msb_divisor;
-	quotient->_exp += adj;
-	if (adj < 0)
-		msb_dividend = shift_digs(dividend, 0,
-				dividend, msb_dividend, -adj);
-	else if (adj > 0)
-		msb_divisor = shift_digs(divisor, 0, divisor, msb_divisor, adj);
-	if (cmp_digs(dividend, msb_dividend, divisor, msb_divisor) < 0) {
-		quotient->_exp--;
-		msb_dividend = shift_digs(dividend, 0, dividend, msb_dividend, 1);
-		tt_assert_fa(msb_dividend == msb_divisor + 1);
-	} else {
-		tt_assert_fa(msb_dividend == msb_divisor);
+	/* Check rounding */
+	if (msb > prec) {
+		if (_tt_round(_tt_dec_get_dig(dst->_dig, 1) & 1,
+				_tt_dec_get_dig(dst->_dig, 0), 0)) {
+			const _tt_dec_word ten = 10;
+			msb = add_digs(dst->_dig, msb, &ten, 2);
+		}
+		adj = msb - prec;
+		msb = shift_digs(dst->_dig, dst->_digsz, dst->_dig, msb, -adj);
+		dst->_exp += adj;
+		ret = TT_APN_EROUNDED;
 	}
+	dst->_msb = msb;
 
-	/* Remove common trailing zeros */
-	while (1) {
-		if (msb_dividend <= 9 || msb_divisor <= 9)
-			break;
-		if (dividend[0] || divisor[0])
-			break;
-		const int sz_dividend = (msb_dividend + 8) / 9 * 4;
-		const int sz_divisor = (msb_divisor + 8) / 9 * 4;
-		msb_dividend = shift_digs(dividend, sz_dividend,
-				dividend, msb_dividend, -9);
-		msb_divisor = shift_digs(divisor, sz_divisor,
-				divisor, msb_divisor, -9);
-	}
-
-	int msb_result = 1;
-	uint *result = quotient->_dig32;
-	while (1) {
-		tt_assert_fa(msb_result <= (quotient->_prec + 1));
-
-		/* Repeat sub divisor from dividend till remainder < divisor */
-		int r;
-		for (r = 1; r < 10; r++) {
-			msb_dividend = sub_digs(dividend, dividend, msb_dividend,
-					divisor, msb_divisor);
-			if ((msb_dividend < msb_divisor) ||
-					(msb_dividend == msb_divisor &&
-					 cmp_digs(dividend, msb_dividend,
-						 divisor, msb_divisor) < 0))
-				break;
+	return ret;
+}
+
+/* Check if dropping digits [0, drop) of dig rounds kept digits up
+ * - odd: lowest kept digit is odd
+ * - all dropped digits count, "5" followed by non zero digits is above half
+ * - rnd: rounding method, 0 - method of calling thread
+ * - set *inexact if non zero digits dropped
+ */
+static bool round_up(const _tt_dec_word *dig, int drop, int odd, int rnd,
+		bool *inexact)
+{
+	const uint d = _tt_dec_get_dig(dig, drop - 1);
+	const bool sticky = _tt_dec_any_dig(dig, drop - 1);
+
+	*inexact = d || sticky;
+	return _tt_round(odd, d == 5 && sticky ? 6 : d, rnd);
+}
+
+/* Round dig[] of *msb digits to at most digs digits in place
+ * - dig must have room for a carry word
+ * - update *msb, set *inexact if non zero digits dropped, return exponent
+ *   adjust
+ */
+static int round_digs(_tt_dec_word *dig, uint sz, int *msb, int digs,
+		bool *inexact)
+{
+	int drop = *msb - digs;
+
+	*inexact = false;
+	if (drop <= 0)
+		return 0;
+
+	const bool up = round_up(dig, drop, drop < *msb &&
+			(_tt_dec_get_dig(dig, drop) & 1), 0, inexact);
+	int m = shift_digs(dig, sz, dig, *msb, -drop);
+	if (up) {
+		const _tt_dec_word one = 1;
+		m = add_digs(dig, m, &one, 1);
+		if (m > digs) {
+			/* 99...9 + 1 */
+			m = shift_digs(dig, sz, dig, m, -1);
+			drop++;
 		}
-		tt_assert_fa(r < 10 && cmp_digs(dividend, msb_dividend,
-					divisor, msb_divisor) < 0);
+	}
+	*msb = m;
 
-		/* Store quotient */
-		tt_assert_fa(result[0] % 10 == 0);
-		result[0] += r;
+	return drop;
+}
 
-		/* Precision+rounding reached or residue is zero */
-		if ((msb_result > quotient->_prec) ||
-				(msb_dividend == 1 && dividend[0] == 0))
-			break;
+/* Round dec to at most digs digits in place with rounding method of calling
+ * thread, return TT_APN_EROUNDED if non zero digits dropped
+ */
+int _tt_dec_round(struct tt_dec *dec, int digs)
+{
+	bool inexact;
 
-		/* Get highest digit */
-		top_dividend = _tt_dec_get_dig(dividend, msb_dividend-1);
-		top_divisor = _tt_dec_get_dig(divisor, msb_divisor-1);
-		tt_assert_fa(top_divisor && top_dividend);
+	dec->_exp += round_digs(dec->_dig, dec->_digsz, &dec->_msb, digs,
+			&inexact);
+	return inexact ? TT_APN_EROUNDED : 0;
+}
 
-		/* Make dividend/divisor within [1, 10)
-		 * - dividend is less than divisor now
-		 */
-		adj = msb_dividend - msb_divisor;
-		if (adj < 0)
-			msb_dividend = shift_digs(dividend, 0,
-					dividend, msb_dividend, -adj);
-		if (cmp_digs(dividend, msb_dividend, divisor, msb_divisor) < 0) {
-			adj--;
-			msb_dividend = shift_digs(dividend, 0,
-					dividend, msb_dividend, 1);
-			tt_assert_fa(msb_dividend == msb_divisor + 1);
-		} else {
-			tt_assert_fa(msb_dividend == msb_divisor);
+/* Check if dec with error decides rounding to prec digits
+ * - digits below position err are unreliable, error below 10^err units of
+ *   digit 0, err may be negative if dec holds fewer digits than it is exact to
+ * - all methods round to nearest, unsafe if dropped digits are too close
+ *   to half: 50...0x or 49...9x
+ */
+bool _tt_dec_round_safe(const struct tt_dec *dec, int prec, int err)
+{
+	const int drop = dec->_msb - prec;
+	if (drop <= 0)
+		return true;
+	if (drop - 1 <= err)
+		return false;
+
+	const uint d = _tt_dec_get_dig(dec->_dig, drop - 1);
+	if (d != 4 && d != 5)
+		return true;
+
+	const uint rest = d == 5 ? 0 : 9;
+	for (int i = drop - 2; i >= err; i--)
+		if ((i >= 0 ? _tt_dec_get_dig(dec->_dig, i) : 0) != rest)
+			return true;
+
+	return false;
+}
+
+/* Round inexact dec to at most digs digits in place
+ * - dec is within 10 units of its digit 0 from the exact result
+ * - if that leaves rounding undecided, cmp() gets half way between the two
+ *   candidates and sets *dir to sign of exact result minus it
+ * - return TT_APN_EROUNDED or error code
+ */
+int _tt_dec_round_inexact(struct tt_dec *dec, int digs,
+		int (*cmp)(const struct tt_dec *half, void *arg, int *dir),
+		void *arg)
+{
+	const int drop = dec->_msb - digs;
+	if (drop <= 0 || _tt_dec_round_safe(dec, digs, 1)) {
+		_tt_dec_round(dec, digs);
+		return TT_APN_EROUNDED;
+	}
+
+	/* Kept digits followed by 5, room for one more digit and carry */
+	const int words = _tt_dec_words(dec->_msb) + 1;
+	_tt_dec_word *tmp = _tt_dec_scratch(dec, words);
+	if (!tmp)
+		return TT_ENOMEM;
+	const uint sz = words * _tt_dec_word_sz;
+	int msb = shift_digs(tmp, sz, dec->_dig, dec->_msb, -(drop - 1));
+	tmp[0] += 5 - tmp[0] % 10;
+
+	struct tt_dec half = *dec;
+	half._dig = tmp;
+	half._msb = msb;
+	half._exp = dec->_exp + drop - 1;
+
+	int dir;
+	int ret = cmp(&half, arg, &dir);
+	if (ret)
+		return ret;
+
+	/* Nudge magnitude of half way by one unit below, if not exact */
+	const _tt_dec_word one = 1;
+	if (dec->_sign)
+		dir = -dir;
+	msb = shift_digs(tmp, sz, tmp, msb, 1);
+	if (dir > 0)
+		msb = add_digs(tmp, msb, &one, 1);
+	else if (dir < 0)
+		msb = sub_digs(tmp, tmp, msb, &one, 1);
+
+	bool inexact;
+	dec->_exp += drop - 2 + round_digs(tmp, sz, &msb, digs, &inexact);
+	memset(dec->_dig, 0, dec->_digsz);
+	memcpy(dec->_dig, tmp, _tt_dec_words(msb) * _tt_dec_word_sz);
+	dec->_msb = msb;
+
+	return TT_APN_EROUNDED;
+}
+
+/* dst = src rounded to precision of dst, see _tt_dec_round() */
+int _tt_dec_copy(struct tt_dec *dst, const struct tt_dec *src)
+{
+	if (dst == src)
+		return _tt_dec_round(dst, dst->_prec);
+
+	dst->_sign = src->_sign;
+	dst->_inf_nan = src->_inf_nan;
+	dst->_exp = src->_exp;
+	memset(dst->_dig, 0, dst->_digsz);
+	if (src->_msb <= dst->_prec) {
+		memcpy(dst->_dig, src->_dig,
+				_tt_dec_words(src->_msb) * _tt_dec_word_sz);
+		dst->_msb = src->_msb;
+		return 0;
+	}
+
+	/* Round in scratch of dst, one more word for carry */
+	const int words = _tt_dec_words(src->_msb) + 1;
+	_tt_dec_word *tmp = _tt_dec_scratch(dst, words);
+	if (!tmp)
+		return TT_ENOMEM;
+	memcpy(tmp, src->_dig, (words - 1) * _tt_dec_word_sz);
+
+	int msb = src->_msb;
+	bool inexact;
+	dst->_exp += round_digs(tmp, words * _tt_dec_word_sz, &msb,
+			dst->_prec, &inexact);
+	memcpy(dst->_dig, tmp, _tt_dec_words(msb) * _tt_dec_word_sz);
+	dst->_msb = msb;
+
+	return inexact ? TT_APN_EROUNDED : 0;
+}
+
+/* dst = src with exponent exp, rounded by method rnd
+ * - digits are shifted from src to dst directly, no scratch is used
+ * - return digits of result, dst->_prec + 1 if rounding carries into a
+ *   new digit, or -1 if digits kept do not fit dst and dst is untouched
+ */
+static int quantize(struct tt_dec *dst, const struct tt_dec *src, int exp,
+		int rnd, bool *inexact)
+{
+	const bool zero = _tt_dec_is_zero(src);
+	const int shift = src->_exp - exp;
+	int msb = src->_msb;
+
+	*inexact = false;
+	if (!zero && msb + shift > dst->_prec)
+		return -1;
+
+	bool up = false;
+	if (shift < 0 && !zero) {
+		const int drop = -shift;
+		if (drop <= msb)
+			up = round_up(src->_dig, drop, drop < msb &&
+					(_tt_dec_get_dig(src->_dig, drop) & 1),
+					rnd, inexact);
+		else
+			*inexact = true;	/* Below tenth of unit */
+	}
+
+	if (dst != src)
+		memset(dst->_dig, 0, dst->_digsz);
+	if (!zero)
+		msb = shift_digs(dst->_dig, dst->_digsz, src->_dig, msb, shift);
+	if (up) {
+		const _tt_dec_word one = 1;
+		msb = add_digs(dst->_dig, msb, &one, 1);
+	}
+
+	dst->_sign = src->_sign;
+	dst->_inf_nan = 0;
+	dst->_exp = exp;
+	return msb;
+}
+
+/* Zero with positive exponent is not allowed */
+static void fix_zero(struct tt_dec *dec)
+{
+	if (dec->_exp > 0 && _tt_dec_is_zero(dec))
+		dec->_exp = 0;
+}
+
+int tt_dec_quantize(struct tt_dec *dst, const struct tt_dec *src, int exp,
+		int rnd)
+{
+	_tt_stat_func(TT_STAT_DEC_QUANTIZE);
+	tt_assert(rnd < TT_ROUND_MAX);
+
+	if (src->_inf_nan) {
+		dst->_inf_nan = TT_DEC_NAN;
+		return TT_APN_EINVAL;
+	}
+
+	bool inexact;
+	const int msb = quantize(dst, src, exp, rnd, &inexact);
+	if (msb < 0 || msb > dst->_prec) {
+		dst->_inf_nan = TT_DEC_NAN;
+		return TT_APN_EINVAL;
+	}
+	dst->_msb = msb;
+	fix_zero(dst);
+
+	return inexact ? TT_APN_EROUNDED : 0;
+}
+
+int tt_dec_rescale(struct tt_dec *dst, const struct tt_dec *src,
+		const struct tt_dec *ref, int rnd)
+{
+	if (ref->_inf_nan) {
+		dst->_inf_nan = TT_DEC_NAN;
+		return TT_APN_EINVAL;
+	}
+
+	return tt_dec_quantize(dst, src, ref->_exp, rnd);
+}
+
+int tt_dec_reduce(struct tt_dec *dst, const struct tt_dec *src)
+{
+	_tt_stat_func(TT_STAT_DEC_REDUCE);
+
+	if (src->_inf_nan) {
+		dst->_sign = src->_sign;
+		dst->_inf_nan = src->_inf_nan;
+		return src->_inf_nan == TT_DEC_NAN ? TT_APN_EINVAL : 0;
+	}
+	if (_tt_dec_is_zero(src)) {
+		const int sign = src->_sign;
+		_tt_dec_zero(dst);
+		dst->_sign = sign;
+		return 0;
+	}
+
+	/* Drop trailing zeros, or round to precision of dst */
+	int drop = _tt_dec_trailing_zeros(src);
+	if (src->_msb - drop > dst->_prec)
+		drop = src->_msb - dst->_prec;
+
+	bool inexact;
+	dst->_msb = quantize(dst, src, src->_exp + drop, 0, &inexact);
+
+	/* Rounding may leave zeros, 99...9 carries to 10...0 */
+	drop = _tt_dec_trailing_zeros(dst);
+	dst->_msb = shift_digs(dst->_dig, dst->_digsz, dst->_dig, dst->_msb,
+			-drop);
+	dst->_exp += drop;
+	fix_zero(dst);
+
+	return inexact ? TT_APN_EROUNDED : 0;
+}
+
+/* Terms more than this many digits below the largest one are first added
+ * inexactly, their dropped digits are sticky for rounding
+ */
+#define DOT_WINDOW	65536
+
+/* Nonzero term i of a[0] * b[0] + ... or a[0] + ..., b == NULL for sum */
+static inline bool dot_term(struct tt_dec **a, struct tt_dec **b, int i,
+		int *lo, int *digs, int *sign)
+{
+	const struct tt_dec *x = a[i], *y = b ? b[i] : NULL;
+
+	if (_tt_dec_is_zero(x) || (y && _tt_dec_is_zero(y)))
+		return false;
+	*lo = x->_exp + (y ? y->_exp : 0);
+	*digs = x->_msb + (y ? y->_msb : 0);
+	*sign = x->_sign ^ (y ? y->_sign : 0);
+	return true;
+}
+
+#ifdef __SIZEOF_INT128__
+/* Sum of terms in two 128-bit accumulators, one of each sign
+ * - all terms span at most FAST_DIGS digits with carries of n additions
+ * - return 0 on success, -1 to fall back if result needs rounding
+ */
+static int dot_fast(struct tt_dec *dst, struct tt_dec **a, struct tt_dec **b,
+		int n, int bottom)
+{
+	__uint128_t acc[2] = { 0, 0 };
+	int lo, digs, sign;
+
+	for (int i = 0; i < n; i++) {
+		if (!dot_term(a, b, i, &lo, &digs, &sign))
+			continue;
+		__uint128_t v = get_u128(a[i]);
+		if (b)
+			v *= get_u128(b[i]);
+		acc[sign] += v * pow10_128[lo - bottom];
+	}
+
+	sign = acc[1] > acc[0];
+	const __uint128_t v = sign ? acc[1] - acc[0] : acc[0] - acc[1];
+	const int msb = u128_digs(v);
+	if (msb > dst->_prec)
+		return -1;
+
+	_tt_stat_count(TT_STAT_DEC_FAST);
+	put_u128(dst, v, msb);
+	dst->_sign = v ? sign : 0;
+	dst->_inf_nan = 0;
+	dst->_exp = v ? bottom : _tt_min(bottom, 0);
+
+	return 0;
+}
+#endif
+
+/* Add terms to two accumulators in scratch of dst, one of each sign,
+ * subtract and round once
+ * - accumulators hold digits [bottom, top) of terms, with carries
+ * - digits below bottom are dropped and jammed to lowest digit, set *retry
+ *   and leave dst untouched if that fails to decide rounding, or if terms
+ *   of both signs are dropped, which may cancel exactly
+ */
+static int dot_words(struct tt_dec *dst, struct tt_dec **a, struct tt_dec **b,
+		int n, int bottom, int top, int maxd, bool *retry)
+{
+	int lo, digs, sign;
+
+	/* Accumulators, then product and shifted term, one carry word each */
+	const int words = _tt_dec_words(top - bottom + 10) + 1;
+	const int tw = _tt_dec_words(maxd) + 2;
+	_tt_dec_word *acc[2];
+	acc[0] = _tt_dec_scratch(dst, words * 2 + tw * 2);
+	if (!acc[0])
+		return TT_ENOMEM;
+	acc[1] = acc[0] + words;
+	_tt_dec_word *prod = acc[1] + words, *sh = prod + tw;
+
+	bool jam[2] = { false, false };
+	for (int i = 0; i < n; i++) {
+		if (!dot_term(a, b, i, &lo, &digs, &sign))
+			continue;
+
+		const _tt_dec_word *d = a[i]->_dig;
+		if (b) {
+			memset(prod, 0, tw * _tt_dec_word_sz);
+			digs = mul_digs(prod, a[i]->_dig, a[i]->_msb,
+					b[i]->_dig, b[i]->_msb);
+			if (digs < 0)
+				return digs;
+			d = prod;
 		}
-		tt_assert_fa(adj < 0);
-		adj = -adj;
 
-		/* Append zero to quotient */
-		int prec_left = quotient->_prec - msb_result;
-		if (adj > (prec_left+1)) {
-			/* Precision+rounding reached */
-			msb_result = shift_digs(result, 0,
-					result, msb_result, prec_left);
-			quotient->_exp -= prec_left;
-			ret = TT_APN_EROUNDED;
-			break;
+		/* Drop digits below accumulators */
+		int off = lo - bottom;
+		if (off < 0) {
+			jam[sign] |= _tt_dec_any_dig(d, _tt_min(-off, digs));
+			if (-off >= digs)
+				continue;
+			memset(sh, 0, tw * _tt_dec_word_sz);
+			digs = shift_digs(sh, tw * _tt_dec_word_sz, d, digs, off);
+			d = sh;
+			off = 0;
 		}
-		msb_result = shift_digs(result, 0, result, msb_result, adj);
-		quotient->_exp -= adj;
+
+		/* Align to digit offset in word, add at word offset */
+		if (off % _TT_DEC_DIGS) {
+			memset(sh, 0, tw * _tt_dec_word_sz);
+			digs = shift_digs(sh, tw * _tt_dec_word_sz, d, digs,
+					off % _TT_DEC_DIGS);
+			d = sh;
+		}
+		const int w = off / _TT_DEC_DIGS;
+		add_words(acc[sign] + w, words - w, d, _tt_dec_words(digs));
 	}
 
-	/* Check rounding */
-	if (msb_result > quotient->_prec) {
-		if (_tt_round(_tt_dec_get_dig(result, 1) & 1,
-				_tt_dec_get_dig(result, 0), 0)) {
-			const uint ten = 10;
-			msb_result = add_digs(result, msb_result, &ten, 2);
+	if (jam[0] && jam[1]) {
+		*retry = true;
+		return 0;
+	}
+	for (int k = 0; k < 2; k++)
+		if (jam[k])
+			acc[k][0] |= 1;
+
+	sign = cmp_words(acc[1], words, acc[0], words) > 0;
+	sub_words(acc[sign], words, acc[!sign], words);
+	int msb = get_msb(acc[sign], words);
+
+	/* Dropped digits change result below one unit of lowest digit, which
+	 * must be dropped by rounding
+	 */
+	if (jam[0] || jam[1]) {
+		const struct tt_dec r = {
+			._dig = acc[sign],
+			._msb = msb,
+		};
+		if (msb - dst->_prec <= 2 ||
+				!_tt_dec_round_safe(&r, dst->_prec, 1)) {
+			*retry = true;
+			return 0;
 		}
-		adj = msb_result - quotient->_prec;
-		msb_result = shift_digs(result, quotient->_digsz,
-				result, msb_result, -adj);
-		quotient->_exp += adj;
-		ret = TT_APN_EROUNDED;
 	}
 
-	quotient->_msb = msb_result;
+	bool inexact;
+	dst->_inf_nan = 0;
+	dst->_exp = bottom + round_digs(acc[sign], words * _tt_dec_word_sz,
+			&msb, dst->_prec, &inexact);
+	dst->_sign = sign;
+	memset(dst->_dig, 0, dst->_digsz);
+	memcpy(dst->_dig, acc[sign], _tt_dec_words(msb) * _tt_dec_word_sz);
+	dst->_msb = msb;
+	if (_tt_dec_is_zero(dst)) {
+		dst->_sign = 0;
+		dst->_exp = _tt_min(dst->_exp, 0);
+	}
 
-	/* Switch buffer if dst overlaps src */
-	if (quotient != dst) {
-		free(dst->_dig32);
-		memcpy(dst, quotient, sizeof(struct tt_dec));
-		free(quotient);
-		quotient = NULL;
+	return inexact || jam[0] || jam[1] ? TT_APN_EROUNDED : 0;
+}
+
+/* dst = a[0] * b[0] + ... + a[n-1] * b[n-1], or a[0] + ... if b is NULL
+ * - dst may share any a[i], b[i], it is only written at last
+ * - terms far below the largest one are added exactly only if rounding is
+ *   not decided without them
+ */
+static int dot_dec(struct tt_dec *dst, struct tt_dec **a, struct tt_dec **b,
+		int n)
+{
+	/* Special values, extent of nonzero terms */
+	int lo_min = INT_MAX, hi_max = INT_MIN, maxd = 0, cnt = 0;
+	int inf = 0, inf_sign = 0;
+	int lo, digs, sign;
+	for (int i = 0; i < n; i++) {
+		const struct tt_dec *x = a[i], *y = b ? b[i] : NULL;
+		if (x->_inf_nan == TT_DEC_NAN || (y && y->_inf_nan == TT_DEC_NAN)) {
+			dst->_inf_nan = TT_DEC_NAN;
+			return TT_APN_EINVAL;
+		}
+		if (x->_inf_nan == TT_DEC_INF || (y && y->_inf_nan == TT_DEC_INF)) {
+			if (!inf)
+				inf_sign = x->_sign ^ (y ? y->_sign : 0);
+			inf = 1;
+			continue;
+		}
+		if (!dot_term(a, b, i, &lo, &digs, &sign))
+			continue;
+		lo_min = _tt_min(lo_min, lo);
+		hi_max = _tt_max(hi_max, lo + digs);
+		maxd = _tt_max(maxd, digs);
+		cnt++;
+	}
+	if (inf) {
+		dst->_inf_nan = TT_DEC_INF;
+		dst->_sign = inf_sign;
+		return TT_APN_EOVERFLOW;
+	}
+	if (cnt == 0) {
+		_tt_dec_zero(dst);
+		return 0;
 	}
 
-out:
-	if (dividend)
-		free(dividend);
-	if (divisor)
-		free(divisor);
-	if (quotient && quotient != dst)
-		tt_dec_free(quotient);
+	const int window = _tt_max(DOT_WINDOW, maxd + dst->_prec);
+	const int bottom = _tt_max(lo_min, hi_max - window);
+
+#ifdef __SIZEOF_INT128__
+	if (hi_max - bottom + 10 <= FAST_DIGS &&
+			dot_fast(dst, a, b, n, bottom) == 0)
+		return 0;
+#endif
+
+	bool retry = false;
+	int ret = dot_words(dst, a, b, n, bottom, hi_max, maxd, &retry);
+	if (retry)
+		ret = dot_words(dst, a, b, n, lo_min, hi_max, maxd, &retry);
 
 	return ret;
 }
 
+/* dst = a[0] * b[0] + ... + a[n-1] * b[n-1], rounded once */
+int tt_dec_dot(struct tt_dec *dst, struct tt_dec **a, struct tt_dec **b, int n)
+{
+	_tt_stat_func(TT_STAT_DEC_DOT);
+	return dot_dec(dst, a, b, n);
+}
+
+/* dst = a[0] + ... + a[n-1], rounded once */
+int tt_dec_sum(struct tt_dec *dst, struct tt_dec **a, int n)
+{
+	_tt_stat_func(TT_STAT_DEC_SUM);
+	return dot_dec(dst, a, NULL, n);
+}
+
 /* Compare abs
  * TODO: Check NaN, Inf
  * - return < 0: src1 < src2
@@ -895,25 +1925,38 @@ int tt_dec_cmp_abs(const struct tt_dec *src1, const struct tt_dec *src2)
 	if (ret)
 		return ret;
 
-	uint *dig1 = src1->_dig32, *dig2 = src2->_dig32;
-	const int uints = (_tt_max(msb1, msb2) + 8) / 9 * 4;
-
 	/* Align exponent */
 	int adj = src1->_exp - src2->_exp;
+
+#ifdef __SIZEOF_INT128__
+	/* Aligned significands have same digits */
+	if (msb1 <= FAST_DIGS && msb2 <= FAST_DIGS) {
+		__uint128_t v1 = get_u128(src1), v2 = get_u128(src2);
+		if (adj < 0)
+			v2 *= pow10_128[-adj];
+		else
+			v1 *= pow10_128[adj];
+		return v1 < v2 ? -1 : v1 > v2;
+	}
+#endif
+
+	_tt_dec_word *dig1 = src1->_dig, *dig2 = src2->_dig;
+	const int words = _tt_dec_words(_tt_max(msb1, msb2)) + 1;
+
 	if (adj < 0) {
-		dig2 = calloc(uints, 4);
-		msb2 = shift_digs(dig2, 0, src2->_dig32, msb2, -adj);
+		dig2 = calloc(words, _tt_dec_word_sz);
+		msb2 = shift_digs(dig2, 0, src2->_dig, msb2, -adj);
 	} else if (adj > 0) {
-		dig1 = calloc(uints, 4);
-		msb1 = shift_digs(dig1, 0, src1->_dig32, msb1, adj);
+		dig1 = calloc(words, _tt_dec_word_sz);
+		msb1 = shift_digs(dig1, 0, src1->_dig, msb1, adj);
 	}
 	tt_assert_fa(msb1 == msb2);
 
 	ret = cmp_digs(dig1, msb1, dig2, msb2);
 
-	if (dig1 != src1->_dig32)
+	if (dig1 != src1->_dig)
 		free(dig1);
-	if (dig2 != src2->_dig32)
+	if (dig2 != src2->_dig)
 		free(dig2);
 
 	return ret;
@@ -921,6 +1964,7 @@ int tt_dec_cmp_abs(const struct tt_dec *src1, const struct tt_dec *src2)
 
 int tt_dec_cmp(const struct tt_dec *src1, const struct tt_dec *src2)
 {
+	_tt_stat_func(TT_STAT_DEC_CMP);
 	int ret;
 
 	if (src1->_sign != src2->_sign) {
@@ -1 +1 @@
-obj-y += decimal.o mach.o str.o basic.o
+obj-y += decimal.o mach.o str.o basic.o ntt.o ieee.o pow10.o ctx.o const.o func.o
@@ -0,0 +1,586 @@
+/* Mathematical constants to any precision
+ *
+ * Each constant is summed exactly as a rational series by binary splitting
+ * over integers, then scaled and converted to decimal:
+ * - pi: Chudnovsky, 14 digits per term
+ * - e: sum 1/k!
+ * - ln(2) = 18 atanh(1/26) - 2 atanh(1/4801) + 8 atanh(1/8749)
+ * - ln(10) = 46 atanh(1/31) + 34 atanh(1/49) + 20 atanh(1/161)
+ *
+ * Top levels of splitting trees and independent series run in threads.
+ * The most precise value computed so far is cached per constant, requests of
+ * lower precision are rounded from it.
+ *
+ * Copyright (C) 2016 Yibo Cai
+ */
+#include <tt/tt.h>
+#include <tt/apn/decimal.h>
+#include <tt/apn/integer.h>
+#include <common/lib.h>
+#include <common/stats.h>
+#include "decimal.h"
+
+#include <math.h>
+#include <pthread.h>
+
+/* Extra digits computed over requested precision, doubled if not enough to
+ * decide rounding
+ */
+#define CONST_GUARD	8
+
+/* Computed values are below 10^CONST_ERR_DIGS units of last digit off */
+#define CONST_ERR_DIGS	2
+
+/* Split terms in two threads above this many terms, up to 2^depth threads */
+#define BS_PAR_CROSS	2000
+#define BS_PAR_DEPTH	2
+
+/* Chudnovsky: 640320^3 / 24 */
+#define CHUD_C3_24	10939058860032000ULL
+
+/* Series S = sum a(k) / b(k) * p(0)...p(k) / q(0)...q(k)
+ * - binary splitting of terms [a, b) gets integers
+ *     P = p(a)...p(b-1), Q = q(a)...q(b-1), B = b(a)...b(b-1)
+ *     T = B * Q * S[a, b), S[a, b) = sum of terms k in [a, b) / P[0, a)
+ * - series without p(k) or b(k) (all ones) leave P or B untouched
+ */
+struct bs {
+	struct tt_int *p, *q, *b, *t;
+};
+
+struct series {
+	/* Set P, Q, B, T of single term k */
+	int (*term)(struct bs *r, uint k, uint x);
+	uint x;		/* Argument of term() */
+	bool has_p, has_b;
+};
+
+static int bs_alloc(struct bs *r)
+{
+	r->p = tt_int_alloc();
+	r->q = tt_int_alloc();
+	r->b = tt_int_alloc();
+	r->t = tt_int_alloc();
+	return r->p && r->q && r->b && r->t ? 0 : TT_ENOMEM;
+}
+
+static void bs_free(struct bs *r)
+{
+	if (r->p)
+		tt_int_free(r->p);
+	if (r->q)
+		tt_int_free(r->q);
+	if (r->b)
+		tt_int_free(r->b);
+	if (r->t)
+		tt_int_free(r->t);
+}
+
+/* x * atanh(1/x) = sum 1 / ((2k+1) * x^2k) */
+static int atanh_term(struct bs *r, uint k, uint x)
+{
+	tt_int_from_uint(r->t, 1);
+	tt_int_from_uint(r->b, 2 * (uint64_t)k + 1);
+	return tt_int_from_uint(r->q, k ? (uint64_t)x * x : 1);
+}
+
+/* e = sum 1 / k! */
+static int e_term(struct bs *r, uint k, uint unused)
+{
+	tt_int_from_uint(r->t, 1);
+	return tt_int_from_uint(r->q, k ? k : 1);
+}
+
+/* 426880 * sqrt(10005) / pi = sum a(k) * p(0)...p(k) / q(0)...q(k)
+ * - a(k) = 13591409 + 545140134k
+ * - p(k) = -(6k-5)(2k-1)(6k-1), q(k) = k^3 * 640320^3 / 24, p(0) = q(0) = 1
+ */
+static int chud_term(struct bs *r, uint k, uint unused)
+{
+	int ret;
+
+	if (k == 0) {
+		tt_int_from_uint(r->p, 1);
+		tt_int_from_uint(r->q, 1);
+		return tt_int_from_uint(r->t, 13591409);
+	}
+
+	const uint64_t k6 = 6 * (uint64_t)k;
+	tt_int_from_sint(r->p, -(int64_t)(k6 - 5));
+	ret = tt_int_mul_ui(r->p, r->p, 2 * (uint64_t)k - 1);
+	if (ret)
+		return ret;
+	ret = tt_int_mul_ui(r->p, r->p, k6 - 1);
+	if (ret)
+		return ret;
+
+	tt_int_from_uint(r->q, (uint64_t)k * k);
+	ret = tt_int_mul_ui(r->q, r->q, k);
+	if (ret)
+		return ret;
+	ret = tt_int_mul_ui(r->q, r->q, CHUD_C3_24);
+	if (ret)
+		return ret;
+
+	ret = tt_int_mul_ui(r->t, r->p, 545140134 * (uint64_t)k + 13591409);
+	return ret;
+}
+
+static int bs_split(struct bs *r, const struct series *s, uint a, uint b,
+		int depth);
+
+struct bs_arg {
+	struct bs *r;
+	const struct series *s;
+	uint a, b;
+	int depth;
+	int ret;
+};
+
+static void *bs_thread(void *arg)
+{
+	struct bs_arg *ba = arg;
+
+	ba->ret = bs_split(ba->r, ba->s, ba->a, ba->b, ba->depth);
+	return NULL;
+}
+
+/* T = Tl * Br * Qr + Bl * Pl * Tr, P = Pl * Pr, Q = Ql * Qr, B = Bl * Br
+ * - r holds left half, rr right half
+ */
+static int bs_merge(struct bs *r, struct bs *rr, const struct series *s)
+{
+	int ret;
+
+	ret = tt_int_mul(r->t, r->t, rr->q);
+	if (ret)
+		return ret;
+	if (s->has_b) {
+		ret = tt_int_mul(r->t, r->t, rr->b);
+		if (ret)
+			return ret;
+		ret = tt_int_mul(rr->t, rr->t, r->b);
+		if (ret)
+			return ret;
+		ret = tt_int_mul(r->b, r->b, rr->b);
+		if (ret)
+			return ret;
+	}
+	if (s->has_p) {
+		ret = tt_int_addmul(r->t, r->p, rr->t);
+		if (ret)
+			return ret;
+		ret = tt_int_mul(r->p, r->p, rr->p);
+	} else {
+		ret = tt_int_add(r->t, r->t, rr->t);
+	}
+	if (ret)
+		return ret;
+
+	return tt_int_mul(r->q, r->q, rr->q);
+}
+
+/* Split terms [a, b), left half in another thread if big enough */
+static int bs_split(struct bs *r, const struct series *s, uint a, uint b,
+		int depth)
+{
+	int ret;
+
+	if (b - a == 1)
+		return s->term(r, a, s->x);
+
+	struct bs rr;
+	ret = bs_alloc(&rr);
+	if (ret)
+		goto out;
+
+	const uint m = (a + b) / 2;
+	if (depth && b - a >= BS_PAR_CROSS) {
+		struct bs_arg ba = {
+			.r = r,
+			.s = s,
+			.a = a,
+			.b = m,
+			.depth = depth - 1,
+		};
+		pthread_t thread;
+		bool threaded = !pthread_create(&thread, NULL, bs_thread, &ba);
+		if (!threaded)
+			bs_thread(&ba);
+
+		ret = bs_split(&rr, s, m, b, depth - 1);
+
+		if (threaded)
+			pthread_join(thread, NULL);
+		if (ret == 0)
+			ret = ba.ret;
+	} else {
+		ret = bs_split(r, s, a, m, 0);
+		if (ret == 0)
+			ret = bs_split(&rr, s, m, b, 0);
+	}
+	if (ret == 0)
+		ret = bs_merge(r, &rr, s);
+
+out:
+	bs_free(&rr);
+	return ret;
+}
+
+/* 10^digs */
+static int pow10_int(struct tt_int *ti, int digs)
+{
+	tt_int_from_uint(ti, 10);
+	return tt_int_pow(ti, ti, digs);
+}
+
+/* v = floor(atanh(1/x) * 10^digs) */
+static int atanh_compute(struct tt_int *v, uint x, int digs)
+{
+	const struct series s = {
+		.term = atanh_term,
+		.x = x,
+		.has_b = true,
+	};
+	struct bs r;
+	int ret = bs_alloc(&r);
+	if (ret)
+		goto out;
+
+	/* Truncation error below x^-2n */
+	const uint n = digs / (2 * log10(x)) + 2;
+	ret = bs_split(&r, &s, 0, n, BS_PAR_DEPTH);
+	if (ret)
+		goto out;
+
+	/* T * 10^digs / (B * Q * x) */
+	ret = pow10_int(v, digs);
+	if (ret)
+		goto out;
+	ret = tt_int_mul(r.t, r.t, v);
+	if (ret)
+		goto out;
+	ret = tt_int_mul(r.b, r.b, r.q);
+	if (ret)
+		goto out;
+	ret = tt_int_mul_ui(r.b, r.b, x);
+	if (ret)
+		goto out;
+	ret = tt_int_div(v, NULL, r.t, r.b);
+
+out:
+	bs_free(&r);
+	return ret;
+}
+
+struct atanh_arg {
+	struct tt_int *v;
+	uint x;
+	int digs;
+	int ret;
+};
+
+static void *atanh_thread(void *arg)
+{
+	struct atanh_arg *aa = arg;
+
+	aa->ret = atanh_compute(aa->v, aa->x, aa->digs);
+	return NULL;
+}
+
+/* v = sum coef[i] * atanh(1/x[i]) * 10^digs, each series in its own thread
+ * - error below sum of |coef[i]| units
+ */
+#define MACHIN_TERMS	3
+static int machin_compute(struct tt_int *v, const uint *x, const int *coef,
+		int digs)
+{
+	struct atanh_arg aa[MACHIN_TERMS] = { { NULL } };
+	pthread_t thread[MACHIN_TERMS];
+	bool threaded[MACHIN_TERMS] = { false };
+	int ret = 0;
+
+	for (int i = 0; i < MACHIN_TERMS; i++) {
+		aa[i].v = tt_int_alloc();
+		if (!aa[i].v) {
+			ret = TT_ENOMEM;
+			goto out;
+		}
+		aa[i].x = x[i];
+		aa[i].digs = digs;
+	}
+
+	for (int i = 1; i < MACHIN_TERMS; i++) {
+		threaded[i] = !pthread_create(&thread[i], NULL, atanh_thread,
+				&aa[i]);
+		if (!threaded[i])
+			atanh_thread(&aa[i]);
+	}
+	atanh_thread(&aa[0]);
+	for (int i = 1; i < MACHIN_TERMS; i++)
+		if (threaded[i])
+			pthread_join(thread[i], NULL);
+
+	tt_int_from_uint(v, 0);
+	for (int i = 0; i < MACHIN_TERMS && ret == 0; i++) {
+		ret = aa[i].ret;
+		if (ret)
+			break;
+		ret = tt_int_mul_ui(aa[i].v, aa[i].v, abs(coef[i]));
+		if (ret)
+			break;
+		if (coef[i] > 0)
+			ret = tt_int_add(v, v, aa[i].v);
+		else
+			ret = tt_int_sub(v, v, aa[i].v);
+	}
+
+out:
+	for (int i = 0; i < MACHIN_TERMS; i++)
+		if (aa[i].v)
+			tt_int_free(aa[i].v);
+	return ret;
+}
+
+static int ln2_compute(struct tt_int *v, int digs)
+{
+	static const uint x[MACHIN_TERMS] = { 26, 4801, 8749 };
+	static const int coef[MACHIN_TERMS] = { 18, -2, 8 };
+
+	return machin_compute(v, x, coef, digs);
+}
+
+static int ln10_compute(struct tt_int *v, int digs)
+{
+	static const uint x[MACHIN_TERMS] = { 31, 49, 161 };
+	static const int coef[MACHIN_TERMS] = { 46, 34, 20 };
+
+	return machin_compute(v, x, coef, digs);
+}
+
+/* v = floor(e * 10^digs), error below 2 units */
+static int e_compute(struct tt_int *v, int digs)
+{
+	const struct series s = {
+		.term = e_term,
+	};
+	struct bs r;
+	int ret = bs_alloc(&r);
+	if (ret)
+		goto out;
+
+	/* Truncation error below 2 / n! < 10^-digs */
+	uint n = 1;
+	for (double lg = 0; lg < digs + 1; n++)
+		lg += log10(n);
+	ret = bs_split(&r, &s, 0, n, BS_PAR_DEPTH);
+	if (ret)
+		goto out;
+
+	/* T * 10^digs / Q */
+	ret = pow10_int(v, digs);
+	if (ret)
+		goto out;
+	ret = tt_int_mul(r.t, r.t, v);
+	if (ret)
+		goto out;
+	ret = tt_int_div(v, NULL, r.t, r.q);
+
+out:
+	bs_free(&r);
+	return ret;
+}
+
+struct sqrt_arg {
+	struct tt_int *v;
+	int digs;
+	int ret;
+};
+
+/* v = floor(sqrt(10005) * 10^digs) */
+static void *sqrt_thread(void *arg)
+{
+	struct sqrt_arg *sa = arg;
+
+	sa->ret = pow10_int(sa->v, sa->digs * 2);
+	if (sa->ret == 0)
+		sa->ret = tt_int_mul_ui(sa->v, sa->v, 10005);
+	if (sa->ret == 0)
+		sa->ret = tt_int_sqrt(sa->v, sa->v);
+	return NULL;
+}
+
+/* v = floor(426880 * sqrt(10005) * 10^digs * Q / T), sqrt in another thread */
+static int pi_compute(struct tt_int *v, int digs)
+{
+	const struct series s = {
+		.term = chud_term,
+		.has_p = true,
+	};
+	struct sqrt_arg sa = {
+		.v = v,
+		.digs = digs,
+	};
+	struct bs r;
+	int ret = bs_alloc(&r);
+	if (ret)
+		goto out;
+
+	pthread_t thread;
+	bool threaded = !pthread_create(&thread, NULL, sqrt_thread, &sa);
+	if (!threaded)
+		sqrt_thread(&sa);
+
+	/* 14.18 digits per term */
+	const uint n = digs / 14.18 + 2;
+	ret = bs_split(&r, &s, 0, n, BS_PAR_DEPTH);
+
+	if (threaded)
+		pthread_join(thread, NULL);
+	if (ret == 0)
+		ret = sa.ret;
+	if (ret)
+		goto out;
+
+	ret = tt_int_mul(r.q, r.q, v);
+	if (ret)
+		goto out;
+	ret = tt_int_mul_ui(r.q, r.q, 426880);
+	if (ret)
+		goto out;
+	ret = tt_int_div(v, NULL, r.q, r.t);
+
+out:
+	bs_free(&r);
+	return ret;
+}
+
+struct const_cache {
+	/* v = constant * 10^digs, error below 10^CONST_ERR_DIGS */
+	int (*compute)(struct tt_int *v, int digs);
+	int int_digs;		/* Digits before point */
+	int digs;		/* Digits after point of cached value */
+	struct tt_dec *dec;
+	pthread_mutex_t lock;
+};
+
+enum {
+	CONST_PI,
+	CONST_E,
+	CONST_LN2,
+	CONST_LN10,
+	CONST_MAX,
+};
+
+static struct const_cache caches[CONST_MAX] = {
+	[CONST_PI] = {
+		.compute = pi_compute,
+		.int_digs = 1,
+		.lock = PTHREAD_MUTEX_INITIALIZER,
+	},
+	[CONST_E] = {
+		.compute = e_compute,
+		.int_digs = 1,
+		.lock = PTHREAD_MUTEX_INITIALIZER,
+	},
+	[CONST_LN2] = {
+		.compute = ln2_compute,
+		.int_digs = 0,
+		.lock = PTHREAD_MUTEX_INITIALIZER,
+	},
+	[CONST_LN10] = {
+		.compute = ln10_compute,
+		.int_digs = 1,
+		.lock = PTHREAD_MUTEX_INITIALIZER,
+	},
+};
+
+/* Replace cached value with one of digs digits after point */
+static int cache_update(struct const_cache *c, int digs)
+{
+	struct tt_dec *dec = NULL;
+	struct tt_int *v = tt_int_alloc();
+	char *s = NULL;
+	int ret = TT_ENOMEM;
+	if (!v)
+		goto out;
+
+	ret = c->compute(v, digs);
+	if (ret)
+		goto out;
+	ret = tt_int_to_string(v, &s, 10);
+	if (ret)
+		goto out;
+
+	ret = TT_ENOMEM;
+	dec = tt_dec_alloc(c->int_digs + digs);
+	if (!dec)
+		goto out;
+	ret = tt_dec_from_string(dec, s);
+	if (ret)
+		goto out;
+	dec->_exp -= digs;
+
+	if (c->dec)
+		tt_dec_free(c->dec);
+	c->dec = dec;
+	c->digs = digs;
+	dec = NULL;
+
+out:
+	if (dec)
+		tt_dec_free(dec);
+	free(s);
+	if (v)
+		tt_int_free(v);
+	return ret;
+}
+
+/* dec = constant correctly rounded to precision of dec */
+static int const_get(int id, struct tt_dec *dec)
+{
+	_tt_stat_func(TT_STAT_DEC_CONST);
+	struct const_cache *c = &caches[id];
+	const int prec = dec->_prec;
+	int ret = 0;
+
+	pthread_mutex_lock(&c->lock);
+	for (int guard = CONST_GUARD; ; guard *= 2) {
+		const int digs = prec - c->int_digs + guard;
+		if (!c->dec || c->digs < digs) {
+			ret = cache_update(c, digs);
+			if (ret)
+				break;
+		}
+
+		/* Error position relative to least significant digit */
+		const int err = CONST_ERR_DIGS - c->digs - c->dec->_exp;
+		if (_tt_dec_round_safe(c->dec, prec, err))
+			break;
+	}
+	if (ret == 0)
+		ret = _tt_dec_copy(dec, c->dec);
+	pthread_mutex_unlock(&c->lock);
+
+	return ret;
+}
+
+int tt_dec_pi(struct tt_dec *dec)
+{
+	return const_get(CONST_PI, dec);
+}
+
+int tt_dec_e(struct tt_dec *dec)
+{
+	return const_get(CONST_E, dec);
+}
+
+int tt_dec_ln2(struct tt_dec *dec)
+{
+	return const_get(CONST_LN2, dec);
+}
+
+int _tt_dec_ln10(struct tt_dec *dec)
+{
+	return const_get(CONST_LN10, dec);
+}
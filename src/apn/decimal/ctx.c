@@ -0,0 +1,206 @@
+/* Decimal context: precision, rounding, traps and status flags
+ *
+ * Copyright (C) 2016 Yibo Cai
+ */
+#include <tt/tt.h>
+#include <tt/apn/decimal.h>
+#include <tt/common/round.h>
+#include <common/lib.h>
+#include "decimal.h"
+
+/* Context of each thread, traps all conditions as operations without
+ * context do
+ */
+static __thread struct tt_dec_ctx thread_ctx = {
+	.traps = TT_DEC_F_ALL,
+};
+
+enum { CTX_ADD, CTX_SUB, CTX_MUL, CTX_DIV };
+
+typedef int (*dec_op)(struct tt_dec *dst, const struct tt_dec *src1,
+		const struct tt_dec *src2);
+
+static const dec_op ctx_ops[] = {
+	[CTX_ADD] = tt_dec_add,
+	[CTX_SUB] = tt_dec_sub,
+	[CTX_MUL] = tt_dec_mul,
+	[CTX_DIV] = tt_dec_div,
+};
+
+struct ctx_arg {
+	int op;
+	const struct tt_dec *src1, *src2;
+};
+
+struct tt_dec_ctx *tt_dec_ctx(void)
+{
+	return &thread_ctx;
+}
+
+/* Condition flag of operation result */
+static uint ctx_flag(int ret)
+{
+	switch (ret) {
+	case TT_APN_EROUNDED:
+		return TT_DEC_F_ROUNDED;
+	case TT_APN_EOVERFLOW:
+		return TT_DEC_F_OVERFLOW;
+	case TT_APN_EDIV_0:
+		return TT_DEC_F_DIV_0;
+	case TT_APN_EINVAL:
+	case TT_APN_EDIV_UNDEF:
+		return TT_DEC_F_INVALID;
+	default:
+		return 0;
+	}
+}
+
+/* Sign of exact result minus half way, by fused sums
+ * - add, sub: src1 +/- src2 - half
+ * - mul: src1 * src2 - half
+ * - div: (src1 - half * src2) * sign of src2
+ */
+static int ctx_cmp(const struct tt_dec *half, void *arg, int *dir)
+{
+	const struct ctx_arg *ca = arg;
+	struct tt_dec *a = (struct tt_dec *)ca->src1;
+	struct tt_dec *r = tt_dec_alloc(1), *one = tt_dec_alloc(1);
+	struct tt_dec nhalf = *half, n2 = *ca->src2;
+	int ret = TT_ENOMEM;
+
+	if (!r || !one)
+		goto out;
+	nhalf._sign = !nhalf._sign;
+	n2._sign = !n2._sign;
+
+	if (ca->op == CTX_ADD || ca->op == CTX_SUB) {
+		struct tt_dec *t[] = { a, ca->op == CTX_SUB ? &n2 :
+			(struct tt_dec *)ca->src2, &nhalf };
+		ret = tt_dec_sum(r, t, 3);
+	} else {
+		struct tt_dec *t1[] = { a, (struct tt_dec *)half };
+		struct tt_dec *t2[] = { (struct tt_dec *)ca->src2, one };
+		tt_dec_from_sint(one, -1);
+		if (ca->op == CTX_DIV) {
+			t2[0] = one;
+			t2[1] = &n2;
+			tt_dec_from_uint(one, 1);
+		}
+		ret = tt_dec_dot(r, t1, t2, 2);
+	}
+	if (ret == TT_APN_EROUNDED)
+		ret = 0;
+	if (ret)
+		goto out;
+
+	*dir = _tt_dec_is_zero(r) ? 0 : r->_sign ? -1 : 1;
+	if (ca->op == CTX_DIV && ca->src2->_sign)
+		*dir = -*dir;
+
+out:
+	if (r)
+		tt_dec_free(r);
+	if (one)
+		tt_dec_free(one);
+	return ret;
+}
+
+/* dst = op(src1, src2) rounded once to prec, narrower than dst
+ * - op runs at precision of operands plus guard digits, or of exact product,
+ *   in dst if it is not an operand and wide enough, or else in a temporary
+ * - then rounded to prec, result too close to half way is decided by
+ *   comparing with exact result
+ */
+static int ctx_round(int op, struct tt_dec *dst, const struct tt_dec *src1,
+		const struct tt_dec *src2, int prec)
+{
+	int wprec = _tt_max(prec + TT_DEC_PREC_RND,
+			_tt_max(src1->_msb, src2->_msb));
+	if (op == CTX_MUL)
+		wprec = _tt_max(wprec, src1->_msb + src2->_msb);	/* Exact */
+	struct tt_dec *r = dst;
+	int ret;
+
+	if (wprec > dst->_prec || dst == src1 || dst == src2) {
+		r = tt_dec_alloc(wprec);
+		if (!r)
+			return TT_ENOMEM;
+		ret = ctx_ops[op](r, src1, src2);
+	} else {
+		const int dprec = dst->_prec;
+		*(int*)&dst->_prec = wprec;
+		ret = ctx_ops[op](dst, src1, src2);
+		*(int*)&dst->_prec = dprec;
+	}
+
+	if (ret == 0) {
+		ret = _tt_dec_round(r, prec);
+	} else if (ret == TT_APN_EROUNDED) {
+		struct ctx_arg ca = { .op = op, .src1 = src1, .src2 = src2 };
+		ret = _tt_dec_round_inexact(r, prec, ctx_cmp, &ca);
+	}
+
+	if (r != dst) {
+		const int ret2 = _tt_dec_copy(dst, r);
+		if (ret2 < 0)
+			ret = ret2;
+		tt_dec_free(r);
+	}
+	return ret;
+}
+
+/* Run op with context
+ * - result is rounded once to precision of context if it is narrower than
+ *   dst, see ctx_round()
+ * - rounding method is thread local, switch and restore it
+ * - untrapped conditions leave Inf, NaN or rounded result in dst
+ */
+static int ctx_run(int op, struct tt_dec *dst, const struct tt_dec *src1,
+		const struct tt_dec *src2, struct tt_dec_ctx *ctx)
+{
+	if (ctx == NULL)
+		ctx = &thread_ctx;
+	tt_assert(ctx->rounding < TT_ROUND_MAX);
+
+	const int rnd = ctx->rounding ? tt_set_rounding(ctx->rounding) : 0;
+
+	int ret;
+	if (ctx->prec && ctx->prec < dst->_prec)
+		ret = ctx_round(op, dst, src1, src2, ctx->prec);
+	else
+		ret = ctx_ops[op](dst, src1, src2);
+
+	if (rnd)
+		tt_set_rounding(rnd);
+
+	const uint flag = ctx_flag(ret);
+	ctx->flags |= flag;
+	if (flag && !(ctx->traps & flag))
+		ret = 0;
+
+	return ret;
+}
+
+int tt_dec_add_ctx(struct tt_dec *dst, const struct tt_dec *src1,
+		const struct tt_dec *src2, struct tt_dec_ctx *ctx)
+{
+	return ctx_run(CTX_ADD, dst, src1, src2, ctx);
+}
+
+int tt_dec_sub_ctx(struct tt_dec *dst, const struct tt_dec *src1,
+		const struct tt_dec *src2, struct tt_dec_ctx *ctx)
+{
+	return ctx_run(CTX_SUB, dst, src1, src2, ctx);
+}
+
+int tt_dec_mul_ctx(struct tt_dec *dst, const struct tt_dec *src1,
+		const struct tt_dec *src2, struct tt_dec_ctx *ctx)
+{
+	return ctx_run(CTX_MUL, dst, src1, src2, ctx);
+}
+
+int tt_dec_div_ctx(struct tt_dec *dst, const struct tt_dec *src1,
+		const struct tt_dec *src2, struct tt_dec_ctx *ctx)
+{
+	return ctx_run(CTX_DIV, dst, src1, src2, ctx);
+}
@@ -5,6 +5,7 @@
 #include <tt/tt.h>
 #include <tt/apn/decimal.h>
 #include <common/lib.h>
+#include <common/stats.h>
 #include "decimal.h"
 
 #include <string.h>
@@ -25,36 +26,58 @@ struct tt_dec *tt_dec_alloc(uint prec)
 	int prec_full = prec;
         prec_full += TT_DEC_PREC_RND;	/* Rounding guard */
 	prec_full += TT_DEC_PREC_CRY;	/* Carry digit */
-	prec_full += TT_DEC_PREC_ALN;	/* Align-9 shifting */
+	prec_full += TT_DEC_PREC_ALN;	/* Word aligned shifting */
 
-	/* 9 digits -> 4 bytes */
-	int digsz = prec_full;
-	digsz += 8;
-	digsz /= 9;
+	/* Significand words */
+	const int words = _tt_dec_words(prec_full);
 
 	/* Create decimal */
 	struct tt_dec *dec = calloc(1, sizeof(struct tt_dec));
-	dec->_dig32 = calloc(digsz, 4);
-	if (dec->_dig32 == NULL) {
+	dec->_dig = calloc(words, _tt_dec_word_sz);
+	if (dec->_dig == NULL) {
 		tt_error("Out of memory");
 		free(dec);
 		return NULL;
 	}
 	*(int*)&dec->_prec = prec;
 	*(int*)&dec->_prec_full = prec_full;
-	*(uint*)&dec->_digsz = digsz * 4;
+	*(uint*)&dec->_digsz = words * _tt_dec_word_sz;
 	dec->_msb = 1;
 	tt_debug("Decimal created: %u bytes", dec->_digsz);
+	_tt_stat_bytes(TT_STAT_DEC_ALLOC, dec->_digsz);
 
 	return dec;
 }
 
 void tt_dec_free(struct tt_dec *dec)
 {
-	free(dec->_dig32);
+	free(dec->_dig);
+	free(dec->_tmp);
 	free(dec);
 }
 
+/* Get zeroed scratch buffer of at least "words" words
+ * - kept till tt_dec_free(), repeated operations on same destination
+ *   allocate nothing
+ * - return NULL if out of memory
+ */
+_tt_dec_word *_tt_dec_scratch(struct tt_dec *dec, int words)
+{
+	if (words > dec->_tmpsz) {
+		free(dec->_tmp);
+		dec->_tmp = malloc(words * _tt_dec_word_sz);
+		if (dec->_tmp == NULL) {
+			dec->_tmpsz = 0;
+			return NULL;
+		}
+		dec->_tmpsz = words;
+		_tt_stat_bytes(TT_STAT_DEC_ALLOC, words * _tt_dec_word_sz);
+	}
+
+	memset(dec->_tmp, 0, words * _tt_dec_word_sz);
+	return dec->_tmp;
+}
+
 /* dec = 0 */
 void _tt_dec_zero(struct tt_dec *dec)
 {
@@ -62,7 +85,7 @@ void _tt_dec_zero(struct tt_dec *dec)
 	dec->_inf_nan = 0;
 	dec->_exp = 0;
 	dec->_msb = 1;
-	memset(dec->_dig32, 0, dec->_digsz);
+	memset(dec->_dig, 0, dec->_digsz);
 }
 
 /* Check sanity */
@@ -71,23 +94,23 @@ int _tt_dec_sanity(const struct tt_dec *dec)
 	if (dec->_msb <= 0 || dec->_msb > dec->_prec)
 		return TT_APN_ESANITY;
 
-	int i, last_dig_idx = (dec->_msb + 8) / 9 - 1;
+	int i, last_dig_idx = _tt_dec_words(dec->_msb) - 1;
 
-	/* Check carry guard bits */
+	/* Check carry guard */
 	for (i = 0; i <= last_dig_idx; i++)
-		if ((dec->_dig32[i] & (BIT(30) | BIT(31))))
+		if (dec->_dig[i] >= _TT_DEC_BASE)
 			return TT_APN_ESANITY;
 
-	/* Check remaining uints */
-	for (; i < dec->_digsz / 4; i++)
-		if (dec->_dig32[i])
+	/* Check remaining words */
+	for (; i < dec->_digsz / _tt_dec_word_sz; i++)
+		if (dec->_dig[i])
 			return TT_APN_ESANITY;
 
-	/* Check last valid uint */
-	int last_dig_cnt = (dec->_msb - 1) % 9 + 1;
-        uchar d[9];
-	_tt_dec_to_d9(dec->_dig32[last_dig_idx], d);
-	for (i = 8; i > last_dig_cnt - 1; i--)
+	/* Check last valid word */
+	int last_dig_cnt = (dec->_msb - 1) % _TT_DEC_DIGS + 1;
+	uchar d[_TT_DEC_DIGS];
+	_tt_dec_to_digs(dec->_dig[last_dig_idx], d);
+	for (i = _TT_DEC_DIGS - 1; i > last_dig_cnt - 1; i--)
 		if (d[i])
 			return TT_APN_ESANITY;
 	if (d[i] == 0 && i != 0)	/* Don't blame on "0" */
@@ -103,42 +126,79 @@ int _tt_dec_sanity(const struct tt_dec *dec)
 /* Get "pos-th" digit (0~9)
  * - pos starts from 0
  */
-uint _tt_dec_get_dig(const uint *dig, int pos)
+uint _tt_dec_get_dig(const _tt_dec_word *dig, int pos)
 {
-	uint dig32 = dig[pos / 9];
-	pos %= 9;
+	_tt_dec_word w = dig[pos / _TT_DEC_DIGS];
+	pos %= _TT_DEC_DIGS;
 
 	while (pos--)
-		dig32 /= 10;
+		w /= 10;
+
+	return w % 10;
+}
+
+/* Check if any digit in [0, n) is non-zero */
+bool _tt_dec_any_dig(const _tt_dec_word *dig, int n)
+{
+	static const _tt_dec_word one_tbl[] = {
+		1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000,
+#if CONFIG_DEC_DIG64
+		1000000000ULL, 10000000000ULL, 100000000000ULL,
+		1000000000000ULL, 10000000000000ULL, 100000000000000ULL,
+		1000000000000000ULL, 10000000000000000ULL,
+		100000000000000000ULL, 1000000000000000000ULL,
+#endif
+	};
+	const int w = n / _TT_DEC_DIGS;
+
+	for (int i = 0; i < w; i++)
+		if (dig[i])
+			return true;
+	return n % _TT_DEC_DIGS && dig[w] % one_tbl[n % _TT_DEC_DIGS];
+}
+
+/* Count trailing zero digits of significand, 0 for zero */
+int _tt_dec_trailing_zeros(const struct tt_dec *dec)
+{
+	if (_tt_dec_is_zero(dec))
+		return 0;
+
+	int i = 0, n = 0;
+	while (dec->_dig[i] == 0) {
+		i++;
+		n += _TT_DEC_DIGS;
+	}
+	for (_tt_dec_word w = dec->_dig[i]; w % 10 == 0; w /= 10)
+		n++;
 
-	return dig32 % 10;
+	return n;
 }
 
 /* Convert uint64 to decimal
  * - dig must be zeroed
  * - return MSB
  */
-int _tt_dec_uint_to_dec(uint *dig32, uint64_t num)
+int _tt_dec_uint_to_dec(_tt_dec_word *dig, uint64_t num)
 {
 	int msb = 1;
 	if (num)
 		msb = 0;	/* Compensate "0" */
 
 	while (num) {
-		/* Get 9 decimals */
-		uint dec9 = num % 1000000000;
-		num /= 1000000000;
+		/* Get one word */
+		_tt_dec_word w = num % _TT_DEC_BASE;
+		num /= _TT_DEC_BASE;
 
-		*dig32++ = dec9;
+		*dig++ = w;
 
 		/* Increment significand */
 		if (num)
-			msb += 9;
+			msb += _TT_DEC_DIGS;
 		else
 			do {
 				msb++;
-				dec9 /= 10;
-			} while (dec9);
+				w /= 10;
+			} while (w);
 	}
 
 	return msb;
@@ -149,27 +209,27 @@ int _tt_dec_uint_to_dec(uint *dig32, uint64_t num)
  * - return MSB
  */
 #ifdef __SIZEOF_INT128__
-int _tt_dec_uint128_to_dec(uint *dig32, __uint128_t num)
+int _tt_dec_uint128_to_dec(_tt_dec_word *dig, __uint128_t num)
 {
 	int msb = 1;
 	if (num)
 		msb = 0;	/* Compensate "0" */
 
 	while (num) {
-		/* Get 9 decimals */
-		uint dec9 = num % 1000000000;
-		num /= 1000000000;
+		/* Get one word */
+		_tt_dec_word w = num % _TT_DEC_BASE;
+		num /= _TT_DEC_BASE;
 
-		*dig32++ = dec9;
+		*dig++ = w;
 
 		/* Increment significand */
 		if (num)
-			msb += 9;
+			msb += _TT_DEC_DIGS;
 		else
 			do {
 				msb++;
-				dec9 /= 10;
-			} while (dec9);
+				w /= 10;
+			} while (w);
 	}
 
 	return msb;
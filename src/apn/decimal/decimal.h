@@ -8,6 +8,27 @@
  */
 #pragma once
 
+/* Significand word
+ * - CONFIG_DEC_DIG64 = 0: 9 decimal digits per uint
+ * - CONFIG_DEC_DIG64 = 1: 19 decimal digits per uint64_t, words are halved
+ *   and schoolbook kernels do about 4x less work, needs 128-bit integer
+ */
+#if CONFIG_DEC_DIG64
+typedef uint64_t _tt_dec_word;
+typedef __uint128_t _tt_dec_dword;
+#define _TT_DEC_DIGS	19
+#define _TT_DEC_BASE	10000000000000000000ULL
+#else
+typedef uint _tt_dec_word;
+typedef uint64_t _tt_dec_dword;
+#define _TT_DEC_DIGS	9
+#define _TT_DEC_BASE	1000000000U
+#endif
+#define _tt_dec_word_sz	sizeof(_tt_dec_word)
+
+/* Words to hold "digs" digits */
+#define _tt_dec_words(digs)	(((digs) + _TT_DEC_DIGS - 1) / _TT_DEC_DIGS)
+
 /* Arbitrary precision decimal: { sign, dig, exp } = (-1)^sign * dig * 10^exp
  * +3.14  -> *dig = 314,  exp = -2, sign = 0, msb = 3
  * +0.220 -> *dig = 220,  exp = -3, sign = 0, msb = 3
@@ -27,19 +48,20 @@ struct tt_dec {
 	const int _prec_full;	/* Full precision digits used internally */
 #define TT_DEC_PREC_RND	9	/* Extra precison digits for rounding guard */
 #define TT_DEC_PREC_CRY	1	/* Carry digit */
-#define TT_DEC_PREC_ALN	8	/* Append to align-9 shifting */
+#define TT_DEC_PREC_ALN	(_TT_DEC_DIGS-1)	/* Append to word aligned shifting */
 	const uint _digsz;	/* Bytes of _dig[] */
 	int _msb;		/* Current decimal digit count
 				 * - must be <= _prec after calculation
 				 * - may exceed _prec by EXT_PREC in calculation
 				 */
-	uint *_dig32;		/* Significand buffer
-				 * Bit -> 31  29                        0
-				 *        +--+--------------------------+
-				 * Val -> |00| Decimal: 0 ~ 999,999,999 |
-				 *        +--+--------------------------+
-				 * - Each uint contains 9-digit decimals
+	_tt_dec_word *_dig;	/* Significand buffer
+				 * - Each word contains _TT_DEC_DIGS decimals:
+				 *   0 ~ _TT_DEC_BASE-1
+				 */
+	_tt_dec_word *_tmp;	/* Scratch of operations writing to this
+				 * decimal, grows on demand
 				 */
+	int _tmpsz;		/* Words of _tmp[] */
 };
 
 /* Clear to zero */
@@ -48,7 +70,7 @@ void _tt_dec_zero(struct tt_dec *dec);
 /* Check if significand == 0, it's not a true zero if _exp < 0 */
 static inline bool _tt_dec_is_zero(const struct tt_dec *dec)
 {
-	return dec->_msb == 1 && *dec->_dig32 == 0 && !dec->_inf_nan;
+	return dec->_msb == 1 && *dec->_dig == 0 && !dec->_inf_nan;
 }
 
 static inline bool _tt_dec_is_true_zero(const struct tt_dec *dec)
@@ -56,21 +78,70 @@ static inline bool _tt_dec_is_true_zero(const struct tt_dec *dec)
 	return _tt_dec_is_zero(dec) && dec->_exp == 0;
 }
 
+/* Get zeroed scratch buffer of at least "words" words */
+_tt_dec_word *_tt_dec_scratch(struct tt_dec *dec, int words);
+
 /* Check sanity */
 int _tt_dec_sanity(const struct tt_dec *dec);
 
-/* Get digits in a uint */
+/* Get 9 digits in a uint, lowest first */
 static inline void _tt_dec_to_d9(uint dig, uchar *d)
 {
 	for (int i = 0; i < 9; i++, dig /= 10)
 		d[i] = dig % 10;
 }
 
+/* Get digits in a word, lowest first */
+static inline void _tt_dec_to_digs(_tt_dec_word dig, uchar *d)
+{
+#if CONFIG_DEC_DIG64
+	/* Split to 9 + 9 + 1 digits, extract with 32-bit arithmetic */
+	_tt_dec_to_d9(dig % 1000000000, d);
+	dig /= 1000000000;
+	_tt_dec_to_d9(dig % 1000000000, d + 9);
+	d[18] = dig / 1000000000;
+#else
+	_tt_dec_to_d9(dig, d);
+#endif
+}
+
+/* Round to at most digs digits in place, dropped digits rounded as a whole */
+int _tt_dec_round(struct tt_dec *dec, int digs);
+
+/* dst = src rounded to precision of dst */
+int _tt_dec_copy(struct tt_dec *dst, const struct tt_dec *src);
+
+/* Check if dec with error below 10^err units decides rounding to prec */
+bool _tt_dec_round_safe(const struct tt_dec *dec, int prec, int err);
+
+/* Round inexact dec to digs digits, cmp() decides if dec is near half way */
+int _tt_dec_round_inexact(struct tt_dec *dec, int digs,
+		int (*cmp)(const struct tt_dec *half, void *arg, int *dir),
+		void *arg);
+
+/* Cached constants, correctly rounded to precision of dec, see const.c */
+int _tt_dec_ln10(struct tt_dec *dec);
+
 /* Get "pos-th" digit (pos starts from 0) */
-uint _tt_dec_get_dig(const uint *dig, int pos);
+uint _tt_dec_get_dig(const _tt_dec_word *dig, int pos);
+
+/* Check if any digit in [0, n) is non-zero */
+bool _tt_dec_any_dig(const _tt_dec_word *dig, int n);
+
+/* Count trailing zero digits of significand */
+int _tt_dec_trailing_zeros(const struct tt_dec *dec);
+
+/* digr = dig1 * dig2 by number theoretic transform, digr is not zeroed */
+int _tt_dec_mul_ntt(_tt_dec_word *digr, const _tt_dec_word *dig1, int words1,
+		const _tt_dec_word *dig2, int words2);
+
+/* 128-bit normalized powers of ten, see pow10.c */
+#define _TT_DEC_POW10_MIN	(-342)
+#define _TT_DEC_POW10_MAX	326
+extern const uint64_t _tt_dec_pow10_tbl[][2];
 
 /* uint64/128 -> decimal */
-int _tt_dec_uint_to_dec(uint *dig32, uint64_t num);
+int _tt_dec_uint_to_dec(_tt_dec_word *dig, uint64_t num);
 #ifdef __SIZEOF_INT128__
-int _tt_dec_uint128_to_dec(uint *dig32, __uint128_t num);
+int _tt_dec_uint128_to_dec(_tt_dec_word *dig, __uint128_t num);
 #endif
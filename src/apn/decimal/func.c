@@ -0,0 +1,812 @@
+/* Elementary functions: sqrt, exp, ln, log10, pow
+ *
+ * Results are correctly rounded to destination precision by Ziv's method:
+ * evaluate with guard digits, accept if the guard digits decide rounding
+ * despite evaluation error, otherwise retry with doubled guard digits.
+ *
+ * Copyright (C) 2016 Yibo Cai
+ */
+#include <tt/tt.h>
+#include <tt/apn/decimal.h>
+#include <common/lib.h>
+#include <common/stats.h>
+#include "decimal.h"
+
+#include <string.h>
+#include <limits.h>
+#include <math.h>
+
+/* Guard digits of first evaluation, doubled on each retry */
+#define GUARD		16
+/* Rounding is taken as decided past this guard (exact ties of irrational
+ * values never occur, it ends loop on exact results not caught earlier)
+ */
+#define GUARD_MAX	256
+/* Evaluation error is below 10^ERR_DIGS units of last digit */
+#define ERR_DIGS	2
+
+/* Maximum decimal exponent of results */
+#define EXP_MAX		(INT_MAX / 4)
+
+typedef int (*func_eval)(struct tt_dec *r, const struct tt_dec *x,
+		const struct tt_dec *y);
+
+static inline void set_prec(struct tt_dec *dec, int prec)
+{
+	*(int*)&dec->_prec = prec;
+}
+
+/* Adjusted exponent: 10^e <= |dec| < 10^(e+1) */
+static inline int adj_exp(const struct tt_dec *dec)
+{
+	return dec->_exp + dec->_msb - 1;
+}
+
+/* Approximate log10(|dec|), dec is finite and non zero */
+static double dec_log10(const struct tt_dec *dec)
+{
+	struct tt_dec m = *dec;
+	double md;
+
+	m._exp = -(dec->_msb - 1);
+	tt_dec_to_float(&m, &md);
+
+	return adj_exp(dec) + log10(fabs(md));
+}
+
+/* Check if dec = 10^n */
+static bool is_pow10(const struct tt_dec *dec)
+{
+	return !_tt_dec_is_zero(dec) && !dec->_inf_nan &&
+		dec->_msb - _tt_dec_trailing_zeros(dec) == 1 &&
+		_tt_dec_get_dig(dec->_dig, dec->_msb - 1) == 1;
+}
+
+/* Integer parity of dec: -1 if not integer, 0 - even, 1 - odd */
+static int int_parity(const struct tt_dec *dec)
+{
+	if (dec->_exp > 0)
+		return 0;
+	if (_tt_dec_trailing_zeros(dec) < -dec->_exp)
+		return -1;
+	return _tt_dec_get_dig(dec->_dig, -dec->_exp) & 1;
+}
+
+/* Check if dec is integer and |dec| <= INT_MAX */
+static bool dec_to_int(const struct tt_dec *dec, int64_t *n)
+{
+	if (int_parity(dec) < 0 || adj_exp(dec) > 9)
+		return false;
+
+	double d;
+	tt_dec_to_float(dec, &d);
+	if (fabs(d) > INT_MAX)
+		return false;
+	*n = d;
+
+	return true;
+}
+
+static int tmp_alloc(struct tt_dec **t, int n, int prec)
+{
+	int ret = 0;
+
+	for (int i = 0; i < n; i++) {
+		t[i] = tt_dec_alloc(prec);
+		if (!t[i])
+			ret = TT_ENOMEM;
+	}
+
+	return ret;
+}
+
+static void tmp_free(struct tt_dec **t, int n)
+{
+	for (int i = 0; i < n; i++)
+		if (t[i])
+			tt_dec_free(t[i]);
+}
+
+/* dst = eval(x, y) correctly rounded
+ * - eval returns 0 if result is exact, TT_APN_EROUNDED if not
+ * - r shorter than its precision is padded with zeros
+ */
+static int ziv(func_eval eval, struct tt_dec *dst, const struct tt_dec *x,
+		const struct tt_dec *y)
+{
+	const int prec = dst->_prec;
+	int ret;
+
+	for (int guard = GUARD; ; guard *= 2) {
+		struct tt_dec *r = tt_dec_alloc(prec + guard);
+		if (!r)
+			return TT_ENOMEM;
+
+		ret = eval(r, x, y);
+		const int err = ERR_DIGS - (r->_prec - r->_msb);
+		if (ret == 0 || (ret == TT_APN_EROUNDED &&
+				(_tt_dec_round_safe(r, prec, err) ||
+				 guard >= GUARD_MAX))) {
+			const int exact = ret == 0;
+			ret = _tt_dec_copy(dst, r);
+			if (ret == 0 && !exact)
+				ret = TT_APN_EROUNDED;
+			tt_dec_free(r);
+			break;
+		}
+		tt_dec_free(r);
+		if (ret < 0)
+			break;
+	}
+
+	return ret;
+}
+
+/* r = sqrt(a), a > 0 finite
+ * - a = a' * 10^2k, 1 <= a' < 100, sqrt(a) = sqrt(a') * 10^k
+ * - Newton iteration y = (y + a'/y) / 2 from double estimate, precision
+ *   doubles per step
+ */
+static int sqrt_eval(struct tt_dec *r, const struct tt_dec *a,
+		const struct tt_dec *unused)
+{
+	const int w = r->_prec + 4;
+	const int e = adj_exp(a);
+	const int k = e >= 0 ? e / 2 : -((1 - e) / 2);
+
+	struct tt_dec as = *a;
+	as._exp -= 2 * k;
+
+	struct tt_dec *t[3] = { NULL };
+	int ret = tmp_alloc(t, 3, w);
+	if (ret)
+		goto out;
+	struct tt_dec *y = t[0], *q = t[1], *half = t[2];
+
+	double ad;
+	tt_dec_to_float(&as, &ad);
+	tt_dec_from_float(y, sqrt(ad));
+	tt_dec_from_uint(half, 5);
+	half->_exp = -1;
+
+	/* Precisions of steps, last one repeated */
+	int ps[32], n = 0;
+	ps[n++] = w;
+	for (int p = w; p > 15; p = p / 2 + 1)
+		ps[n++] = p;
+
+	while (n--) {
+		set_prec(y, ps[n]);
+		set_prec(q, ps[n]);
+		ret = tt_dec_div(q, &as, y);
+		if (ret < 0)
+			goto out;
+		ret = tt_dec_add(y, y, q);
+		if (ret < 0)
+			goto out;
+		ret = tt_dec_mul(y, y, half);
+		if (ret < 0)
+			goto out;
+	}
+
+	ret = _tt_dec_copy(r, y);
+	if (ret < 0)
+		goto out;
+	r->_exp += k;
+	ret = TT_APN_EROUNDED;
+
+out:
+	tmp_free(t, 3);
+	return ret;
+}
+
+/* r = e^x, x finite, |x| / ln10 <= EXP_MAX
+ * - x = k * ln10 + t, |t| <= ln10 / 2, e^x = e^t * 10^k
+ * - e^t = (e^(t/2^s))^(2^s), Taylor series of t/2^s converges fast
+ * - each squaring doubles relative error, add s*log10(2) digits
+ */
+static int exp_eval(struct tt_dec *r, const struct tt_dec *x,
+		const struct tt_dec *unused)
+{
+	double xd;
+	tt_dec_to_float(x, &xd);
+	const int k = lround(xd / M_LN10);
+
+	const int s = sqrt(r->_prec);
+	const int w = r->_prec + s * 0.302 + 8;
+	/* t = x - k * ln10 keeps w digits after point, k < 10^10 */
+	const int wt = w + 12;
+
+	struct tt_dec *tmp[4] = { NULL };
+	int ret = tmp_alloc(tmp, 4, wt);
+	if (ret)
+		goto out;
+	struct tt_dec *t = tmp[0], *aux = tmp[1], *sum = tmp[2], *term = tmp[3];
+
+	if (k) {
+		ret = _tt_dec_ln10(aux);
+		if (ret < 0)
+			goto out;
+		tt_dec_from_sint(term, k);
+		ret = tt_dec_mul(aux, aux, term);
+		if (ret < 0)
+			goto out;
+		ret = tt_dec_sub(t, x, aux);
+	} else {
+		ret = _tt_dec_copy(t, x);
+	}
+	if (ret < 0)
+		goto out;
+
+	for (int n = s; n > 0; n -= 60) {
+		tt_dec_from_uint(aux, 1ULL << _tt_min(n, 60));
+		ret = tt_dec_div(t, t, aux);
+		if (ret < 0)
+			goto out;
+	}
+
+	/* sum = 1 + t + t^2/2! + ..., |sum| ~ 1 */
+	set_prec(sum, w);
+	tt_dec_from_uint(sum, 1);
+	ret = _tt_dec_copy(term, t);
+	if (ret < 0)
+		goto out;
+	for (uint i = 2; !_tt_dec_is_zero(term); i++) {
+		ret = tt_dec_add(sum, sum, term);
+		if (ret < 0)
+			goto out;
+
+		/* Terms need only digits above 10^-w */
+		const int e = adj_exp(term);
+		if (e < -w - 2)
+			break;
+		set_prec(term, _tt_max(_tt_min(w + e + 4, w), 20));
+
+		ret = tt_dec_mul(term, term, t);
+		if (ret < 0)
+			goto out;
+		tt_dec_from_uint(aux, i);
+		ret = tt_dec_div(term, term, aux);
+		if (ret < 0)
+			goto out;
+	}
+
+	for (int i = 0; i < s; i++) {
+		ret = tt_dec_mul(sum, sum, sum);
+		if (ret < 0)
+			goto out;
+	}
+
+	ret = _tt_dec_copy(r, sum);
+	if (ret < 0)
+		goto out;
+	r->_exp += k;
+	ret = TT_APN_EROUNDED;
+
+out:
+	tmp_free(tmp, 4);
+	return ret;
+}
+
+/* y = ln(m) = 2 * atanh(d / (2 + d)), d = m - 1, |d| < 10^-3
+ * - z = d / (2 + d), series z + z^3/3 + z^5/5 + ... drops 6 digits per term
+ */
+static int ln_series(struct tt_dec *y, const struct tt_dec *d, int w)
+{
+	struct tt_dec *tmp[4] = { NULL };
+	int ret = tmp_alloc(tmp, 4, w);
+	if (ret)
+		goto out;
+	struct tt_dec *z = tmp[0], *z2 = tmp[1], *term = tmp[2], *q = tmp[3];
+
+	tt_dec_from_uint(q, 2);
+	ret = tt_dec_add(q, q, d);
+	if (ret < 0)
+		goto out;
+	ret = tt_dec_div(z, d, q);
+	if (ret < 0)
+		goto out;
+	ret = tt_dec_mul(z2, z, z);
+	if (ret < 0)
+		goto out;
+
+	ret = _tt_dec_copy(y, z);
+	if (ret < 0)
+		goto out;
+	ret = _tt_dec_copy(term, z);
+	if (ret < 0)
+		goto out;
+	const int ez = adj_exp(z);
+	for (uint i = 3; ; i += 2) {
+		ret = tt_dec_mul(term, term, z2);
+		if (ret < 0)
+			goto out;
+		tt_dec_from_uint(q, i);
+		ret = tt_dec_div(q, term, q);
+		if (ret < 0)
+			goto out;
+		if (adj_exp(q) < ez - w - 2)
+			break;
+		ret = tt_dec_add(y, y, q);
+		if (ret < 0)
+			goto out;
+	}
+	ret = tt_dec_add(y, y, y);
+
+out:
+	tmp_free(tmp, 4);
+	return ret;
+}
+
+/* y = ln(m), 1/sqrt(10) <= m < sqrt(10), |m - 1| >= 10^-3
+ * - Halley iteration y += 2 * (m - e^y) / (m + e^y) from double estimate,
+ *   precision triples per step
+ */
+static int ln_newton(struct tt_dec *y, const struct tt_dec *m, double md,
+		int w)
+{
+	struct tt_dec *tmp[2] = { NULL };
+	int ret = tmp_alloc(tmp, 2, w);
+	if (ret)
+		goto out;
+	struct tt_dec *ey = tmp[0], *q = tmp[1];
+
+	tt_dec_from_float(y, log(md));
+
+	int ps[32], n = 0;
+	for (int p = w; p > 15; p = p / 3 + 1)
+		ps[n++] = p;
+
+	while (n--) {
+		set_prec(y, ps[n]);
+		set_prec(ey, ps[n]);
+		set_prec(q, ps[n]);
+
+		ret = exp_eval(ey, y, NULL);
+		if (ret < 0)
+			goto out;
+		ret = tt_dec_add(q, m, ey);
+		if (ret < 0)
+			goto out;
+		ret = tt_dec_sub(ey, m, ey);
+		if (ret < 0)
+			goto out;
+		ret = tt_dec_div(q, ey, q);
+		if (ret < 0)
+			goto out;
+		ret = tt_dec_add(q, q, q);
+		if (ret < 0)
+			goto out;
+		ret = tt_dec_add(y, y, q);
+		if (ret < 0)
+			goto out;
+	}
+
+out:
+	tmp_free(tmp, 2);
+	return ret;
+}
+
+/* r = ln(a), a > 0 finite, a != 1
+ * - a = m * 10^e, 1/sqrt(10) <= m < sqrt(10), ln(a) = ln(m) + e * ln10
+ */
+static int ln_eval(struct tt_dec *r, const struct tt_dec *a,
+		const struct tt_dec *unused)
+{
+	const int w = r->_prec + 8;
+
+	struct tt_dec m = *a;
+	int e = adj_exp(a);
+	m._exp = -(a->_msb - 1);
+	double md;
+	tt_dec_to_float(&m, &md);
+	if (md >= sqrt(10)) {
+		m._exp--;
+		md /= 10;
+		e++;
+	}
+
+	struct tt_dec *tmp[3] = { NULL };
+	int ret = tmp_alloc(tmp, 2, w);
+	if (ret)
+		goto out;
+	struct tt_dec *y = tmp[0], *l10 = tmp[1];
+
+	/* d = m - 1 exactly */
+	tmp[2] = tt_dec_alloc(a->_msb + 2);
+	if (!tmp[2]) {
+		ret = TT_ENOMEM;
+		goto out;
+	}
+	struct tt_dec *d = tmp[2];
+	tt_dec_from_uint(d, 1);
+	ret = tt_dec_sub(d, &m, d);
+	if (ret < 0)
+		goto out;
+
+	if (_tt_dec_is_zero(d))
+		_tt_dec_zero(y);
+	else if (adj_exp(d) < -3)
+		ret = ln_series(y, d, w);
+	else
+		ret = ln_newton(y, &m, md, w);
+	if (ret < 0)
+		goto out;
+
+	if (e) {
+		/* |e * ln10| > |ln(m)|, no cancellation */
+		ret = _tt_dec_ln10(l10);
+		if (ret < 0)
+			goto out;
+		tt_dec_from_sint(r, e);
+		ret = tt_dec_mul(l10, l10, r);
+		if (ret < 0)
+			goto out;
+		ret = tt_dec_add(y, y, l10);
+		if (ret < 0)
+			goto out;
+	}
+
+	ret = _tt_dec_copy(r, y);
+	if (ret >= 0)
+		ret = TT_APN_EROUNDED;
+
+out:
+	tmp_free(tmp, 3);
+	return ret;
+}
+
+/* r = ln(a) / ln10, a > 0 finite, a is not power of 10 */
+static int log10_eval(struct tt_dec *r, const struct tt_dec *a,
+		const struct tt_dec *unused)
+{
+	struct tt_dec *tmp[2] = { NULL };
+	int ret = tmp_alloc(tmp, 2, r->_prec + 4);
+	if (ret)
+		goto out;
+
+	ret = ln_eval(tmp[0], a, NULL);
+	if (ret < 0)
+		goto out;
+	ret = _tt_dec_ln10(tmp[1]);
+	if (ret < 0)
+		goto out;
+	ret = tt_dec_div(r, tmp[0], tmp[1]);
+	if (ret >= 0)
+		ret = TT_APN_EROUNDED;
+
+out:
+	tmp_free(tmp, 2);
+	return ret;
+}
+
+/* r = x^n, n integer, 0 < |n| <= INT_MAX
+ * - binary powering, relative error grows to about 2n units, add 12 digits
+ * - exact if no operation rounds
+ */
+static int powi_eval(struct tt_dec *r, const struct tt_dec *x,
+		const struct tt_dec *y)
+{
+	int64_t n = 0;
+	dec_to_int(y, &n);
+	const uint un = n < 0 ? -n : n;
+
+	struct tt_dec *tmp[2] = { NULL };
+	int ret = tmp_alloc(tmp, 2, r->_prec + 12);
+	if (ret)
+		goto out;
+	struct tt_dec *b = tmp[0], *p = tmp[1];
+
+	bool inexact = false;
+	ret = _tt_dec_copy(b, x);
+	if (ret < 0)
+		goto out;
+	inexact |= ret == TT_APN_EROUNDED;
+	ret = _tt_dec_copy(p, b);
+	if (ret < 0)
+		goto out;
+
+	for (int i = 30 - __builtin_clz(un); i >= 0; i--) {
+		ret = tt_dec_mul(p, p, p);
+		if (ret < 0)
+			goto out;
+		inexact |= ret == TT_APN_EROUNDED;
+		if ((un >> i) & 1) {
+			ret = tt_dec_mul(p, p, b);
+			if (ret < 0)
+				goto out;
+			inexact |= ret == TT_APN_EROUNDED;
+		}
+	}
+
+	if (n < 0) {
+		tt_dec_from_uint(b, 1);
+		ret = tt_dec_div(p, b, p);
+		if (ret < 0)
+			goto out;
+		inexact |= ret == TT_APN_EROUNDED;
+	}
+
+	ret = _tt_dec_copy(r, p);
+	if (ret >= 0 && inexact)
+		ret = TT_APN_EROUNDED;
+
+out:
+	tmp_free(tmp, 2);
+	return ret;
+}
+
+/* r = e^(y * ln(x)), x > 0, x != 1
+ * - y * ln(x) needs extra digits for its integer part
+ */
+static int pow_eval(struct tt_dec *r, const struct tt_dec *x,
+		const struct tt_dec *y)
+{
+	struct tt_dec *tmp[1] = { NULL };
+	int ret = tmp_alloc(tmp, 1, 20);
+	if (ret)
+		goto out;
+
+	/* Estimate magnitude of y * ln(x) */
+	ret = ln_eval(tmp[0], x, NULL);
+	if (ret < 0)
+		goto out;
+	const double lv = dec_log10(y) + dec_log10(tmp[0]);
+	if (lv - log10(M_LN10) > log10(EXP_MAX)) {
+		ret = tmp[0]->_sign == y->_sign ? TT_APN_EOVERFLOW :
+			TT_APN_EUNDERFLOW;
+		goto out;
+	}
+	const int w = r->_prec + (lv > 0 ? (int)lv + 1 : 0) + 6;
+	tt_dec_free(tmp[0]);
+
+	tmp[0] = tt_dec_alloc(w);
+	if (!tmp[0]) {
+		ret = TT_ENOMEM;
+		goto out;
+	}
+	ret = ln_eval(tmp[0], x, NULL);
+	if (ret < 0)
+		goto out;
+	ret = tt_dec_mul(tmp[0], tmp[0], y);
+	if (ret < 0)
+		goto out;
+	ret = exp_eval(r, tmp[0], NULL);
+
+out:
+	tmp_free(tmp, 1);
+	return ret;
+}
+
+/* Store Inf or zero on exponent overflow or underflow */
+static int set_overflow(struct tt_dec *dst, int sign, bool under)
+{
+	if (under) {
+		_tt_dec_zero(dst);
+		return TT_APN_EUNDERFLOW;
+	}
+	dst->_sign = sign;
+	dst->_inf_nan = TT_DEC_INF;
+	return TT_APN_EOVERFLOW;
+}
+
+/* Drop trailing zeros of exact result down to exponent exp */
+static void trim_exact(struct tt_dec *dec, int exp)
+{
+	const int n = _tt_min(_tt_dec_trailing_zeros(dec), exp - dec->_exp);
+	if (n > 0)
+		_tt_dec_round(dec, dec->_msb - n);
+}
+
+/* dst = sqrt(src). dst may share src.
+ * - return 0 if exact, TT_APN_EROUNDED, or error code
+ * - NaN or negative src: NaN stored, return TT_APN_EINVAL
+ */
+int tt_dec_sqrt(struct tt_dec *dst, const struct tt_dec *src)
+{
+	_tt_stat_func(TT_STAT_DEC_SQRT);
+
+	if (src->_inf_nan == TT_DEC_NAN ||
+			(src->_sign && !_tt_dec_is_zero(src))) {
+		dst->_inf_nan = TT_DEC_NAN;
+		return TT_APN_EINVAL;
+	}
+	if (src->_inf_nan == TT_DEC_INF) {
+		dst->_sign = 0;
+		dst->_inf_nan = TT_DEC_INF;
+		return TT_APN_EOVERFLOW;
+	}
+	if (_tt_dec_is_zero(src)) {
+		_tt_dec_zero(dst);
+		return 0;
+	}
+
+	/* Ideal exponent and significant digits of src */
+	const int tz = _tt_dec_trailing_zeros(src);
+	const int exp = (src->_exp + tz) >= 0 ? (src->_exp + tz) / 2 :
+		-((1 - src->_exp - tz) / 2);
+	const int sig = src->_msb - tz;
+
+	int ret = ziv(sqrt_eval, dst, src, NULL);
+	if (ret != TT_APN_EROUNDED)
+		return ret;
+
+	/* Exact only if result of n digits squares to 2n-1 or 2n digits */
+	const int n = dst->_msb - _tt_dec_trailing_zeros(dst);
+	if (sig != n * 2 - 1 && sig != n * 2)
+		return ret;
+
+	struct tt_dec *t = tt_dec_alloc(dst->_msb * 2);
+	if (!t)
+		return TT_ENOMEM;
+	const int rr = tt_dec_mul(t, dst, dst);
+	if (rr < 0) {
+		ret = rr;
+		goto out;
+	}
+	if (rr == 0 && tt_dec_cmp(t, src) == 0) {
+		trim_exact(dst, exp);
+		ret = 0;
+	}
+
+out:
+	tt_dec_free(t);
+	return ret;
+}
+
+/* dst = e^src. dst may share src.
+ * - return 0 if exact, TT_APN_EROUNDED, TT_APN_EOVERFLOW (Inf stored),
+ *   TT_APN_EUNDERFLOW (zero stored), or error code
+ */
+int tt_dec_exp(struct tt_dec *dst, const struct tt_dec *src)
+{
+	_tt_stat_func(TT_STAT_DEC_EXP);
+
+	if (src->_inf_nan == TT_DEC_NAN) {
+		dst->_inf_nan = TT_DEC_NAN;
+		return TT_APN_EINVAL;
+	}
+	if (src->_inf_nan == TT_DEC_INF) {
+		if (src->_sign) {
+			_tt_dec_zero(dst);
+			return 0;
+		}
+		return set_overflow(dst, 0, false);
+	}
+	if (_tt_dec_is_zero(src))
+		return tt_dec_from_uint(dst, 1);
+
+	/* 10^EXP_MAX bounds result */
+	if (dec_log10(src) - log10(M_LN10) > log10(EXP_MAX))
+		return set_overflow(dst, 0, src->_sign);
+
+	return ziv(exp_eval, dst, src, NULL);
+}
+
+/* Check argument of ln, log10
+ * - return 1 if result is stored to dst, *ret holds return code
+ */
+static int log_special(struct tt_dec *dst, const struct tt_dec *src, int *ret)
+{
+	if (src->_inf_nan == TT_DEC_NAN ||
+			(src->_sign && !_tt_dec_is_zero(src))) {
+		dst->_inf_nan = TT_DEC_NAN;
+		*ret = TT_APN_EINVAL;
+		return 1;
+	}
+	if (src->_inf_nan == TT_DEC_INF) {
+		*ret = set_overflow(dst, 0, false);
+		return 1;
+	}
+	if (_tt_dec_is_zero(src)) {
+		dst->_sign = 1;
+		dst->_inf_nan = TT_DEC_INF;
+		*ret = TT_APN_EDIV_0;
+		return 1;
+	}
+	if (is_pow10(src) && adj_exp(src) == 0) {
+		_tt_dec_zero(dst);
+		*ret = 0;
+		return 1;
+	}
+	return 0;
+}
+
+/* dst = ln(src). dst may share src.
+ * - return 0 if exact (src = 1), TT_APN_EROUNDED, or error code
+ * - zero src: -Inf stored, return TT_APN_EDIV_0
+ * - negative src: NaN stored, return TT_APN_EINVAL
+ */
+int tt_dec_ln(struct tt_dec *dst, const struct tt_dec *src)
+{
+	_tt_stat_func(TT_STAT_DEC_LN);
+	int ret;
+
+	if (log_special(dst, src, &ret))
+		return ret;
+
+	return ziv(ln_eval, dst, src, NULL);
+}
+
+/* dst = log10(src). dst may share src.
+ * - exact for powers of 10, otherwise same as tt_dec_ln()
+ */
+int tt_dec_log10(struct tt_dec *dst, const struct tt_dec *src)
+{
+	_tt_stat_func(TT_STAT_DEC_LOG10);
+	int ret;
+
+	if (log_special(dst, src, &ret))
+		return ret;
+	if (is_pow10(src))
+		return tt_dec_from_sint(dst, adj_exp(src));
+
+	return ziv(log10_eval, dst, src, NULL);
+}
+
+/* dst = base^exp. dst may share base or exp.
+ * - integer exp up to INT_MAX by binary powering, exact if result fits
+ *   precision of dst, otherwise e^(exp * ln(base))
+ * - return 0 if exact, TT_APN_EROUNDED, TT_APN_EOVERFLOW (Inf stored),
+ *   TT_APN_EUNDERFLOW (zero stored), or error code
+ * - negative base with non integer exp: NaN stored, return TT_APN_EINVAL
+ * - zero base with negative exp: Inf stored, return TT_APN_EDIV_0
+ */
+int tt_dec_pow(struct tt_dec *dst, const struct tt_dec *base,
+		const struct tt_dec *exp)
+{
+	_tt_stat_func(TT_STAT_DEC_POW);
+
+	if (base->_inf_nan == TT_DEC_NAN || exp->_inf_nan == TT_DEC_NAN) {
+		dst->_inf_nan = TT_DEC_NAN;
+		return TT_APN_EINVAL;
+	}
+	if (_tt_dec_is_zero(exp))
+		return tt_dec_from_uint(dst, 1);
+
+	const int parity = exp->_inf_nan ? 0 : int_parity(exp);
+	if (base->_sign && !_tt_dec_is_zero(base) && parity < 0) {
+		dst->_inf_nan = TT_DEC_NAN;
+		return TT_APN_EINVAL;
+	}
+	const int sign = base->_sign && parity == 1;
+
+	/* |base| */
+	struct tt_dec x = *base;
+	x._sign = 0;
+
+	/* |base| = 1, Inf, 0, or Inf exponent */
+	const int cmp1 = x._inf_nan ? 1 : _tt_dec_is_zero(&x) ? -1 :
+		is_pow10(&x) && adj_exp(&x) == 0 ? 0 : adj_exp(&x) >= 0 ? 1 : -1;
+	if (cmp1 == 0) {
+		tt_dec_from_uint(dst, 1);
+		dst->_sign = sign;
+		return 0;
+	}
+	const bool big = (cmp1 > 0) == !exp->_sign;
+	if (exp->_inf_nan || x._inf_nan || _tt_dec_is_zero(&x)) {
+		if (_tt_dec_is_zero(&x) && exp->_sign) {
+			dst->_sign = sign;
+			dst->_inf_nan = TT_DEC_INF;
+			return TT_APN_EDIV_0;
+		}
+		if (!big) {
+			_tt_dec_zero(dst);
+			return 0;
+		}
+		return set_overflow(dst, sign, false);
+	}
+
+	/* log10(|log10(result)|) = log10(|exp|) + log10(|log10(|base|)|) */
+	if (dec_log10(exp) + log10(fabs(dec_log10(&x))) > log10(EXP_MAX))
+		return set_overflow(dst, sign, !big);
+
+	int64_t n;
+	int ret = ziv(dec_to_int(exp, &n) ? powi_eval : pow_eval, dst, &x, exp);
+	if (ret == TT_APN_EOVERFLOW || ret == TT_APN_EUNDERFLOW)
+		return set_overflow(dst, sign, ret == TT_APN_EUNDERFLOW);
+	if (ret >= 0)
+		dst->_sign = sign;
+
+	return ret;
+}
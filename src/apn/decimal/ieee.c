@@ -0,0 +1,445 @@
+/* Decimal <--> IEEE 754-2008 decimal32/64/128 interchange encoding
+ *
+ * Layout, k = 32, 64, 128 bits:
+ * +------+-------------------+-------------------------+----------------+
+ * | Sign | Combination (5)   | Exponent continuation   | Coefficient    |
+ * |  1   |                   | w = 6, 8, 12            | t = 20, 50, 110|
+ * +------+-------------------+-------------------------+----------------+
+ *
+ * BID: binary coefficient, combination and exponent continuation hold the
+ *      w+2 bits biased exponent, or "11" + exponent if the coefficient
+ *      needs more than t+3 bits (implicit "100" prefix).
+ * DPD: combination holds top two exponent bits and the leading digit, the
+ *      other p-1 digits are packed 3 per 10 bits declet.
+ * "11110" in combination is Inf, "11111" is NaN.
+ *
+ * Copyright (C) 2016 Yibo Cai
+ */
+#include <tt/tt.h>
+#include <tt/apn/decimal.h>
+#include <tt/common/round.h>
+#include <common/lib.h>
+#include "decimal.h"
+
+#include <string.h>
+
+/* Coefficient and encoded number, decimal128 needs 128-bit integer */
+#ifdef __SIZEOF_INT128__
+typedef __uint128_t ieee_t;
+#else
+typedef uint64_t ieee_t;
+#endif
+
+struct ieee_fmt {
+	int bits;	/* k */
+	int prec;	/* p: coefficient digits */
+	int ecbits;	/* w: exponent continuation bits */
+	int bias;
+};
+
+static const struct ieee_fmt fmts[3] = {
+	{ .bits = 32, .prec = 7, .ecbits = 6, .bias = 101 },
+	{ .bits = 64, .prec = 16, .ecbits = 8, .bias = 398 },
+	{ .bits = 128, .prec = 34, .ecbits = 12, .bias = 6176 },
+};
+
+#define COMB_INF	0x1E
+#define COMB_NAN	0x1F
+
+static const uint64_t pow10_tbl[] = {
+	1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL,
+	10000000ULL, 100000000ULL, 1000000000ULL, 10000000000ULL,
+	100000000000ULL, 1000000000000ULL, 10000000000000ULL,
+	100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL,
+	100000000000000000ULL, 1000000000000000000ULL,
+	10000000000000000000ULL,
+};
+
+/* 10^n, n = 0 ~ 38 */
+static inline ieee_t pow10_ieee(int n)
+{
+	if (n < 20)
+		return pow10_tbl[n];
+	return (ieee_t)pow10_tbl[19] * pow10_tbl[n - 19];
+}
+
+static inline ieee_t mask(int bits)
+{
+	return ((ieee_t)1 << bits) - 1;
+}
+
+/* Digits of coefficient, 0 has 0 digits */
+static int coef_digs(ieee_t c)
+{
+	int n = 0;
+
+	while (n < 39 && c >= pow10_ieee(n))
+		n++;
+	return n;
+}
+
+/* Three digits (0 ~ 999) to declet
+ * - digits d2 = abcd, d1 = efgh, d0 = ijkm (bits), a, e, i select layout
+ */
+static uint bin_to_dpd(uint v)
+{
+	const uint d2 = v / 100, d1 = v / 10 % 10, d0 = v % 10;
+	const uint big = (d2 >> 3) << 2 | (d1 >> 3) << 1 | d0 >> 3;
+	const uint bcd = d2 & 7, fgh = d1 & 7, jkm = d0 & 7;
+	const uint d = d2 & 1, h = d1 & 1, m = d0 & 1;
+	const uint fg = fgh >> 1, jk = jkm >> 1;
+
+	switch (big) {
+	case 0:	/* 000: bcd fgh 0 jkm */
+		return bcd << 7 | fgh << 4 | jkm;
+	case 1:	/* 001: bcd fgh 1 00m */
+		return bcd << 7 | fgh << 4 | 0x8 | m;
+	case 2:	/* 010: bcd jkh 1 01m */
+		return bcd << 7 | jk << 5 | h << 4 | 0xA | m;
+	case 4:	/* 100: jkd fgh 1 10m */
+		return jk << 8 | d << 7 | fgh << 4 | 0xC | m;
+	case 6:	/* 110: jkd 00h 1 11m */
+		return jk << 8 | d << 7 | h << 4 | 0xE | m;
+	case 5:	/* 101: fgd 01h 1 11m */
+		return fg << 8 | d << 7 | 0x20 | h << 4 | 0xE | m;
+	case 3:	/* 011: bcd 10h 1 11m */
+		return bcd << 7 | 0x40 | h << 4 | 0xE | m;
+	default: /* 111: 00d 11h 1 11m */
+		return d << 7 | 0x60 | h << 4 | 0xE | m;
+	}
+}
+
+/* Declet to three digits, non-canonical declets decode as specified */
+static uint dpd_to_bin(uint x)
+{
+	const uint pqr = x >> 7, stu = (x >> 4) & 7, y = x & 1;
+	const uint pq = pqr >> 1, st = stu >> 1, r = pqr & 1, u = stu & 1;
+	uint d2, d1, d0;
+
+	if ((x & 0x8) == 0) {
+		d2 = pqr;
+		d1 = stu;
+		d0 = x & 7;
+	} else {
+		switch ((x >> 1) & 3) {
+		case 0:
+			d2 = pqr;
+			d1 = stu;
+			d0 = 8 + y;
+			break;
+		case 1:
+			d2 = pqr;
+			d1 = 8 + u;
+			d0 = st << 1 | y;
+			break;
+		case 2:
+			d2 = 8 + r;
+			d1 = stu;
+			d0 = pq << 1 | y;
+			break;
+		default:
+			switch (st) {
+			case 0:
+				d2 = 8 + r;
+				d1 = 8 + u;
+				d0 = pq << 1 | y;
+				break;
+			case 1:
+				d2 = 8 + r;
+				d1 = pq << 1 | u;
+				d0 = 8 + y;
+				break;
+			case 2:
+				d2 = pqr;
+				d1 = 8 + u;
+				d0 = 8 + y;
+				break;
+			default:
+				d2 = 8 + r;
+				d1 = 8 + u;
+				d0 = 8 + y;
+				break;
+			}
+		}
+	}
+
+	return d2 * 100 + d1 * 10 + d0;
+}
+
+/* Pack "digs" (multiple of 3, <= 18) digits of v to declets */
+static uint64_t pack_declets(uint64_t v, int digs)
+{
+	uint64_t x = 0;
+
+	for (int i = 0; i < digs; i += 3) {
+		x |= (uint64_t)bin_to_dpd(v % 1000) << (i / 3 * 10);
+		v /= 1000;
+	}
+	return x;
+}
+
+static uint64_t unpack_declets(ieee_t x, int digs)
+{
+	uint64_t v = 0;
+
+	for (int i = digs - 3; i >= 0; i -= 3)
+		v = v * 1000 + dpd_to_bin((x >> (i / 3 * 10)) & 0x3FF);
+	return v;
+}
+
+/* Encode finite number: c < 10^p, biased exponent e */
+static ieee_t encode(const struct ieee_fmt *f, int dpd, ieee_t c, int e)
+{
+	const int t = f->bits - 6 - f->ecbits;
+
+	if (!dpd) {
+		if ((c >> (t + 3)) == 0)
+			return (ieee_t)e << (t + 3) | c;
+		return ((ieee_t)3 << (f->ecbits + 2) | e) << (t + 1) |
+			(c & mask(t + 1));
+	}
+
+	/* Declets of trailing p-1 digits, at most 18 digits per chunk */
+	const ieee_t top = pow10_ieee(f->prec - 1);
+	const uint msd = c / top;
+	ieee_t cc;
+	c %= top;
+	if (f->prec - 1 > 18) {
+		const uint64_t lo = c % pow10_tbl[18];
+		cc = (ieee_t)pack_declets(c / pow10_tbl[18],
+				f->prec - 1 - 18) << 60 |
+			pack_declets(lo, 18);
+	} else {
+		cc = pack_declets(c, f->prec - 1);
+	}
+
+	const uint ehi = e >> f->ecbits;
+	const uint comb = msd < 8 ? ehi << 3 | msd : 0x18 | ehi << 1 | (msd & 1);
+	return ((ieee_t)comb << f->ecbits | (e & mask(f->ecbits))) << t | cc;
+}
+
+/* Decode number without sign
+ * - return 0: finite, *c, *e (biased), TT_DEC_INF, TT_DEC_NAN
+ */
+static int decode(const struct ieee_fmt *f, int dpd, ieee_t x, ieee_t *c,
+		int *e)
+{
+	const int t = f->bits - 6 - f->ecbits;
+	const uint comb = (x >> (f->bits - 6)) & 0x1F;
+
+	if (comb == COMB_INF)
+		return TT_DEC_INF;
+	if (comb == COMB_NAN)
+		return TT_DEC_NAN;
+
+	if (!dpd) {
+		if ((comb >> 3) == 3) {
+			*e = (x >> (t + 1)) & mask(f->ecbits + 2);
+			*c = (ieee_t)4 << (t + 1) | (x & mask(t + 1));
+		} else {
+			*e = (x >> (t + 3)) & mask(f->ecbits + 2);
+			*c = x & mask(t + 3);
+		}
+		/* Non-canonical coefficient is zero */
+		if (*c >= pow10_ieee(f->prec))
+			*c = 0;
+		return 0;
+	}
+
+	uint ehi, msd;
+	if ((comb >> 3) == 3) {
+		ehi = (comb >> 1) & 3;
+		msd = 8 + (comb & 1);
+	} else {
+		ehi = comb >> 3;
+		msd = comb & 7;
+	}
+	*e = ehi << f->ecbits | ((x >> t) & mask(f->ecbits));
+
+	const ieee_t cc = x & mask(t);
+	if (f->prec - 1 > 18)
+		*c = (ieee_t)unpack_declets(cc >> 60, f->prec - 1 - 18) *
+			pow10_tbl[18] + unpack_declets(cc, 18);
+	else
+		*c = unpack_declets(cc, f->prec - 1);
+	*c += msd * pow10_ieee(f->prec - 1);
+
+	return 0;
+}
+
+static int check_fmt(int fmt)
+{
+	if (fmt < TT_DEC_BID32 || fmt > TT_DEC_DPD128) {
+		tt_error("Invalid format");
+		return TT_EINVAL;
+	}
+#ifndef __SIZEOF_INT128__
+	if (fmt == TT_DEC_BID128 || fmt == TT_DEC_DPD128)
+		return TT_ENOTSUP;
+#endif
+	return 0;
+}
+
+static void store(void *buf, ieee_t x, int bits)
+{
+	if (bits == 32) {
+		*(uint32_t *)buf = x;
+	} else if (bits == 64) {
+		*(uint64_t *)buf = x;
+	} else {
+		((uint64_t *)buf)[0] = x;
+		((uint64_t *)buf)[1] = (uint64_t)(x >> 32 >> 32);
+	}
+}
+
+static ieee_t load(const void *buf, int bits)
+{
+	if (bits == 32)
+		return *(const uint32_t *)buf;
+	if (bits == 64)
+		return *(const uint64_t *)buf;
+	return (ieee_t)((const uint64_t *)buf)[1] << 32 << 32 |
+		((const uint64_t *)buf)[0];
+}
+
+/* Digits [lo, msb) of significand, msb - lo <= 38 */
+static ieee_t get_top(const struct tt_dec *dec, int lo)
+{
+	const _tt_dec_word *dig = dec->_dig;
+	const int wl = lo / _TT_DEC_DIGS, r = lo % _TT_DEC_DIGS;
+	ieee_t c = 0;
+
+	for (int i = _tt_dec_words(dec->_msb) - 1; i > wl; i--)
+		c = c * _TT_DEC_BASE + dig[i];
+	return c * pow10_tbl[_TT_DEC_DIGS - r] + dig[wl] / pow10_tbl[r];
+}
+
+/* Encode dec to IEEE decimal interchange format
+ * - buf: uint32_t, uint64_t, or uint64_t[2] (low half first), host order
+ * - significand is rounded to p digits, subnormal and clamped as IEEE 754
+ * - return 0, TT_APN_EROUNDED if inexact, TT_APN_EOVERFLOW (Inf stored),
+ *   TT_APN_EUNDERFLOW (zero stored), or error code
+ */
+int tt_dec_to_ieee(const struct tt_dec *dec, void *buf, int fmt)
+{
+	int ret = check_fmt(fmt);
+	if (ret)
+		return ret;
+
+	const struct ieee_fmt *f = &fmts[fmt % 3];
+	const int dpd = fmt >= TT_DEC_DPD32;
+	const ieee_t sign = (ieee_t)dec->_sign << (f->bits - 1);
+	const int qmin = -f->bias;
+	const int qmax = 3 * (1 << f->ecbits) - 1 - f->bias;
+
+	if (dec->_inf_nan) {
+		const uint comb = dec->_inf_nan == TT_DEC_INF ?
+			COMB_INF : COMB_NAN;
+		store(buf, sign | (ieee_t)comb << (f->bits - 6), f->bits);
+		return 0;
+	}
+
+	/* Drop digits beyond precision, and below minimal exponent */
+	const int msb = dec->_msb;
+	int sfr = _tt_max(msb - f->prec, 0);
+	int q = dec->_exp;
+	if (q + sfr < qmin)
+		sfr = qmin - q;
+	q += sfr;
+
+	ieee_t c = 0;
+	if (sfr == 0) {
+		c = get_top(dec, 0);
+	} else if (sfr <= msb) {
+		if (sfr < msb)
+			c = get_top(dec, sfr);
+		/* "5" followed by non zero digits is above half */
+		const uint d = _tt_dec_get_dig(dec->_dig, sfr - 1);
+		const bool sticky = _tt_dec_any_dig(dec->_dig, sfr - 1);
+		c += _tt_round(c & 1, d == 5 && sticky ? 6 : d, 0);
+		if (c == pow10_ieee(f->prec)) {
+			c /= 10;
+			q++;
+		}
+		if (d || sticky)
+			ret = TT_APN_EROUNDED;
+	} else if (!_tt_dec_is_zero(dec)) {
+		ret = TT_APN_EROUNDED;
+	}
+
+	/* Fold down big exponent by padding zeros */
+	if (q > qmax) {
+		const int pad = q - qmax;
+		if (c && coef_digs(c) + pad > f->prec) {
+			tt_warn("Decimal overflow");
+			store(buf, sign | (ieee_t)COMB_INF << (f->bits - 6),
+					f->bits);
+			return TT_APN_EOVERFLOW;
+		}
+		if (c)
+			c *= pow10_ieee(pad);
+		q = qmax;
+	}
+	if (c == 0 && ret == TT_APN_EROUNDED) {
+		tt_warn("Decimal underflow");
+		ret = TT_APN_EUNDERFLOW;
+	}
+
+	store(buf, sign | encode(f, dpd, c, q + f->bias), f->bits);
+	return ret;
+}
+
+/* Decode IEEE decimal interchange format to dec
+ * - buf: uint32_t, uint64_t, or uint64_t[2] (low half first), host order
+ * - return 0, TT_APN_EROUNDED if coefficient exceeds precision of dec, or
+ *   error code
+ */
+int tt_dec_from_ieee(struct tt_dec *dec, const void *buf, int fmt)
+{
+	int ret = check_fmt(fmt);
+	if (ret)
+		return ret;
+
+	const struct ieee_fmt *f = &fmts[fmt % 3];
+	const ieee_t x = load(buf, f->bits);
+
+	_tt_dec_zero(dec);
+	dec->_sign = x >> (f->bits - 1);
+
+	ieee_t c;
+	int e;
+	const int special = decode(f, fmt >= TT_DEC_DPD32, x, &c, &e);
+	if (special) {
+		dec->_inf_nan = special;
+		return 0;
+	}
+	int q = e - f->bias;
+
+	/* Round to precision of dec */
+	const int digs = coef_digs(c);
+	if (digs > dec->_prec) {
+		const int k = digs - dec->_prec;
+		const ieee_t p = pow10_ieee(k - 1);
+		const uint rnd = c / p % 10;
+		const bool sticky = c % p != 0;
+		if (sticky || rnd)
+			ret = TT_APN_EROUNDED;
+		c /= p * 10;
+		c += _tt_round(c & 1, rnd == 5 && sticky ? 6 : rnd, 0);
+		q += k;
+		if (c == pow10_ieee(dec->_prec)) {
+			c /= 10;
+			q++;
+		}
+	}
+
+#ifdef __SIZEOF_INT128__
+	dec->_msb = _tt_dec_uint128_to_dec(dec->_dig, c);
+#else
+	dec->_msb = _tt_dec_uint_to_dec(dec->_dig, c);
+#endif
+	/* Zero with positive exponent is plain 0 */
+	dec->_exp = c == 0 && q > 0 ? 0 : q;
+
+	return ret;
+}
@@ -6,11 +6,16 @@
 #include <tt/apn/decimal.h>
 #include <tt/common/round.h>
 #include <common/lib.h>
+#include <common/stats.h>
 #include "decimal.h"
 
 #include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
 #include <math.h>
+#include <float.h>
 
+#ifndef __STDC_IEC_559__
 static const long double _exp10[] = {
 	1E1L, 1E2L, 1E4L, 1E8L, 1E16L, 1E32L, 1E64L, 1E128L, 1E256L
 };
@@ -53,13 +58,147 @@ static int norm_fp_to_i64(double num, uint64_t *ui64)
 
 	return adjexp;
 }
+#endif
+
+#ifdef __STDC_IEC_559__
+/* floor(log10(2^e)), floor(log10(3/4 * 2^e)), floor(log2(10^e))
+ * - exact for exponents of double and _tt_dec_pow10_tbl
+ */
+#define FLOOR_LOG10_POW2(e)	(((e) * 1262611) >> 22)
+#define FLOOR_LOG10_POW2_3_4(e)	(((e) * 1262611 - 524031) >> 22)
+#define FLOOR_LOG2_POW10(e)	(((e) * 1741647) >> 19)
+
+static const uint64_t pow10_u64[] = {
+	1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL,
+	10000000ULL, 100000000ULL, 1000000000ULL, 10000000000ULL,
+	100000000000ULL, 1000000000000ULL, 10000000000000ULL,
+	100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL,
+	100000000000000000ULL, 1000000000000000000ULL,
+	10000000000000000000ULL,
+};
+
+/* 128-bit normalized 10^k, most significant half first */
+static inline const uint64_t *pow10_128(int k)
+{
+	return _tt_dec_pow10_tbl[k - _TT_DEC_POW10_MIN];
+}
+
+/* Return low 64 bits of a * b, *hi = high 64 bits */
+static inline uint64_t mul_64(uint64_t a, uint64_t b, uint64_t *hi)
+{
+#ifdef __SIZEOF_INT128__
+	const __uint128_t p = (__uint128_t)a * b;
+
+	*hi = p >> 64;
+	return p;
+#else
+	const uint64_t a0 = (uint32_t)a, a1 = a >> 32;
+	const uint64_t b0 = (uint32_t)b, b1 = b >> 32;
+	const uint64_t p01 = a0 * b1, p10 = a1 * b0, p00 = a0 * b0;
+	const uint64_t mid = (p00 >> 32) + (uint32_t)p01 + (uint32_t)p10;
+
+	*hi = a1 * b1 + (p01 >> 32) + (p10 >> 32) + (mid >> 32);
+	return mid << 32 | (uint32_t)p00;
+#endif
+}
+
+/* Round to odd of g * cp / 2^128 */
+static inline uint64_t round_to_odd(uint64_t g1, uint64_t g0, uint64_t cp)
+{
+	uint64_t x1, y1;
+
+	mul_64(g0, cp, &x1);
+	const uint64_t y0 = mul_64(g1, cp, &y1);
+	const uint64_t z = y0 + x1;
+	y1 += z < y0;
+
+	return y1 | (z > 1);
+}
+
+/* Shortest decimal sig * 10^exp rounding back to a positive finite double
+ * - Raffaello Giulietti: The Schubfach way to render doubles
+ * - return sig, *exp
+ */
+static uint64_t to_shortest(uint64_t bits, int *exp)
+{
+	const uint64_t frac = bits & ((1ULL << 52) - 1);
+	const int be = bits >> 52;
+	uint64_t c;
+	int q;
+
+	if (be) {
+		c = frac | (1ULL << 52);
+		q = be - 1075;
+		/* Integers below 2^53 are kept as is */
+		if (q <= 0 && q > -53 && (c & ((1ULL << -q) - 1)) == 0) {
+			*exp = 0;
+			return c >> -q;
+		}
+	} else {
+		c = frac;
+		q = -1074;
+	}
+
+	/* Rounding interval [cbl, cbr] * 2^(q-2), inclusive if c is even */
+	const int even = !(c & 1);
+	const int closer = frac == 0 && be > 1;
+	const uint64_t cbl = c * 4 - 2 + closer, cb = c * 4, cbr = c * 4 + 2;
+
+	const int k = closer ? FLOOR_LOG10_POW2_3_4(q) : FLOOR_LOG10_POW2(q);
+	const int h = q + FLOOR_LOG2_POW10(-k) + 1;
+
+	/* 10^-k rounded up */
+	const uint64_t *t = pow10_128(-k);
+	const uint64_t g0 = t[1] + 1, g1 = t[0] + (g0 == 0);
+	const uint64_t vbl = round_to_odd(g1, g0, cbl << h);
+	const uint64_t vb = round_to_odd(g1, g0, cb << h);
+	const uint64_t vbr = round_to_odd(g1, g0, cbr << h);
+	const uint64_t lower = vbl + !even, upper = vbr - !even;
+
+	uint64_t s = vb / 4;
+	int e = k;
+	bool done = false;
+
+	/* One digit less, at most one of u' and w' is in range */
+	if (s >= 10) {
+		const uint64_t sp = s / 10;
+		const bool up_in = lower <= sp * 40;
+		const bool wp_in = sp * 40 + 40 <= upper;
+		if (up_in != wp_in) {
+			s = sp + wp_in;
+			e++;
+			done = true;
+		}
+	}
+
+	if (!done) {
+		const bool u_in = lower <= s * 4;
+		const bool w_in = s * 4 + 4 <= upper;
+		if (u_in != w_in) {
+			s += w_in;
+		} else {
+			/* Both in range, pick closer one, tie to even */
+			const uint64_t mid = s * 4 + 2;
+			s += vb > mid || (vb == mid && (s & 1));
+		}
+	}
+
+	while (s % 10 == 0) {
+		s /= 10;
+		e++;
+	}
+
+	*exp = e;
+	return s;
+}
+#endif
 
 int tt_dec_from_uint(struct tt_dec *dec, uint64_t num)
 {
 	tt_assert(dec->_prec >= 20);
 
 	_tt_dec_zero(dec);
-	dec->_msb = _tt_dec_uint_to_dec(dec->_dig32, num);
+	dec->_msb = _tt_dec_uint_to_dec(dec->_dig, num);
 
 	return 0;
 }
@@ -85,6 +224,7 @@ int tt_dec_from_sint(struct tt_dec *dec, int64_t num)
 
 int tt_dec_from_float(struct tt_dec *dec, double num)
 {
+	_tt_stat_func(TT_STAT_DEC_FROM_FLOAT);
 	tt_assert(dec->_prec >= 20);
 
 	_tt_dec_zero(dec);
@@ -103,6 +243,17 @@ int tt_dec_from_float(struct tt_dec *dec, double num)
 		break;
 	}
 
+#ifdef __STDC_IEC_559__
+	/* Shortest digits reading back to same double */
+	union {
+		double d;
+		uint64_t i;
+	} v = { .d = num };
+	int exp;
+	const uint64_t sig = to_shortest(v.i & ~(1ULL << 63), &exp);
+	dec->_msb = _tt_dec_uint_to_dec(dec->_dig, sig);
+	dec->_exp = exp;
+#else
 	if (sign)
 		num = -num;
 
@@ -113,6 +264,7 @@ int tt_dec_from_float(struct tt_dec *dec, double num)
 	int adjexp = norm_fp_to_i64(num, &ui64);
 	tt_dec_from_uint(dec, ui64);
 	dec->_exp = adjexp;
+#endif
 	dec->_sign = sign;
 
 	return 0;
@@ -151,14 +303,101 @@ int tt_dec_from_float(struct tt_dec *dec, double num)
  * | - |  2047  | nonzero |            NaN            |
  * +---+--------+---------+---------------------------+
  */
+/* w * 10^q to double by Eisel-Lemire algorithm
+ * - Daniel Lemire: Number Parsing at a Gigabyte per Second
+ * - w != 0, _TT_DEC_POW10_MIN <= q <= 308
+ * - return 0: *bits, -1: result not certain or not normal
+ */
+static int eisel_lemire(uint64_t w, int q, uint64_t *bits)
+{
+	int lz = __builtin_clzll(w);
+	w <<= lz;
+
+	/* Truncated w * 10^q, below exact value by less than w at bit 0 */
+	const uint64_t *t = pow10_128(q);
+	uint64_t hi, hi2, lo = mul_64(w, t[0], &hi);
+	if ((hi & 0x1FF) == 0x1FF) {
+		/* Carry may go beyond rounding bits, refine with low half */
+		mul_64(w, t[1], &hi2);
+		lo += hi2;
+		hi += lo < hi2;
+		if ((hi & 0x1FF) == 0x1FF && lo >= ~1ULL)
+			return -1;
+	}
+
+	/* 54 bits with rounding bit */
+	const int upper = hi >> 63;
+	uint64_t m = hi >> (upper + 9);
+	lz += 1 ^ upper;
+
+	/* Looks like a tie, true value may be slightly above */
+	if (lo == 0 && (hi & 0x1FF) == 0 && (m & 3) == 1)
+		return -1;
+
+	m += m & 1;
+	m >>= 1;
+	int e = FLOOR_LOG2_POW10(q) + 1087 - lz;
+	if (m >= (1ULL << 53)) {
+		m = 1ULL << 52;
+		e++;
+	}
+	if (e < 1 || e > 2046)
+		return -1;
+
+	*bits = (m & ~(1ULL << 52)) | (uint64_t)e << 52;
+	return 0;
+}
+
+/* Correctly rounded by strtod()
+ * - digits beyond 767 only matter as a sticky non-zero digit
+ * - no decimal point, not affected by locale
+ */
+#define SLOW_DIGS	780
+
+static double to_float_slow(const struct tt_dec *dec)
+{
+	char s[SLOW_DIGS + 16];
+	const int msb = dec->_msb, n = _tt_min(msb, SLOW_DIGS);
+	int exp = dec->_exp + msb - n, len = 0;
+
+	for (int i = msb - 1; i >= msb - n; i--)
+		s[len++] = '0' + _tt_dec_get_dig(dec->_dig, i);
+	if (msb > n && _tt_dec_any_dig(dec->_dig, msb - n)) {
+		s[len++] = '1';
+		exp--;
+	}
+	snprintf(s + len, sizeof(s) - len, "E%d", exp);
+
+	return strtod(s, NULL);
+}
+
+/* Digits [lo, msb) of significand, msb - lo <= 19 */
+static uint64_t get_top19(const struct tt_dec *dec, int lo)
+{
+	const _tt_dec_word *dig = dec->_dig;
+	const int wl = lo / _TT_DEC_DIGS, r = lo % _TT_DEC_DIGS;
+	uint64_t w = 0;
+
+	for (int i = _tt_dec_words(dec->_msb) - 1; i > wl; i--)
+		w = w * _TT_DEC_BASE + dig[i];
+	return w * pow10_u64[_TT_DEC_DIGS - r] + dig[wl] / pow10_u64[r];
+}
+
+/* Convert to correctly rounded double
+ * - exact w * 10^q: w < 2^53 and 10^|q| are exact doubles, one IEEE
+ *   multiply or divide rounds correctly (Clinger)
+ * - otherwise Eisel-Lemire on top 19 digits, if digits are dropped, both
+ *   w and w+1 must round to same double
+ * - fall back to strtod()
+ */
 int tt_dec_to_float(const struct tt_dec *dec, double *num)
 {
+	_tt_stat_func(TT_STAT_DEC_TO_FLOAT);
 	int ret = 0;
 	union {
 		uint64_t i;
 		double d;
 	} v;
-	struct tt_dec *dec_mm = NULL;
 
 	/* Check zero */
 	if (_tt_dec_is_zero(dec)) {
@@ -177,79 +416,55 @@ int tt_dec_to_float(const struct tt_dec *dec, double *num)
 		goto out;
 	}
 
-	dec_mm = tt_dec_alloc(0);
-
-	/* Check overflow */
-	v.i = (2046ULL << 52) | ((1ULL << 52) - 1);	/* Max double */
-	tt_dec_from_float(dec_mm, v.d);
-	if (tt_dec_cmp_abs(dec, dec_mm) >= 0) {
-		v.i = 2047ULL << 52;	/* Inf */
-		ret = TT_APN_EOVERFLOW;
-		tt_warn("Float overflow");
-		goto out;
+	/* 10^(mag-1) <= |dec| < 10^mag */
+	const int msb = dec->_msb;
+	const int64_t mag = (int64_t)dec->_exp + msb;
+	if (mag > 309) {
+		v.i = 2047ULL << 52;
+		goto check;
 	}
-
-	/* Check underflow
-	 * XXX: Unnormalized double bound may cause underrun in the div loop.
-	 */
-#if 1
-	v.i = 1;		/* Unnormalized, 4.94E-324 */
-#else
-	v.i = 1ULL << 52;	/* Normalized, 2.22E-308 */
-#endif
-	tt_dec_from_float(dec_mm, v.d);
-	if (tt_dec_cmp_abs(dec_mm, dec) >= 0) {
+	if (mag < -323) {
 		v.i = 0;
-		ret = TT_APN_EUNDERFLOW;
-		tt_warn("Float underflow");
-		goto out;
+		goto check;
 	}
 
-	/* Round to 19 significands */
-	int sfr = 0, rnd = 0;
-	if (dec->_msb > 19) {
-		sfr = dec->_msb - 19;
-		rnd = _tt_round(_tt_dec_get_dig(dec->_dig32, sfr) & 1,
-					_tt_dec_get_dig(dec->_dig32, sfr-1),
-					TT_ROUND_HALF_AWAY0);
-	}
+	const int sfr = _tt_max(msb - 19, 0), q = dec->_exp + sfr;
+	const uint64_t w = get_top19(dec, sfr);
+	const bool dropped = sfr && _tt_dec_any_dig(dec->_dig, sfr);
 
-	/* Calculate significand */
-	long double ld = 0;
-	for (int i = dec->_msb - 1; i >= sfr; i--) {
-		/* We can do much better here. Is it necessary? */
-		ld *= 10;
-		ld += _tt_dec_get_dig(dec->_dig32, i);
+#if FLT_EVAL_METHOD == 0
+	static const double exact10[] = {
+		1E0, 1E1, 1E2, 1E3, 1E4, 1E5, 1E6, 1E7, 1E8, 1E9, 1E10, 1E11,
+		1E12, 1E13, 1E14, 1E15, 1E16, 1E17, 1E18, 1E19, 1E20, 1E21,
+		1E22,
+	};
+	if (!dropped && w <= (1ULL << 53) && q >= -22 && q <= 22) {
+		v.d = w;
+		if (q < 0)
+			v.d /= exact10[-q];
+		else
+			v.d *= exact10[q];
+		goto check;
 	}
-	ld += rnd;	/* May cause overflow? */
-
-	/* Multiply/divide exponent */
-	int _exp = dec->_exp + sfr;
-	int i = ARRAY_SIZE(_exp10) - 1;	/* _exp = 10^(2^i) */
-	if (_exp > 0) {
-		while (_exp > 0) {
-			if (_exp >= 1U << i) {
-				ld *= _exp10[i];
-				_exp -= 1U << i;
-			}
-			i--;
-		}
-	} else if (_exp < 0) {
-		_exp = -_exp;
-		while (_exp > 0) {
-			if (_exp >= 1U << i) {
-				ld /= _exp10[i];
-				_exp -= 1U << i;
-			}
-			i--;
-		}
+#endif
+
+	uint64_t bits2;
+	if (eisel_lemire(w, q, &v.i) == 0 && (!dropped ||
+			(eisel_lemire(w + 1, q, &bits2) == 0 && bits2 == v.i)))
+		goto check;
+
+	v.d = to_float_slow(dec);
+
+check:
+	if (v.i == 2047ULL << 52) {
+		ret = TT_APN_EOVERFLOW;
+		tt_warn("Float overflow");
+	} else if (v.i == 0) {
+		ret = TT_APN_EUNDERFLOW;
+		tt_warn("Float underflow");
 	}
-	v.d = ld;
 
 out:
-	if (dec_mm)
-		tt_dec_free(dec_mm);
-
 	/* Check sign */
 	if (dec->_sign)
 		v.i |= 1ULL << 63;
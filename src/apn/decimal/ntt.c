@@ -0,0 +1,281 @@
+/* Number theoretic transform multiplication
+ *
+ * Significands are repacked to base 10^9 coefficients and convolved modulo
+ * three NTT friendly primes, the exact convolution is recovered by CRT.
+ * Coefficient products sum to less than n * 10^18, far below the product
+ * of the primes (~1.7 * 10^27), so transforms up to 2^26 points are exact.
+ *
+ * Copyright (C) 2016 Yibo Cai
+ */
+#include <tt/tt.h>
+#include <tt/apn/decimal.h>
+#include <common/lib.h>
+#include "decimal.h"
+
+#include <string.h>
+
+#define NTT_BASE	1000000000U
+#define NTT_MAX_LOG2	26
+
+/* Primes p = k * 2^m + 1 < 2^31 */
+#define P0	469762049U	/* 7 * 2^26 + 1 */
+#define P1	1811939329U	/* 27 * 2^26 + 1 */
+#define P2	2013265921U	/* 15 * 2^27 + 1 */
+
+struct prime {
+	uint p;
+	uint g;		/* Primitive root */
+	uint pinv;	/* -p^-1 mod 2^32 */
+	uint r2;	/* 2^64 mod p */
+};
+
+static const struct prime primes[3] = {
+	{ .p = P0, .g = 3, .pinv = 469762047, .r2 = 460175152 },
+	{ .p = P1, .g = 13, .pinv = 1811939327, .r2 = 959408210 },
+	{ .p = P2, .g = 31, .pinv = 2013265919, .r2 = 1172168163 },
+};
+
+#if CONFIG_DEC_DIG64
+static const uint64_t pow10_tbl[] = {
+	1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000,
+	1000000000ULL, 10000000000ULL, 100000000000ULL, 1000000000000ULL,
+	10000000000000ULL, 100000000000000ULL, 1000000000000000ULL,
+	10000000000000000ULL, 100000000000000000ULL, 1000000000000000000ULL,
+};
+#endif
+
+/* Montgomery multiplication, R = 2^32
+ * - a, b < p, return a * b / R mod p
+ */
+static inline uint mont_mul(uint a, uint b, const struct prime *pr)
+{
+	const uint64_t t = (uint64_t)a * b;
+	const uint m = (uint)t * pr->pinv;
+	const uint u = (t + (uint64_t)m * pr->p) >> 32;
+
+	return u >= pr->p ? u - pr->p : u;
+}
+
+/* a * R mod p */
+static inline uint to_mont(uint a, const struct prime *pr)
+{
+	return mont_mul(a, pr->r2, pr);
+}
+
+static uint pow_mod(uint a, uint e, uint p)
+{
+	uint64_t r = 1, b = a % p;
+
+	for (; e; e >>= 1) {
+		if (e & 1)
+			r = r * b % p;
+		b = b * b % p;
+	}
+
+	return r;
+}
+
+/* Twiddle factors in Montgomery form
+ * - tw[h + j] = w_2h^j, h = 1, 2, 4, ..., n/2, j = 0 ~ h-1
+ */
+static void make_twiddle(uint *tw, int n, const struct prime *pr)
+{
+	const uint p = pr->p;
+
+	for (int h = 1; h < n; h *= 2) {
+		const uint w = to_mont(pow_mod(pr->g, (p - 1) / (h * 2), p),
+				pr);
+
+		uint t = to_mont(1, pr);
+		for (int j = 0; j < h; j++) {
+			tw[h + j] = t;
+			t = mont_mul(t, w, pr);
+		}
+	}
+}
+
+/* Decimation in frequency, natural order in, bit reversed order out */
+static void ntt_dif(uint *a, int n, const uint *tw, const struct prime *pr)
+{
+	const uint p = pr->p;
+
+	for (int h = n / 2; h >= 1; h /= 2) {
+		for (int i = 0; i < n; i += h * 2) {
+			uint *a0 = a + i, *a1 = a0 + h;
+			for (int j = 0; j < h; j++) {
+				const uint u = a0[j], v = a1[j];
+				const uint s = u + v;
+				a0[j] = s >= p ? s - p : s;
+				a1[j] = mont_mul(u >= v ? u - v : u + p - v,
+						tw[h + j], pr);
+			}
+		}
+	}
+}
+
+/* Decimation in time, bit reversed order in, natural order out
+ * - forward roots, inverse transform is got by reversing a[1] ~ a[n-1]
+ */
+static void ntt_dit(uint *a, int n, const uint *tw, const struct prime *pr)
+{
+	const uint p = pr->p;
+
+	for (int h = 1; h < n; h *= 2) {
+		for (int i = 0; i < n; i += h * 2) {
+			uint *a0 = a + i, *a1 = a0 + h;
+			for (int j = 0; j < h; j++) {
+				const uint u = a0[j];
+				const uint v = mont_mul(a1[j], tw[h + j], pr);
+				const uint s = u + v;
+				a0[j] = s >= p ? s - p : s;
+				a1[j] = u >= v ? u - v : u + p - v;
+			}
+		}
+	}
+}
+
+/* Repack words to base 10^9 coefficients, return coefficient count */
+static int to_coef(uint *c, const _tt_dec_word *dig, int words)
+{
+#if CONFIG_DEC_DIG64
+	int n = 0, accd = 0;
+	uint64_t acc = 0;
+
+	for (int i = 0; i < words; i++) {
+		_tt_dec_word w = dig[i];
+		int digs = _TT_DEC_DIGS;
+
+		while (accd + digs >= 9) {
+			const int need = 9 - accd;
+			c[n++] = acc + w % pow10_tbl[need] * pow10_tbl[accd];
+			w /= pow10_tbl[need];
+			digs -= need;
+			acc = accd = 0;
+		}
+		acc = w;
+		accd = digs;
+	}
+	if (accd)
+		c[n++] = acc;
+
+	return n;
+#else
+	memcpy(c, dig, words * sizeof(uint));
+	return words;
+#endif
+}
+
+/* Repack base 10^9 coefficients to words, drop leading zeros past words */
+static void from_coef(_tt_dec_word *dig, int words, const uint *c, int n)
+{
+#if CONFIG_DEC_DIG64
+	int k = 0, accd = 0;
+	_tt_dec_word acc = 0;
+
+	for (int i = 0; i < n && k < words; i++) {
+		const int room = _TT_DEC_DIGS - accd;
+		if (room > 9) {
+			acc += c[i] * pow10_tbl[accd];
+			accd += 9;
+		} else {
+			dig[k++] = acc + c[i] % pow10_tbl[room] *
+				pow10_tbl[accd];
+			acc = c[i] / pow10_tbl[room];
+			accd = 9 - room;
+		}
+	}
+	if (k < words)
+		dig[k++] = acc;
+	if (k < words)
+		memset(dig + k, 0, (words - k) * _tt_dec_word_sz);
+#else
+	n = _tt_min(n, words);
+	memcpy(dig, c, n * sizeof(uint));
+	memset(dig + n, 0, (words - n) * _tt_dec_word_sz);
+#endif
+}
+
+/* digr = dig1 * dig2
+ * - words1, words2: word count of operands
+ * - digr: words1 + words2 words
+ * - return 0 or error code
+ */
+int _tt_dec_mul_ntt(_tt_dec_word *digr, const _tt_dec_word *dig1, int words1,
+		const _tt_dec_word *dig2, int words2)
+{
+	const int n1 = (words1 * _TT_DEC_DIGS + 8) / 9;
+	const int n2 = (words2 * _TT_DEC_DIGS + 8) / 9;
+
+	int log2 = 1;
+	while ((1 << log2) < n1 + n2)
+		log2++;
+	if (log2 > NTT_MAX_LOG2) {
+		tt_error("NTT size too large");
+		return TT_APN_EOVERFLOW;
+	}
+	const int n = 1 << log2;
+
+	/* Residues of three primes, one operand buffer, twiddle table */
+	uint *buf = malloc(n * 5 * sizeof(uint));
+	if (buf == NULL)
+		return TT_ENOMEM;
+	uint *res[3] = { buf, buf + n, buf + n * 2 };
+	uint *b = buf + n * 3, *tw = b + n;
+
+	for (int k = 0; k < 3; k++) {
+		const struct prime *pr = &primes[k];
+		uint *a = res[k];
+
+		make_twiddle(tw, n, pr);
+
+		/* Coefficients < 10^9 may exceed p, reduce them */
+		int m = to_coef(a, dig1, words1);
+		for (int i = 0; i < m; i++)
+			a[i] %= pr->p;
+		memset(a + m, 0, (n - m) * sizeof(uint));
+		m = to_coef(b, dig2, words2);
+		for (int i = 0; i < m; i++)
+			b[i] %= pr->p;
+		memset(b + m, 0, (n - m) * sizeof(uint));
+
+		ntt_dif(a, n, tw, pr);
+		ntt_dif(b, n, tw, pr);
+		for (int i = 0; i < n; i++)
+			a[i] = mont_mul(a[i], b[i], pr);
+		ntt_dit(a, n, tw, pr);
+		for (int i = 1; i < n / 2; i++)
+			__tt_swap(a[i], a[n - i]);
+
+		/* Undo 1/R of pointwise product and n of inverse transform */
+		const uint scale = to_mont(to_mont(pow_mod(n, pr->p - 2,
+						pr->p), pr), pr);
+		for (int i = 0; i < n; i++)
+			a[i] = mont_mul(a[i], scale, pr);
+	}
+
+	/* Garner: x = r0 + p0 * (k1 + p1 * k2), k1 < p1, k2 < p2 */
+	const uint64_t inv01 = pow_mod(P0, P1 - 2, P1);
+	const uint64_t inv012 = pow_mod((uint64_t)P0 * P1 % P2, P2 - 2, P2);
+
+	/* Carry < 2^61, s never overflows */
+	uint64_t carry = 0;
+	const int nr = n1 + n2;
+	for (int i = 0; i < nr; i++) {
+		const uint64_t r0 = res[0][i], r1 = res[1][i], r2 = res[2][i];
+		const uint64_t k1 = (r1 + P1 - r0) * inv01 % P1;
+		const uint64_t x01 = (r0 + P0 * k1) % P2;
+		const uint64_t k2 = (r2 + P2 - x01) * inv012 % P2;
+		const uint64_t h = k1 + P1 * k2;
+
+		/* x + carry = s + p0 * (h / 10^9) * 10^9 */
+		const uint64_t s = r0 + P0 * (h % NTT_BASE) + carry;
+		b[i] = s % NTT_BASE;
+		carry = s / NTT_BASE + P0 * (h / NTT_BASE);
+	}
+	tt_assert_fa(carry == 0);
+
+	from_coef(digr, words1 + words2, b, nr);
+
+	free(buf);
+	return 0;
+}
@@ -6,163 +6,576 @@
 #include <tt/apn/decimal.h>
 #include <tt/common/round.h>
 #include <common/lib.h>
+#include <common/stats.h>
 #include "decimal.h"
 
 #include <string.h>
+#include <limits.h>
 #include <math.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
-static int parse_coef(struct tt_dec *dec, const char *s, int len, int *adjexp,
+/* Read buffer of tt_dec_from_fd() on non regular files */
+#define LOAD_CHUNK	(64 * 1024)
+
+/* Exponent limit, leaves room for adjustment */
+#define EXP_MAX		(INT_MAX / 2)
+
+/* SWAR (SIMD within a register) digit conversion
+ * - eight ASCII digits are held in one uint64_t, first char at lowest byte
+ * - big endian hosts swap bytes after load and before store
+ */
+#define SWAR_ONES	0x0101010101010101ULL
+
+static inline uint64_t swar_load(const char *p)
+{
+	uint64_t x;
+
+	memcpy(&x, p, 8);
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	x = __builtin_bswap64(x);
+#endif
+	return x;
+}
+
+static inline void swar_store(char *p, uint64_t x)
+{
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	x = __builtin_bswap64(x);
+#endif
+	memcpy(p, &x, 8);
+}
+
+/* Set high bit of bytes which are not ASCII digits */
+static inline uint64_t swar_nondigit(uint64_t x)
+{
+	const uint64_t lo7 = x & (SWAR_ONES * 0x7F);
+
+	/* > '9': lo7 + 0x46 >= 0x80, < '0': lo7 + 0x50 < 0x80 */
+	return ((lo7 + SWAR_ONES * 0x46) | ~(lo7 + SWAR_ONES * 0x50) | x) &
+		(SWAR_ONES * 0x80);
+}
+
+/* Eight ASCII digits to integer, combine pairs, quads, then halves */
+static inline uint swar_parse8(uint64_t x)
+{
+	x -= SWAR_ONES * '0';
+	x = (x * 10 + (x >> 8)) & 0x00FF00FF00FF00FFULL;
+	x = (x * 100 + (x >> 16)) & 0x0000FFFF0000FFFFULL;
+	return (uint)(x * 10000 + (x >> 32));
+}
+
+/* Integer < 10^8 to eight ASCII digits, split halves, quads, then pairs */
+static inline uint64_t swar_format8(uint v)
+{
+	uint64_t x = (v / 10000) | ((uint64_t)(v % 10000) << 32);
+	uint64_t hi = ((x * 10486) >> 20) & 0x0000007F0000007FULL;
+
+	x = ((x - hi * 100) << 16) | hi;
+	hi = ((x * 103) >> 10) & 0x000F000F000F000FULL;
+	x = ((x - hi * 10) << 8) | hi;
+	return x + SWAR_ONES * '0';
+}
+
+/* Return first non digit in [p, end) */
+static const char *skip_digits(const char *p, const char *end)
+{
+	for (; end - p >= 8; p += 8) {
+		const uint64_t m = swar_nondigit(swar_load(p));
+		if (m)
+			return p + __builtin_ctzll(m) / 8;
+	}
+	while (p < end && *p >= '0' && *p <= '9')
+		p++;
+	return p;
+}
+
+/* Return first non '0' in [p, end), all chars are digits */
+static const char *skip_zeros(const char *p, const char *end)
+{
+	for (; end - p >= 8; p += 8) {
+		const uint64_t m = swar_load(p) ^ (SWAR_ONES * '0');
+		if (m)
+			return p + __builtin_ctzll(m) / 8;
+	}
+	while (p < end && *p == '0')
+		p++;
+	return p;
+}
+
+/* n <= _TT_DEC_DIGS digits to word */
+static inline _tt_dec_word parse_digs(const char *p, int n)
+{
+	_tt_dec_word w = 0;
+
+	for (; n >= 8; n -= 8, p += 8)
+		w = w * 100000000 + swar_parse8(swar_load(p));
+	for (; n; n--)
+		w = w * 10 + (*p++ - '0');
+	return w;
+}
+
+/* Coefficient digits: integer part s[0], fraction part s[1] */
+struct coef {
+	const char *s[2];
+	int n[2];
+};
+
+/* Digit at position i */
+static inline int coef_dig(const struct coef *c, int i)
+{
+	return (i < c->n[0] ? c->s[0][i] : c->s[1][i - c->n[0]]) - '0';
+}
+
+/* n digits from position i to word */
+static inline _tt_dec_word coef_word(const struct coef *c, int i, int n)
+{
+	if (i + n <= c->n[0])
+		return parse_digs(c->s[0] + i, n);
+	if (i >= c->n[0])
+		return parse_digs(c->s[1] + i - c->n[0], n);
+
+	/* Straddles point */
+	_tt_dec_word w = 0;
+	for (; n; n--, i++)
+		w = w * 10 + coef_dig(c, i);
+	return w;
+}
+
+static int parse_coef(struct tt_dec *dec, const struct coef *c, int *adjexp,
 		int *adjrnd)
 {
 	int ret = 0;
+	const int len = c->n[0] + c->n[1];
 
-	/* Check syntax, point position, msb */
-	bool nopoint = true;
-	int ptpos = len - 1, msb = len - 1;
-	for (int i = 0; i < len; i++) {
-		if (s[i] == '.') {
-			nopoint = false;
-			if (ptpos == (len - 1))
-				ptpos = i;
-			else
-				return TT_EINVAL;	/* More than one "." */
-		} else if (s[i] >= '0' && s[i] <= '9') {
-			if (msb == (len - 1) && s[i] != '0')
-				msb = i;
-		} else {
-			return TT_EINVAL;
-		}
-	}
+	/* Skip leading zeros, keep one digit for zero */
+	int msb = skip_zeros(c->s[0], c->s[0] + c->n[0]) - c->s[0];
+	if (msb == c->n[0])
+		msb += skip_zeros(c->s[1], c->s[1] + c->n[1]) - c->s[1];
+	if (msb == len)
+		msb--;
 
-	/* Check exponent adjust, significand */
-	*adjexp = -(len - ptpos - 1);
+	*adjexp = -c->n[1];
 	int digs = len - msb;
-	if (!nopoint && ptpos > msb)
-		digs--;		/* Exclude "." from digits */
-	dec->_msb = digs;
 
 	/* Check rounding */
-	const char *s2 = s + len - 1;
 	if (digs > dec->_prec) {
 		tt_info("DEC rounded: %d -> %d", digs, dec->_prec);
 		ret = TT_APN_EROUNDED;
 
-		/* Drop trailing digits */
-		int drops = digs - dec->_prec;
-		dec->_msb -= drops;
-		*adjexp += drops;
-		while (s2 > s) {
-			if (*s2 != '.')
-				if (--drops == 0)
-					break;
-			s2--;
-		}
-		s2--;
-		tt_assert(s2 >= s && drops == 0);
-
-		/* Check round adjust */
-		const char *ssig = s2;
-		const char *srnd = s2 + 1;
-		while (*ssig == '.')
-			ssig--;
-		while (*srnd == '.')
-			srnd++;
-		tt_assert(*ssig >= '0' && *ssig <= '9' &&
-				*srnd >= '0' && *ssig <= '9');
-		*adjrnd = _tt_round((*ssig - '0') & 1, *srnd - '0', 0);
+		/* Drop trailing digits, round by last kept and first dropped */
+		*adjexp += digs - dec->_prec;
+		digs = dec->_prec;
+		*adjrnd = _tt_round(coef_dig(c, msb + digs - 1) & 1,
+				coef_dig(c, msb + digs), 0);
 	}
+	dec->_msb = digs;
 
-	/* Conversion: digits in [s, s2], may contain one point */
-	uint *dig32 = dec->_dig32;
-	uint dig = 0, n10 = 1;
-	int cnt = 0;
-	while (s2 >= s) {
-		if (*s2 != '.') {
-			dig += (*s2 - '0') * n10;
-			cnt++;
-			n10 *= 10;
-			if (cnt == 9) {
-				*dig32++ = dig;
-				cnt = 0;
-				dig = 0;
-				n10 = 1;
-			}
-		}
-		s2--;
+	/* Conversion: word by word from lsb */
+	_tt_dec_word *digw = dec->_dig;
+	for (int i = msb + digs; i > msb; ) {
+		const int n = _tt_min(i - msb, _TT_DEC_DIGS);
+		i -= n;
+		*digw++ = coef_word(c, i, n);
 	}
-	/* Partial digits at MSB */
-	if (cnt)
-		*dig32 = dig;
 
 	return ret;
 }
 
+/* Exponent: optional sign, at least one digit */
+static int parse_exp(const char *p, const char *end, int *exp)
+{
+	bool neg = false;
+
+	if (p < end && (*p == '-' || *p == '+'))
+		neg = *p++ == '-';
+	if (p == end)
+		return TT_EINVAL;
+
+	int e = 0;
+	for (; p < end; p++) {
+		if (*p < '0' || *p > '9')
+			return TT_EINVAL;
+		if (e > (EXP_MAX - 9) / 10)
+			return TT_EINVAL;	/* Out of range */
+		e = e * 10 + (*p - '0');
+	}
+	*exp = neg ? -e : e;
+
+	return 0;
+}
+
+/* Round up significand by one ulp if adjrnd, normalize zero */
+static void round_coef(struct tt_dec *dec, int adjrnd)
+{
+	if (adjrnd) {
+		_tt_dec_word one = 1;
+		struct tt_dec dec_1 = {
+			._sign = dec->_sign,
+			._inf_nan = 0,
+			._exp = dec->_exp,
+			._prec = 1,
+			._digsz = sizeof(one),
+			._msb = 1,
+			._dig = &one,
+		};
+		tt_dec_add(dec, dec, &dec_1);
+	}
+
+	/* Check zero */
+	if (_tt_dec_is_zero(dec) && dec->_exp > 0)
+		dec->_exp = 0;
+}
+
+/* Case insensitive match of three letters */
+static inline bool match3(const char *s, const char *word)
+{
+	return (s[0] | 0x20) == word[0] && (s[1] | 0x20) == word[1] &&
+		(s[2] | 0x20) == word[2];
+}
+
 int tt_dec_from_string(struct tt_dec *dec, const char *str)
 {
+	return tt_dec_from_strn(dec, str, strlen(str));
+}
+
+int tt_dec_from_strn(struct tt_dec *dec, const char *str, size_t len)
+{
+	_tt_stat_func(TT_STAT_DEC_FROM_STRING);
 	int ret;
+	const char *end = str + len;
 
 	_tt_dec_zero(dec);
 
 	/* Check leading "+", "-" */
-	if (*str == '-') {
-		dec->_sign = 1;
-		str++;
-	} else if (*str == '+') {
-		str++;
-	}
+	if (str < end && (*str == '-' || *str == '+'))
+		dec->_sign = *str++ == '-';
 
 	/* Check "NaN", "Inf" */
-	if (strcasecmp(str, "nan") == 0) {
-		dec->_inf_nan = TT_DEC_NAN;
-		return 0;
-	} else if (strcasecmp(str, "inf") == 0) {
-		dec->_inf_nan = TT_DEC_INF;
-		return 0;
+	if (end - str == 3) {
+		if (match3(str, "nan")) {
+			dec->_inf_nan = TT_DEC_NAN;
+			return 0;
+		} else if (match3(str, "inf")) {
+			dec->_inf_nan = TT_DEC_INF;
+			return 0;
+		}
 	}
 
-	/* Cut coefficient */
-	int epos = 0;
-	while (str[epos]) {
-		if (str[epos] == 'E' || str[epos] == 'e')
-			break;
-		epos++;
+	/* Cut coefficient: integer digits, optional point, fraction digits */
+	struct coef c;
+	c.s[0] = str;
+	str = skip_digits(str, end);
+	c.n[0] = str - c.s[0];
+	c.s[1] = str;
+	if (str < end && *str == '.') {
+		c.s[1] = ++str;
+		str = skip_digits(str, end);
 	}
-	if (epos == 0)
+	c.n[1] = str - c.s[1];
+	if (c.n[0] + c.n[1] == 0)
 		goto invalid;
 
+	/* Parse exponent */
+	int _exp = 0;
+	if (str < end) {
+		if ((*str != 'E' && *str != 'e') ||
+				parse_exp(str + 1, end, &_exp))
+			goto invalid;
+	}
+
 	/* Parse coefficient */
 	int adjexp = 0, adjrnd = 0;
-	ret = parse_coef(dec, str, epos, &adjexp, &adjrnd);
+	ret = parse_coef(dec, &c, &adjexp, &adjrnd);
 	if (ret < 0)
 		goto invalid;
+	dec->_exp = _exp + adjexp;
 
-	/* Parse exponent */
-	int _exp = 0;
-	if (str[epos]) {
-		if (_tt_atoi(str+epos+1, &_exp))
+	round_coef(dec, adjrnd);
+	return ret;
+
+invalid:
+	_tt_dec_zero(dec);
+	return TT_EINVAL;
+}
+
+#if CONFIG_DEC_DIG64
+static const _tt_dec_word pow10_word[] = {
+	1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000,
+	1000000000ULL, 10000000000ULL, 100000000000ULL, 1000000000000ULL,
+	10000000000000ULL, 100000000000000ULL, 1000000000000000ULL,
+	10000000000000000ULL, 100000000000000000ULL, 1000000000000000000ULL,
+	10000000000000000000ULL,
+};
+#else
+static const _tt_dec_word pow10_word[] = {
+	1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000,
+	1000000000,
+};
+#endif
+
+/* Streaming parser states */
+enum {
+	PS_SIGN,	/* Leading "+", "-" */
+	PS_INT,		/* Integer digits */
+	PS_FRAC,	/* Fraction digits */
+	PS_ESIGN,	/* Exponent sign */
+	PS_EXP,		/* Exponent digits */
+	PS_WORD,	/* "NaN", "Inf" */
+	PS_TRAIL,	/* Trailing white space */
+	PS_ERROR,
+};
+
+/* Digits are packed into significand words from msb as they arrive, and
+ * realigned to lsb in place by tt_dec_parser_finish()
+ */
+struct tt_dec_parser {
+	struct tt_dec *dec;
+	int state;
+	bool nonzero;		/* Non zero digit met */
+	bool eneg;		/* Negative exponent */
+	int edigs;		/* Exponent digits */
+	int exp;
+	int wlen;
+	char word[3];
+	int64_t digs;		/* Coefficient digits */
+	int64_t frac;		/* Fraction digits */
+	int64_t kept;		/* Significant digits in significand */
+	int64_t drops;		/* Significant digits dropped */
+	int lastodd;		/* Last kept digit is odd */
+	int rnd;		/* First dropped digit */
+	int words;		/* Full words stored */
+	int accd;		/* Digits in acc */
+	_tt_dec_word acc;	/* Partial word */
+};
+
+static inline bool is_space(char c)
+{
+	return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+static inline bool is_alpha(char c)
+{
+	return (c | 0x20) >= 'a' && (c | 0x20) <= 'z';
+}
+
+static void parser_init(struct tt_dec_parser *ps, struct tt_dec *dec)
+{
+	memset(ps, 0, sizeof(*ps));
+	ps->dec = dec;
+	_tt_dec_zero(dec);
+}
+
+/* Append n valid digits */
+static void put_digits(struct tt_dec_parser *ps, const char *p, int64_t n)
+{
+	ps->digs += n;
+	if (ps->state == PS_FRAC)
+		ps->frac += n;
+
+	if (!ps->nonzero) {
+		const char *q = skip_zeros(p, p + n);
+		n -= q - p;
+		if (n == 0)
+			return;
+		p = q;
+		ps->nonzero = true;
+	}
+
+	/* Keep up to precision */
+	int64_t k = _tt_min(n, ps->dec->_prec - ps->kept);
+	ps->kept += k;
+	n -= k;
+	while (k) {
+		const int m = _tt_min(k, _TT_DEC_DIGS - ps->accd);
+		ps->acc = ps->acc * pow10_word[m] + parse_digs(p, m);
+		ps->accd += m;
+		p += m;
+		k -= m;
+		if (ps->accd == _TT_DEC_DIGS) {
+			ps->dec->_dig[ps->words++] = ps->acc;
+			ps->acc = ps->accd = 0;
+		}
+	}
+
+	/* Drop the rest, keep first dropped digit for rounding */
+	if (n) {
+		if (ps->drops == 0) {
+			ps->lastodd = (ps->accd ? ps->acc :
+					ps->dec->_dig[ps->words-1]) & 1;
+			ps->rnd = *p - '0';
+		}
+		ps->drops += n;
+	}
+}
+
+struct tt_dec_parser *tt_dec_parser_alloc(struct tt_dec *dec)
+{
+	struct tt_dec_parser *ps = malloc(sizeof(*ps));
+
+	if (ps)
+		parser_init(ps, dec);
+	return ps;
+}
+
+void tt_dec_parser_free(struct tt_dec_parser *ps)
+{
+	free(ps);
+}
+
+int tt_dec_parser_feed(struct tt_dec_parser *ps, const char *buf, size_t len)
+{
+	const char *end = buf + len;
+
+	while (buf < end) {
+		const char c = *buf;
+
+		switch (ps->state) {
+		case PS_SIGN:
+			ps->state = PS_INT;
+			if (c == '-' || c == '+') {
+				ps->dec->_sign = c == '-';
+				break;
+			}
+			continue;
+
+		case PS_INT:
+		case PS_FRAC: {
+			const char *q = skip_digits(buf, end);
+			if (q > buf) {
+				put_digits(ps, buf, q - buf);
+				buf = q;
+				continue;
+			}
+			if (c == '.' && ps->state == PS_INT) {
+				ps->state = PS_FRAC;
+			} else if ((c == 'E' || c == 'e') && ps->digs) {
+				ps->state = PS_ESIGN;
+			} else if (is_space(c) && ps->digs) {
+				ps->state = PS_TRAIL;
+			} else if (is_alpha(c) && ps->state == PS_INT &&
+					ps->digs == 0) {
+				ps->state = PS_WORD;
+				continue;
+			} else {
+				goto invalid;
+			}
+			break;
+		}
+
+		case PS_ESIGN:
+			ps->state = PS_EXP;
+			if (c == '-' || c == '+') {
+				ps->eneg = c == '-';
+				break;
+			}
+			continue;
+
+		case PS_EXP:
+			if (c >= '0' && c <= '9') {
+				if (ps->exp > (EXP_MAX - 9) / 10)
+					goto invalid;	/* Out of range */
+				ps->exp = ps->exp * 10 + (c - '0');
+				ps->edigs++;
+			} else if (is_space(c) && ps->edigs) {
+				ps->state = PS_TRAIL;
+			} else {
+				goto invalid;
+			}
+			break;
+
+		case PS_WORD:
+			if (is_alpha(c) && ps->wlen < 3)
+				ps->word[ps->wlen++] = c;
+			else if (is_space(c))
+				ps->state = PS_TRAIL;
+			else
+				goto invalid;
+			break;
+
+		case PS_TRAIL:
+			if (!is_space(c))
+				goto invalid;
+			break;
+
+		default:
+			return TT_EINVAL;
+		}
+		buf++;
+	}
+
+	return 0;
+
+invalid:
+	ps->state = PS_ERROR;
+	return TT_EINVAL;
+}
+
+int tt_dec_parser_finish(struct tt_dec_parser *ps)
+{
+	_tt_stat_func(TT_STAT_DEC_FROM_STRING);
+	struct tt_dec *dec = ps->dec;
+	int ret = 0;
+
+	if (ps->state == PS_ERROR)
+		goto invalid;
+
+	/* Check "NaN", "Inf" */
+	if (ps->wlen) {
+		if (ps->wlen == 3 && match3(ps->word, "nan"))
+			dec->_inf_nan = TT_DEC_NAN;
+		else if (ps->wlen == 3 && match3(ps->word, "inf"))
+			dec->_inf_nan = TT_DEC_INF;
+		else
 			goto invalid;
+		return 0;
 	}
-	dec->_exp = _exp + adjexp;
 
-	/* Rounding */
-	if (adjrnd) {
-		uint one = 1;
-		struct tt_dec dec_1 = {
-			._sign = dec->_sign,
-			._inf_nan = 0,
-			._exp = dec->_exp,
-			._prec = 1,
-			._digsz = sizeof(one),
-			._msb = 1,
-			._dig32 = &one,
-		};
-		tt_dec_add(dec, dec, &dec_1);
+	if (ps->digs == 0 || ps->state == PS_ESIGN ||
+			(ps->state == PS_EXP && ps->edigs == 0))
+		goto invalid;
+
+	/* Check exponent */
+	const int64_t _exp = (ps->eneg ? -ps->exp : ps->exp) - ps->frac +
+		ps->drops;
+	if (_exp > EXP_MAX || _exp < -EXP_MAX)
+		goto invalid;
+	dec->_exp = _exp;
+
+	/* Flush partial word, reverse words to lsb first */
+	_tt_dec_word *dig = dec->_dig;
+	int words = ps->words;
+	if (ps->accd)
+		dig[words++] = ps->acc;
+	for (int i = 0, j = words - 1; i < j; i++, j--)
+		__tt_swap(dig[i], dig[j]);
+
+	/* Partial word is now the lowest, shift higher words down */
+	if (ps->accd) {
+		const _tt_dec_word lo = pow10_word[_TT_DEC_DIGS - ps->accd];
+		const _tt_dec_word hi = pow10_word[ps->accd];
+		_tt_dec_word w = dig[0];
+		for (int i = 1; i < words; i++) {
+			const _tt_dec_word d = dig[i];
+			dig[i-1] = w + d % lo * hi;
+			w = d / lo;
+		}
+		dig[words-1] = w;
 	}
+	dec->_msb = ps->kept ? ps->kept : 1;
 
-	/* Check zero */
-	if (_tt_dec_is_zero(dec) && dec->_exp > 0)
-		dec->_exp = 0;
+	/* Check rounding */
+	int adjrnd = 0;
+	if (ps->drops) {
+		tt_info("DEC rounded: %lld -> %d", (long long)ps->kept +
+				ps->drops, dec->_prec);
+		ret = TT_APN_EROUNDED;
+		adjrnd = _tt_round(ps->lastodd, ps->rnd, 0);
+	}
 
+	round_coef(dec, adjrnd);
 	return ret;
 
 invalid:
@@ -170,8 +583,88 @@ invalid:
 	return TT_EINVAL;
 }
 
+/* Load from file descriptor
+ * - regular file is mapped if read from start, others are read in chunks
+ */
+int tt_dec_from_fd(struct tt_dec *dec, int fd)
+{
+	struct tt_dec_parser ps;
+	struct stat st;
+
+	parser_init(&ps, dec);
+
+	if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0 &&
+			lseek(fd, 0, SEEK_CUR) == 0) {
+		void *p = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (p != MAP_FAILED) {
+			madvise(p, st.st_size, MADV_SEQUENTIAL);
+			tt_dec_parser_feed(&ps, p, st.st_size);
+			munmap(p, st.st_size);
+			return tt_dec_parser_finish(&ps);
+		}
+	}
+
+	char *buf = malloc(LOAD_CHUNK);
+	if (buf == NULL)
+		return TT_ENOMEM;
+
+	ssize_t n;
+	while ((n = read(fd, buf, LOAD_CHUNK)) != 0) {
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			free(buf);
+			_tt_dec_zero(dec);
+			return TT_EIO;
+		}
+		tt_dec_parser_feed(&ps, buf, n);
+	}
+	free(buf);
+
+	return tt_dec_parser_finish(&ps);
+}
+
+/* Write all digits of a word backwards, return new position */
+static inline char *put_word(char *p, _tt_dec_word w)
+{
+#if CONFIG_DEC_DIG64
+	/* Split to 3 + 8 + 8 digits */
+	swar_store(p - 8, swar_format8(w % 100000000));
+	w /= 100000000;
+	swar_store(p - 16, swar_format8(w % 100000000));
+	w /= 100000000;
+	p -= 16;
+	*--p = w % 10 + '0';
+	*--p = w / 10 % 10 + '0';
+	*--p = w / 100 + '0';
+#else
+	/* Split to 1 + 8 digits */
+	swar_store(p - 8, swar_format8(w % 100000000));
+	p -= 8;
+	*--p = w / 100000000 + '0';
+#endif
+	return p;
+}
+
+/* Write "E+n" or "E-n" with NUL */
+static void put_exp(char *p, int e)
+{
+	char buf[16], *q = buf + sizeof(buf);
+	uint u = e < 0 ? -(uint)e : e;
+
+	*p++ = 'E';
+	*p++ = e < 0 ? '-' : '+';
+	do {
+		*--q = u % 10 + '0';
+		u /= 10;
+	} while (u);
+	memcpy(p, q, buf + sizeof(buf) - q);
+	p[buf + sizeof(buf) - q] = '\0';
+}
+
 int tt_dec_to_string(const struct tt_dec *dec, char *str, uint len)
 {
+	_tt_stat_func(TT_STAT_DEC_TO_STRING);
 	tt_assert(len);
 	*str = '\0';
 
@@ -233,36 +726,35 @@ int tt_dec_to_string(const struct tt_dec *dec, char *str, uint len)
 			*str++ = '0';
 	}
 
-	/* Get valid uints */
-	int uints = (dec->_msb + 8) / 9;
-
-	/* Generate coefficient */
-	bool skip0 = true;
-	const uint *dig32 = dec->_dig32 + uints - 1;
-	int digs = 0;
-	while (digs < dec->_msb) {
-		/* Change to 9 decimals */
-		uchar dec9[9];
-		_tt_dec_to_d9(*dig32, dec9);
-		dig32--;
-
-		for (int i = 8; i >= 0; i--) {
-			if (skip0 && dec9[i] == 0 && i)
-				continue;
-			else
-				skip0 = false;
-			*str++ = dec9[i] + '0';
-			if (++digs == ptpos)
-				*str++ = '.';
-		}
+	/* Generate coefficient backwards, top word has no leading zeros */
+	const int words = _tt_dec_words(dec->_msb);
+	char *p = str + dec->_msb;
+	for (int i = 0; i < words - 1; i++)
+		p = put_word(p, dec->_dig[i]);
+	if (p > str) {
+		/* Top word: format in full, copy significant digits */
+		char top[_TT_DEC_DIGS];
+		const _tt_dec_word w = dec->_dig[words-1];
+		if (w < 100000000)
+			swar_store(top + _TT_DEC_DIGS - 8, swar_format8(w));
+		else
+			put_word(top + _TT_DEC_DIGS, w);
+		memcpy(str, top + _TT_DEC_DIGS - (p - str), p - str);
+		p = str;
+	}
+
+	/* Insert point */
+	str += dec->_msb;
+	if (ptpos) {
+		memmove(p + ptpos + 1, p + ptpos, dec->_msb - ptpos);
+		p[ptpos] = '.';
+		str++;
 	}
-	tt_assert(digs == dec->_msb);
 
 	/* Generate exponent */
 	if (note >= 2) {
 		/* Append "Eadjexp" */
-		*str++ = 'E';
-		sprintf(str, "%+d", adjexp);
+		put_exp(str, adjexp);
 	} else {
 		*str = '\0';
 	}
@@ -4,19 +4,17 @@
  */
 #include <tt/tt.h>
 #include <tt/apn/integer.h>
+#include <tt/common/param.h>
 #include <common/lib.h>
+#include <common/stats.h>
 #include "integer.h"
 
 #include <string.h>
 #include <math.h>
 
-#ifdef _TT_LP64_
-#define KARA_CROSS	16	/* Karatsuba multiplication cross point */
-#define BINDIV_CROSS	30	/* Divide and conquer division cross point */
-#else
-#define KARA_CROSS	24
-#define BINDIV_CROSS	35
-#endif
+/* Cross points, tunable at runtime */
+#define KARA_CROSS	(_tt_param.kara_cross)
+#define BINDIV_CROSS	(_tt_param.bindiv_cross)
 
 /* Add 31/63 bit integers with carry */
 static inline _tt_word add_int(_tt_word i1, _tt_word i2, int *carry)
@@ -70,8 +68,7 @@ static int add_ints_abs(struct tt_int *dst, const struct tt_int *src1,
 						(src1->msb-i)*_tt_word_sz);
 			return 0;
 		}
-		dst->buf[i] = src1->buf[i] + 1;
-		carry = !dst->buf[i];
+		dst->buf[i] = add_int(src1->buf[i], 0, &carry);
 	}
 	if (carry)
 		dst->buf[dst->msb++] = 1;
@@ -105,8 +102,7 @@ static int sub_ints_abs(struct tt_int *dst, const struct tt_int *src1,
 						(src1->msb-i)*_tt_word_sz);
 			break;
 		}
-		dst->buf[i] = src1->buf[i] - 1;
-		borrow = !src1->buf[i];
+		dst->buf[i] = sub_int(src1->buf[i], 0, &borrow);
 	}
 
 	/* Check new msb */
@@ -165,8 +161,7 @@ int _tt_int_add_buf(_tt_word *int1, int msb1, const _tt_word *int2, int msb2)
 	for (; i < msb1; i++) {
 		if (carry == 0)
 			return msb1;
-		int1[i]++;
-		carry = !int1[i];
+		int1[i] = add_int(int1[i], 0, &carry);
 	}
 	if (carry)
 		int1[i++] = 1;
@@ -187,8 +182,7 @@ int _tt_int_sub_buf(_tt_word *int1, int msb1, const _tt_word *int2, int msb2)
 	for (; i < msb1; i++) {
 		if (borrow == 0)
 			return msb1;
-		borrow = !int1[i];
-		int1[i]--;
+		int1[i] = sub_int(int1[i], 0, &borrow);
 	}
 	while (i > 1 && int1[i-1] == 0)
 		i--;
@@ -519,8 +513,11 @@ int _tt_int_mul_buf(_tt_word *intr, const _tt_word *int1, int msb1,
 	}
 
 	/* Use classic algorithm when input size below crosspoint */
-	if (msbmin < KARA_CROSS)
+	if (msbmin < KARA_CROSS) {
+		_tt_stat_count(TT_STAT_INT_MUL_CLASSIC);
 		return mul_buf_classic(intr, int1, msb1, int2, msb2);
+	}
+	_tt_stat_count(TT_STAT_INT_MUL_KARA);
 
 	/* Allocate working buffer for Karatsuba algorithm */
 	/* recursive calls = (int)(log2(msbmax) - log2(KARA_CROSS)) + 2; */
@@ -805,9 +802,12 @@ out:
 int _tt_int_div_buf(_tt_word *qt, int *msb_qt, _tt_word *rm, int *msb_rm,
 		const _tt_word *dd, int msb_dd, const _tt_word *ds, int msb_ds)
 {
-	if (msb_ds < BINDIV_CROSS)
+	if (msb_ds < BINDIV_CROSS) {
+		_tt_stat_count(TT_STAT_INT_DIV_CLASSIC);
 		return div_buf_classic(qt, msb_qt, rm, msb_rm,
 				dd, msb_dd, ds, msb_ds);
+	}
+	_tt_stat_count(TT_STAT_INT_DIV_BIN);
 
 	if (msb_dd <= msb_ds*2)
 		return div_buf_bin(qt, msb_qt, rm, msb_rm,
@@ -880,6 +880,7 @@ out:
 int tt_int_add(struct tt_int *dst, const struct tt_int *src1,
 		const struct tt_int *src2)
 {
+	_tt_stat_func(TT_STAT_INT_ADD);
 	return add_sub_ints(dst, src1, src2, 0);
 }
 
@@ -887,6 +888,7 @@ int tt_int_add(struct tt_int *dst, const struct tt_int *src1,
 int tt_int_sub(struct tt_int *dst, const struct tt_int *src1,
 		const struct tt_int *src2)
 {
+	_tt_stat_func(TT_STAT_INT_SUB);
 	return add_sub_ints(dst, src1, src2, 1);
 }
 
@@ -894,6 +896,7 @@ int tt_int_sub(struct tt_int *dst, const struct tt_int *src1,
 int tt_int_mul(struct tt_int *dst, const struct tt_int *src1,
 		const struct tt_int *src2)
 {
+	_tt_stat_func(TT_STAT_INT_MUL);
 	if (_tt_int_is_zero(src1) || _tt_int_is_zero(src2)) {
 		_tt_int_zero(dst);
 		return 0;
@@ -929,6 +932,7 @@ int tt_int_mul(struct tt_int *dst, const struct tt_int *src1,
 int tt_int_div(struct tt_int *quo, struct tt_int *rem,
 		const struct tt_int *src1, const struct tt_int *src2)
 {
+	_tt_stat_func(TT_STAT_INT_DIV);
 	int ret = 0;
 	tt_assert(quo != rem);
 
@@ -1029,6 +1033,438 @@ out:
 	return ret;
 }
 
+/* r[0, n) += a[0, n) * w, return carry word */
+static _tt_word addmul_1(_tt_word *r, const _tt_word *a, int n, _tt_word w)
+{
+	_tt_word c = 0;
+
+	for (int i = 0; i < n; i++) {
+		_tt_word_double t = (_tt_word_double)a[i] * w + r[i] + c;
+		r[i] = t & ~_tt_word_top_bit;
+		c = t >> _tt_word_bits;
+	}
+
+	return c;
+}
+
+/* r[0, n) -= a[0, n) * w, return borrow word */
+static _tt_word submul_1(_tt_word *r, const _tt_word *a, int n, _tt_word w)
+{
+	_tt_word b = 0;
+
+	for (int i = 0; i < n; i++) {
+		_tt_word_double t = (_tt_word_double)a[i] * w + b;
+		_tt_word d = r[i] - (t & ~_tt_word_top_bit);
+		r[i] = d & ~_tt_word_top_bit;
+		b = (t >> _tt_word_bits) + (d >> _tt_word_bits);
+	}
+
+	return b;
+}
+
+/* r[0, n) = a[0, n) * w, r may share a, return carry word */
+static _tt_word mul_1(_tt_word *r, const _tt_word *a, int n, _tt_word w)
+{
+	_tt_word c = 0;
+
+	for (int i = 0; i < n; i++) {
+		_tt_word_double t = (_tt_word_double)a[i] * w + c;
+		r[i] = t & ~_tt_word_top_bit;
+		c = t >> _tt_word_bits;
+	}
+
+	return c;
+}
+
+/* r[0, n) += w, carry out of r is dropped */
+static void add_word(_tt_word *r, int n, _tt_word w)
+{
+	for (int i = 0; i < n && w; i++) {
+		r[i] += w;
+		w = r[i] >> _tt_word_bits;
+		r[i] &= ~_tt_word_top_bit;
+	}
+}
+
+/* r[0, n) -= w, return borrow out of r */
+static int sub_word(_tt_word *r, int n, _tt_word w)
+{
+	for (int i = 0; i < n && w; i++) {
+		r[i] -= w;
+		w = r[i] >> _tt_word_bits;
+		r[i] &= ~_tt_word_top_bit;
+	}
+
+	return !!w;
+}
+
+/* r[0, n) = 2^(n*bits) - r[0, n) */
+static void neg_words(_tt_word *r, int n)
+{
+	int borrow = 0;
+
+	for (int i = 0; i < n; i++)
+		r[i] = sub_int(0, r[i], &borrow);
+}
+
+/* dst += src1 * src2 (sub = 0), dst -= src1 * src2 (sub = 1)
+ * - product rows are accumulated into dst buffer directly if the shorter
+ *   operand is below Karatsuba cross point and dst shares no source
+ * - otherwise product is computed in a working buffer and added to dst
+ * - subtraction is done in fixed width, a final borrow means the result
+ *   changes sign and is negated in place
+ */
+static int addmul_ints(struct tt_int *dst, const struct tt_int *src1,
+		const struct tt_int *src2, int sub)
+{
+	int ret = 0;
+
+	if (_tt_int_is_zero(src1) || _tt_int_is_zero(src2))
+		return 0;
+
+	/* Make src1 longer than src2 */
+	if (src1->msb < src2->msb)
+		__tt_swap(src1, src2);
+	const int msb1 = src1->msb, msb2 = src2->msb;
+
+	const int sign = src1->sign ^ src2->sign ^ sub;
+	if (_tt_int_is_zero(dst))
+		dst->sign = sign;
+	const int sub_abs = dst->sign != sign;
+
+	/* Product in working buffer */
+	_tt_word *p = NULL;
+	int msbp = 0;
+	if (msb2 >= KARA_CROSS || dst == src1 || dst == src2) {
+		p = calloc(msb1 + msb2, _tt_word_sz);
+		if (p == NULL)
+			return TT_ENOMEM;
+		msbp = _tt_int_mul_buf(p, src1->buf, msb1, src2->buf, msb2);
+		if (msbp < 0) {
+			ret = msbp;
+			goto out;
+		}
+	}
+
+	/* One extra word for carry */
+	const int n = _tt_max(dst->msb, msb1 + msb2) + 1;
+	ret = _tt_int_realloc(dst, n);
+	if (ret)
+		goto out;
+	_tt_word *r = dst->buf;
+
+	int borrow = 0;
+	if (p) {
+		if (sub_abs) {
+			int i;
+			for (i = 0; i < msbp; i++)
+				r[i] = sub_int(r[i], p[i], &borrow);
+			borrow = sub_word(r + i, n - i, borrow);
+		} else {
+			_tt_int_add_buf(r, dst->msb, p, msbp);
+		}
+	} else {
+		const _tt_word *a = src1->buf, *b = src2->buf;
+
+		for (int j = 0; j < msb2; j++) {
+			if (sub_abs) {
+				_tt_word c = submul_1(r + j, a, msb1, b[j]);
+				borrow |= sub_word(r + j + msb1, n - j - msb1, c);
+			} else {
+				_tt_word c = addmul_1(r + j, a, msb1, b[j]);
+				add_word(r + j + msb1, n - j - msb1, c);
+			}
+		}
+	}
+
+	if (borrow) {
+		neg_words(r, n);
+		dst->sign = !dst->sign;
+	}
+	dst->msb = _tt_int_get_msb(r, n);
+	if (_tt_int_is_zero(dst))
+		dst->sign = 0;
+
+out:
+	free(p);
+	return ret;
+}
+
+/* dst += src1 * src2. dst may share src1 or src2. */
+int tt_int_addmul(struct tt_int *dst, const struct tt_int *src1,
+		const struct tt_int *src2)
+{
+	_tt_stat_func(TT_STAT_INT_ADDMUL);
+	return addmul_ints(dst, src1, src2, 0);
+}
+
+/* dst -= src1 * src2. dst may share src1 or src2. */
+int tt_int_submul(struct tt_int *dst, const struct tt_int *src1,
+		const struct tt_int *src2)
+{
+	_tt_stat_func(TT_STAT_INT_ADDMUL);
+	return addmul_ints(dst, src1, src2, 1);
+}
+
+/* dst = src * num. dst may share src. */
+int tt_int_mul_ui(struct tt_int *dst, const struct tt_int *src, uint64_t num)
+{
+	_tt_stat_func(TT_STAT_INT_MUL_UI);
+	if (num >> _tt_word_bits) {
+		_tt_word w[3];
+		struct tt_int t = _TT_INT_DECL(3, w);
+		tt_int_from_uint(&t, num);
+		return tt_int_mul(dst, src, &t);
+	}
+
+	const int msb = src->msb, sign = src->sign;
+	int ret = _tt_int_realloc(dst, msb + 1);
+	if (ret)
+		return ret;
+
+	dst->buf[msb] = mul_1(dst->buf, src->buf, msb, num);
+	if (dst->msb > msb + 1)
+		memset(dst->buf + msb + 1, 0,
+				(dst->msb - msb - 1) * _tt_word_sz);
+	dst->msb = _tt_int_get_msb(dst->buf, msb + 1);
+	dst->sign = sign && !_tt_int_is_zero(dst);
+
+	return 0;
+}
+
+/* dst += src * num. dst may share src. */
+int tt_int_addmul_ui(struct tt_int *dst, const struct tt_int *src,
+		uint64_t num)
+{
+	_tt_stat_func(TT_STAT_INT_ADDMUL);
+	_tt_word w[3];
+	struct tt_int t = _TT_INT_DECL(3, w);
+
+	tt_int_from_uint(&t, num);
+	return addmul_ints(dst, src, &t, 0);
+}
+
+/* quo = src / num, *rem = |src| % num
+ * - quotient is truncated toward zero
+ * - quo may share src, quo or rem may be null
+ */
+int tt_int_div_ui(struct tt_int *quo, uint64_t *rem,
+		const struct tt_int *src, uint64_t num)
+{
+	_tt_stat_func(TT_STAT_INT_DIV_UI);
+	int ret = 0;
+
+	if (num == 0)
+		return TT_APN_EDIV_0;
+
+	if (num >> _tt_word_bits) {
+		/* Multi-word divisor */
+		_tt_word w[3];
+		struct tt_int t = _TT_INT_DECL(3, w);
+		tt_int_from_uint(&t, num);
+
+		struct tt_int *r = tt_int_alloc();
+		if (r == NULL)
+			return TT_ENOMEM;
+		ret = tt_int_div(quo, r, src, &t);
+		if (ret == 0 && rem) {
+			*rem = 0;
+			for (int i = r->msb - 1; i >= 0; i--)
+				*rem = (*rem << _tt_word_bits) | r->buf[i];
+		}
+		tt_int_free(r);
+		return ret;
+	}
+
+	const int msb = src->msb, sign = src->sign;
+	if (quo) {
+		ret = _tt_int_realloc(quo, msb);
+		if (ret)
+			return ret;
+	}
+
+	_tt_word_double r = 0;
+	for (int i = msb - 1; i >= 0; i--) {
+		r = (r << _tt_word_bits) | src->buf[i];
+		if (quo)
+			quo->buf[i] = r / num;
+		r %= num;
+	}
+	if (rem)
+		*rem = r;
+
+	if (quo) {
+		if (quo->msb > msb)
+			memset(quo->buf + msb, 0,
+					(quo->msb - msb) * _tt_word_sz);
+		quo->msb = _tt_int_get_msb(quo->buf, msb);
+		quo->sign = sign && !_tt_int_is_zero(quo);
+	}
+
+	return 0;
+}
+
+/* 1/w mod 2^bits, w is odd
+ * - Newton iteration x = x * (2 - w * x), each step doubles correct bits
+ * - w * w = 1 mod 8, so initial guess w has 3 correct bits
+ */
+static _tt_word inverse_word(_tt_word w)
+{
+	_tt_word x = w;
+
+	for (int i = 0; i < 5; i++)
+		x *= 2 - w * x;
+
+	return x & ~_tt_word_top_bit;
+}
+
+/* Hensel (2-adic) division by odd divisor, least significant word first
+ * - r[0, n): dividend, destroyed
+ * - q[0, qn): r / d mod 2^(qn*bits), q may be null
+ * - full = 0: only low qn words of r are updated (Jebelean), qn <= n
+ * - full = 1: r is updated in full width, qn = n - msbd + 1,
+ *             return true if remainder is 0 (d divides r)
+ */
+static bool div_hensel(_tt_word *q, int qn, _tt_word *r, int n,
+		const _tt_word *d, int msbd, int full)
+{
+	const _tt_word inv = inverse_word(d[0]);
+	int borrow = 0;
+
+	for (int i = 0; i < qn; i++) {
+		const _tt_word qi = (r[i] * inv) & ~_tt_word_top_bit;
+
+		if (full) {
+			_tt_word b = submul_1(r + i, d, msbd, qi);
+			borrow |= sub_word(r + i + msbd, n - i - msbd, b);
+		} else {
+			const int m = _tt_min(msbd, qn - i);
+			_tt_word b = submul_1(r + i, d, m, qi);
+			sub_word(r + i + m, qn - i - m, b);
+		}
+
+		/* r[i] is 0 now, q may share r */
+		if (q)
+			q[i] = qi;
+	}
+
+	if (!full)
+		return true;
+	return !borrow && get_words(r, n) == 0;
+}
+
+/* Odd part of |ti| starting at word "wz", shifted by "bits" */
+static int odd_words(_tt_word *buf, const struct tt_int *ti, int wz, int bits)
+{
+	const int msb = ti->msb - wz;
+
+	memcpy(buf, ti->buf + wz, msb * _tt_word_sz);
+	return _tt_int_shift_buf(buf, msb, -bits);
+}
+
+/* quo = src1 / src2, src2 must divide src1
+ * - result is undefined if src1 is not a multiple of src2
+ * - 2-adic division, no normalization or quotient correction
+ * - quo may share src1 or src2
+ */
+int tt_int_divexact(struct tt_int *quo, const struct tt_int *src1,
+		const struct tt_int *src2)
+{
+	_tt_stat_func(TT_STAT_INT_DIVEXACT);
+	if (_tt_int_is_zero(src2))
+		return TT_APN_EDIV_0;
+	if (src1->msb < src2->msb || _tt_int_is_zero(src1)) {
+		_tt_int_zero(quo);
+		return 0;
+	}
+
+	/* Hensel division is quadratic */
+	if (src2->msb >= BINDIV_CROSS &&
+			src1->msb - src2->msb >= BINDIV_CROSS)
+		return tt_int_div(quo, NULL, src1, src2);
+
+	const int sign = src1->sign ^ src2->sign;
+
+	/* Drop trailing zeros of divisor from both */
+	const int zeros = tt_int_ctz(src2);
+	const int wz = zeros / _tt_word_bits, bz = zeros % _tt_word_bits;
+
+	_tt_word *workbuf = malloc((src1->msb * 2) * _tt_word_sz);
+	if (workbuf == NULL)
+		return TT_ENOMEM;
+	_tt_word *dd = workbuf, *ds = dd + src1->msb;
+	const int msb_dd = odd_words(dd, src1, wz, bz);
+	const int msb_ds = odd_words(ds, src2, wz, bz);
+
+	int ret = 0;
+	const int qn = msb_dd - msb_ds + 1;
+	if (qn <= 0) {
+		_tt_int_zero(quo);
+		goto out;
+	}
+
+	/* Quotient overwrites consumed dividend words */
+	div_hensel(dd, qn, dd, msb_dd, ds, msb_ds, 0);
+
+	_tt_int_zero(quo);
+	ret = _tt_int_realloc(quo, qn);
+	if (ret)
+		goto out;
+	memcpy(quo->buf, dd, qn * _tt_word_sz);
+	quo->msb = _tt_int_get_msb(quo->buf, qn);
+	quo->sign = sign && !_tt_int_is_zero(quo);
+
+out:
+	free(workbuf);
+	return ret;
+}
+
+/* Test if src2 divides src1
+ * - modular inverse trick, same as divisable() for small primes
+ * - 0 divides only 0
+ */
+bool tt_int_isdivisible(const struct tt_int *src1, const struct tt_int *src2)
+{
+	if (_tt_int_is_zero(src2))
+		return _tt_int_is_zero(src1);
+	if (_tt_int_is_zero(src1))
+		return true;
+	if (src1->msb < src2->msb)
+		return false;
+
+	const int zeros = tt_int_ctz(src2);
+	if (tt_int_ctz(src1) < zeros)
+		return false;
+
+	if (src2->msb >= BINDIV_CROSS &&
+			src1->msb - src2->msb >= BINDIV_CROSS) {
+		struct tt_int *rem = tt_int_alloc();
+		if (rem == NULL)
+			return false;
+		bool ret = tt_int_div(NULL, rem, src1, src2) == 0 &&
+			_tt_int_is_zero(rem);
+		tt_int_free(rem);
+		return ret;
+	}
+
+	const int wz = zeros / _tt_word_bits, bz = zeros % _tt_word_bits;
+
+	_tt_word *workbuf = malloc((src1->msb * 2) * _tt_word_sz);
+	if (workbuf == NULL)
+		return false;
+	_tt_word *dd = workbuf, *ds = dd + src1->msb;
+	const int msb_dd = odd_words(dd, src1, wz, bz);
+	const int msb_ds = odd_words(ds, src2, wz, bz);
+
+	bool ret = false;
+	if (msb_dd >= msb_ds)
+		ret = div_hensel(NULL, msb_dd - msb_ds + 1, dd, msb_dd,
+				ds, msb_ds, 1);
+
+	free(workbuf);
+	return ret;
+}
+
 /* Compare absolute value
  * - return: 1 - src1 > src2, 0 - src1 == src2, -1 - src1 < src2
  */
@@ -1,3 +1,3 @@
-obj-y += integer.o str.o mach.o basic.o
-obj-y += factorial.o
+obj-y += integer.o str.o mach.o basic.o logic.o
+obj-y += factorial.o power.o
 obj-y += gcd.o mod.o prime.o
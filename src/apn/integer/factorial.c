@@ -1,44 +1,90 @@
-/* Factorial
+/* Factorial, binomial coefficient, primorial
  *
  * Copyright (C) 2015 Yibo Cai
  */
 #include <tt/tt.h>
 #include <tt/apn/integer.h>
 #include <common/lib.h>
+#include <common/stats.h>
 #include "integer.h"
 
 #include <string.h>
 #include <math.h>
+#include <pthread.h>
 
-int tt_int_factorial(struct tt_int *ti, const int n)
+/* Compute halves of a product tree in two threads above this many words */
+#define PROD_PAR_CROSS	2000
+
+/* Sieve of Eratosthenes on odd numbers
+ * - bit i set: 2i+1 is composite
+ * - *cnt: count of primes <= n, including 2
+ */
+static uchar *sieve(uint n, uint *cnt)
 {
-	/* Make sure 0 < n < 2^31 */
-	if (n <= 0) {
-		tt_error("Invalid parameter");
-		return TT_EINVAL;
+	const uint odds = n / 2 + (n & 1);
+	uchar *sv = calloc((odds + 7) / 8, 1);
+	if (sv == NULL)
+		return NULL;
+
+	sv[0] = 1;	/* 1 is not prime */
+	*cnt = n >= 2;
+	for (uint i = 1; i < odds; i++) {
+		if (sv[i/8] & BIT(i%8))
+			continue;
+		(*cnt)++;
+
+		const uint64_t p = i * 2 + 1;
+		for (uint64_t j = p * p / 2; j < odds; j += p)
+			sv[j/8] |= BIT(j%8);
 	}
 
-	/* Allocate buffers */
-	_tt_word *buf = malloc(n * 2 * _tt_word_sz);
-	if (buf == NULL)
-		return TT_ENOMEM;
-	_tt_word *oper = buf;
-	_tt_word *result = oper + n;
+	return sv;
+}
 
-	int *msb = malloc(n * sizeof(int));
-	if (msb == NULL) {
-		free(buf);
-		return TT_ENOMEM;
+/* Next odd prime after p (odd), 0 if exceeds n */
+static uint next_prime(const uchar *sv, uint p, uint n)
+{
+	for (p += 2; p <= n && p > 2; p += 2) {
+		const uint i = p / 2;
+		if (!(sv[i/8] & BIT(i%8)))
+			return p;
 	}
+	return 0;
+}
+
+/* ti = w[0] * w[1] * ... * w[n-1]
+ * - w: buffer of 2n words, factors in w[0] ~ w[n-1], destroyed
+ * - factors are packed to full words, then multiplied in a balanced tree
+ */
+static int prod_words(struct tt_int *ti, _tt_word *w, int n)
+{
+	int ret = 0;
 
-	/* Initialize operators */
+	/* Pack small factors */
+	int ops = 0;
+	_tt_word acc = 1;
 	for (int i = 0; i < n; i++) {
-		result[i] = i+1;
-		msb[i] = 1;
+		_tt_word_double m = (_tt_word_double)acc * w[i];
+		if (m >> _tt_word_bits) {
+			w[ops++] = acc;
+			acc = w[i];
+		} else {
+			acc = m;
+		}
 	}
+	w[ops++] = acc;
+
+	int *msb = malloc(ops * sizeof(int));
+	if (msb == NULL)
+		return TT_ENOMEM;
+
+	_tt_word *oper = w + n;
+	_tt_word *result = w;
+	for (int i = 0; i < ops; i++)
+		msb[i] = 1;
 
 	/* Divide and conqure */
-	int ops = n, ret = 0;
+	n = ops;
 	while (ops > 1) {
 		__tt_swap(oper, result);
 		memset(result, 0, n * _tt_word_sz);
@@ -64,24 +110,242 @@ int tt_int_factorial(struct tt_int *ti, const int n)
 		}
 		ops = i;
 
-		tt_assert_fa((o-oper) <= n*_tt_word_sz);
-		tt_assert_fa((r-result) <= n*_tt_word_sz);
+		tt_assert_fa((o-oper) <= n);
+		tt_assert_fa((r-result) <= n);
 	}
 	tt_assert(ops == 1);
 
 	/* Result in: result[], msb[0] */
-	if (ti->_max < msb[0]) {
-		ret = _tt_int_realloc(ti, msb[0]);
-		if (ret)
-			goto out;
-	} else {
-		_tt_int_zero(ti);
-	}
+	_tt_int_zero(ti);
+	ret = _tt_int_realloc(ti, msb[0]);
+	if (ret)
+		goto out;
 	memcpy(ti->buf, result, msb[0] * _tt_word_sz);
 	ti->msb = msb[0];
 
 out:
-	free(buf);
 	free(msb);
 	return ret;
 }
+
+struct prod_arg {
+	struct tt_int *ti;
+	_tt_word *w;
+	int n;
+	int ret;
+};
+
+static void *prod_thread(void *arg)
+{
+	struct prod_arg *pa = arg;
+
+	pa->ret = prod_words(pa->ti, pa->w, pa->n);
+	return NULL;
+}
+
+/* Same as prod_words(), two halves are computed in parallel */
+static int prod_words_par(struct tt_int *ti, _tt_word *w, int n)
+{
+	if (n < PROD_PAR_CROSS)
+		return prod_words(ti, w, n);
+
+	/* w[0, 2h): low half, w[2h, 2n): high half */
+	const int h = n / 2;
+	memmove(w + h*2, w + h, (n - h) * _tt_word_sz);
+
+	struct prod_arg pa = {
+		.ti = tt_int_alloc(),
+		.w = w,
+		.n = h,
+	};
+	if (pa.ti == NULL)
+		return TT_ENOMEM;
+
+	pthread_t thread;
+	bool threaded = !pthread_create(&thread, NULL, prod_thread, &pa);
+	if (!threaded)
+		prod_thread(&pa);
+
+	int ret = prod_words(ti, w + h*2, n - h);
+
+	if (threaded)
+		pthread_join(thread, NULL);
+	if (ret == 0)
+		ret = pa.ret;
+	if (ret == 0)
+		ret = tt_int_mul(ti, ti, pa.ti);
+
+	tt_int_free(pa.ti);
+	return ret;
+}
+
+/* Odd prime power factors of swing(n) = n! / (n/2)!^2
+ * - each factor <= n
+ * - return factor count
+ */
+static int swing_factors(_tt_word *w, const uchar *sv, uint n)
+{
+	int cnt = 0;
+
+	for (uint p = next_prime(sv, 1, n); p; p = next_prime(sv, p, n)) {
+		_tt_word f = 1;
+		uint q = n;
+		while ((q /= p))
+			if (q & 1)
+				f *= p;
+		if (f > 1)
+			w[cnt++] = f;
+	}
+
+	return cnt;
+}
+
+/* Factorial by prime swing
+ * - n! = oddfact(n) * 2^(n - popcount(n))
+ * - oddfact(n) = oddfact(n/2)^2 * oddswing(n)
+ * - swing product and square of previous result run in parallel
+ */
+int tt_int_factorial(struct tt_int *ti, const int n)
+{
+	_tt_stat_func(TT_STAT_INT_FACTORIAL);
+	/* Make sure 0 < n < 2^31 */
+	if (n <= 0) {
+		tt_error("Invalid parameter");
+		return TT_EINVAL;
+	}
+
+	uint pcnt;
+	uchar *sv = sieve(n, &pcnt);
+	if (sv == NULL)
+		return TT_ENOMEM;
+
+	int ret = TT_ENOMEM;
+	_tt_word *w = malloc((pcnt + 1) * 2 * _tt_word_sz);
+	struct prod_arg pa = { .ti = tt_int_alloc(), .w = w, };
+	if (w == NULL || pa.ti == NULL)
+		goto out;
+
+	tt_int_from_uint(ti, 1);
+	for (int b = 31 - __builtin_clz(n); b >= 0; b--) {
+		const uint m = (uint)n >> b;
+		if (m < 3)
+			continue;	/* oddfact(1) = oddfact(2) = 1 */
+
+		pa.n = swing_factors(w, sv, m);
+
+		pthread_t thread;
+		bool threaded = false;
+		if (pa.n >= PROD_PAR_CROSS && ti->msb >= PROD_PAR_CROSS)
+			threaded = !pthread_create(&thread, NULL,
+					prod_thread, &pa);
+		if (!threaded)
+			prod_thread(&pa);
+
+		ret = tt_int_mul(ti, ti, ti);
+
+		if (threaded)
+			pthread_join(thread, NULL);
+		if (ret == 0)
+			ret = pa.ret;
+		if (ret == 0)
+			ret = tt_int_mul(ti, ti, pa.ti);
+		if (ret)
+			goto out;
+	}
+
+	ret = tt_int_shift(ti, n - __builtin_popcount(n));
+
+out:
+	free(sv);
+	free(w);
+	if (pa.ti)
+		tt_int_free(pa.ti);
+	return ret;
+}
+
+/* Binomial coefficient C(n, k) = n! / (k! * (n-k)!)
+ * - exponent of prime p is the borrow count of n-k in radix p (Kummer)
+ */
+int tt_int_binomial(struct tt_int *ti, uint n, uint k)
+{
+	_tt_stat_func(TT_STAT_INT_BINOMIAL);
+	if (k > n) {
+		_tt_int_zero(ti);
+		return 0;
+	}
+	if (k > n - k)
+		k = n - k;
+	if (k == 0)
+		return tt_int_from_uint(ti, 1);
+
+	uint pcnt;
+	uchar *sv = sieve(n, &pcnt);
+	if (sv == NULL)
+		return TT_ENOMEM;
+	_tt_word *w = malloc((pcnt + 1) * 2 * _tt_word_sz);
+	if (w == NULL) {
+		free(sv);
+		return TT_ENOMEM;
+	}
+
+	/* Borrows of 2 = carries of k + (n-k) in binary */
+	const int shift = __builtin_popcount(k) + __builtin_popcount(n - k) -
+		__builtin_popcount(n);
+
+	int cnt = 0;
+	for (uint p = next_prime(sv, 1, n); p; p = next_prime(sv, p, n)) {
+		_tt_word f = 1;
+		uint a = n, b = k, c = n - k;
+		while (a) {
+			a /= p;
+			b /= p;
+			c /= p;
+			for (uint e = a - b - c; e; e--)
+				f *= p;
+		}
+		if (f > 1)
+			w[cnt++] = f;
+	}
+
+	int ret = 0;
+	if (cnt)
+		ret = prod_words_par(ti, w, cnt);
+	else
+		tt_int_from_uint(ti, 1);
+	if (ret == 0)
+		ret = tt_int_shift(ti, shift);
+
+	free(sv);
+	free(w);
+	return ret;
+}
+
+/* Primorial: product of all primes <= n */
+int tt_int_primorial(struct tt_int *ti, uint n)
+{
+	_tt_stat_func(TT_STAT_INT_PRIMORIAL);
+	if (n < 2)
+		return tt_int_from_uint(ti, 1);
+
+	uint pcnt;
+	uchar *sv = sieve(n, &pcnt);
+	if (sv == NULL)
+		return TT_ENOMEM;
+	_tt_word *w = malloc(pcnt * 2 * _tt_word_sz);
+	if (w == NULL) {
+		free(sv);
+		return TT_ENOMEM;
+	}
+
+	int cnt = 0;
+	w[cnt++] = 2;
+	for (uint p = next_prime(sv, 1, n); p; p = next_prime(sv, p, n))
+		w[cnt++] = p;
+	tt_assert(cnt == pcnt);
+
+	int ret = prod_words_par(ti, w, cnt);
+
+	free(sv);
+	free(w);
+	return ret;
+}
@@ -5,6 +5,7 @@
 #include <tt/tt.h>
 #include <tt/apn/integer.h>
 #include <common/lib.h>
+#include <common/stats.h>
 #include "integer.h"
 
 #include "string.h"
@@ -200,6 +201,7 @@ static int extgcd_binary(struct tt_int *g, struct tt_int *u, struct tt_int *v,
 /* g = gcd(a, b) */
 int tt_int_gcd(struct tt_int *g, const struct tt_int *a, const struct tt_int *b)
 {
+	_tt_stat_func(TT_STAT_INT_GCD);
 	if (_tt_int_is_zero(a))
 		return copy_abs(g, b);
 	else if (_tt_int_is_zero(b))
@@ -226,6 +228,7 @@ int tt_int_gcd(struct tt_int *g, const struct tt_int *a, const struct tt_int *b)
 int tt_int_extgcd(struct tt_int *g, struct tt_int *u, struct tt_int *v,
 		const struct tt_int *a, const struct tt_int *b)
 {
+	_tt_stat_func(TT_STAT_INT_EXTGCD);
 	/* u = 1, v = 0 */
 	tt_int_from_uint(u, 1);
 	_tt_int_zero(v);
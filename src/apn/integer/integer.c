@@ -5,6 +5,7 @@
 #include <tt/tt.h>
 #include <tt/apn/integer.h>
 #include <common/lib.h>
+#include <common/stats.h>
 #include "integer.h"
 
 #include <string.h>
@@ -21,6 +22,7 @@ struct tt_int *tt_int_alloc(void)
 		free(ti);
 		return NULL;
 	}
+	_tt_stat_bytes(TT_STAT_INT_ALLOC, ti->_max * _tt_word_sz);
 	return ti;
 }
 
@@ -44,6 +46,7 @@ int _tt_int_realloc(struct tt_int *ti, int msb)
 		return TT_ENOMEM;
 	}
 	memset(buf + ti->_max, 0, (msb - ti->_max) * _tt_word_sz);
+	_tt_stat_bytes(TT_STAT_INT_ALLOC, (msb - ti->_max) * _tt_word_sz);
 	ti->buf = buf;
 	ti->_max = msb;
 	return 0;
@@ -73,28 +76,27 @@ void _tt_int_zero(struct tt_int *ti)
 /* Count significant bits of a word(top bit ignored) */
 int _tt_int_word_bits(_tt_word w)
 {
-	w <<= 1;
-	for (int i = _tt_word_bits; i > 0; i--) {
-		if (w & _tt_word_top_bit)
-			return i;
-		w <<= 1;
-	}
+	if (w == 0)
+		return 0;
 
-	tt_assert(1);
-	return 0;
+#ifdef _TT_LP64_
+	return 64 - __builtin_clzll(w);
+#else
+	return 32 - __builtin_clz(w);
+#endif
 }
 
 /* Count trailing zeros of a word(top bit ignored) */
 int _tt_int_word_ctz(_tt_word w)
 {
-	for (int i = 0; i < _tt_word_bits; i++) {
-		if (w & 0x1)
-			return i;
-		w >>= 1;
-	}
-
-	tt_assert(1);
-	return _tt_word_bits;
+	if (w == 0)
+		return _tt_word_bits;
+
+#ifdef _TT_LP64_
+	return __builtin_ctzll(w);
+#else
+	return __builtin_ctz(w);
+#endif
 }
 
 /* Check sanity */
@@ -199,6 +201,7 @@ int _tt_int_shift_buf(_tt_word *buf, int msb, int shift)
 /* Shift integer: shift: + left, - right */
 int tt_int_shift(struct tt_int *ti, int shift)
 {
+	_tt_stat_func(TT_STAT_INT_SHIFT);
 	if (shift > 0) {
 		int ret = _tt_int_realloc(ti, ti->msb +
 				(shift+_tt_word_bits-1)/_tt_word_bits);
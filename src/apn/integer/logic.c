@@ -0,0 +1,297 @@
+/* Bitwise logic, bit manipulation
+ *
+ * Integers are sign-magnitude internally. Bitwise operations follow two's
+ * complement semantics with infinite sign extension, negative operands are
+ * converted word by word on the fly: -x = ~x + 1.
+ *
+ * Copyright (C) 2016 Yibo Cai
+ */
+#include <tt/tt.h>
+#include <tt/apn/integer.h>
+#include <common/lib.h>
+#include <common/stats.h>
+#include "integer.h"
+
+#include <string.h>
+
+enum {
+	LOGIC_AND,
+	LOGIC_OR,
+	LOGIC_XOR,
+};
+
+static inline bool is_neg(const struct tt_int *ti)
+{
+	return ti->sign && !_tt_int_is_zero(ti);
+}
+
+/* Two's complement of a word with carry, carry is 0 or 1 */
+static inline _tt_word neg_word(_tt_word w, _tt_word *carry)
+{
+	w = (~w & ~_tt_word_top_bit) + *carry;
+	*carry = w >> _tt_word_bits;
+	return w & ~_tt_word_top_bit;
+}
+
+static inline _tt_word logic_word(_tt_word w1, _tt_word w2, int op)
+{
+	switch (op) {
+	case LOGIC_AND:
+		return w1 & w2;
+	case LOGIC_OR:
+		return w1 | w2;
+	default:
+		return w1 ^ w2;
+	}
+}
+
+/* dst = src1 op src2
+ * - dst may share src1 or src2
+ * - no working buffer, dst is reallocated only if it's too small
+ */
+static int logic_ints(struct tt_int *dst, const struct tt_int *src1,
+		const struct tt_int *src2, int op)
+{
+	const int neg1 = is_neg(src1), neg2 = is_neg(src2);
+	const int negr = logic_word(neg1, neg2, op);
+	const int msb1 = src1->msb, msb2 = src2->msb, msb_old = dst->msb;
+
+	/* Result words, one extra word for negative result carry */
+	int msb = _tt_max(msb1, msb2) + 1;
+	if (op == LOGIC_AND) {
+		if (!neg1)
+			msb = _tt_min(msb, msb1);
+		if (!neg2)
+			msb = _tt_min(msb, msb2);
+	}
+
+	/* dst->buf may move, fetch source buffers afterwards */
+	int ret = _tt_int_realloc(dst, msb);
+	if (ret)
+		return ret;
+	const _tt_word *buf1 = src1->buf, *buf2 = src2->buf;
+
+	_tt_word c1 = neg1, c2 = neg2, cr = negr;
+	for (int i = 0; i < msb; i++) {
+		_tt_word w1 = i < msb1 ? buf1[i] : 0;
+		_tt_word w2 = i < msb2 ? buf2[i] : 0;
+
+		if (neg1)
+			w1 = neg_word(w1, &c1);
+		if (neg2)
+			w2 = neg_word(w2, &c2);
+
+		_tt_word r = logic_word(w1, w2, op);
+		if (negr)
+			r = neg_word(r, &cr);
+		dst->buf[i] = r;
+	}
+	tt_assert_fa(cr == 0 || !negr);
+
+	if (msb_old > msb)
+		memset(dst->buf + msb, 0, (msb_old - msb) * _tt_word_sz);
+	dst->msb = _tt_int_get_msb(dst->buf, msb);
+	dst->sign = negr && !_tt_int_is_zero(dst);
+
+	return 0;
+}
+
+/* dst = src1 & src2. dst may share src1 or src2. */
+int tt_int_and(struct tt_int *dst, const struct tt_int *src1,
+		const struct tt_int *src2)
+{
+	_tt_stat_func(TT_STAT_INT_LOGIC);
+	return logic_ints(dst, src1, src2, LOGIC_AND);
+}
+
+/* dst = src1 | src2. dst may share src1 or src2. */
+int tt_int_or(struct tt_int *dst, const struct tt_int *src1,
+		const struct tt_int *src2)
+{
+	_tt_stat_func(TT_STAT_INT_LOGIC);
+	return logic_ints(dst, src1, src2, LOGIC_OR);
+}
+
+/* dst = src1 ^ src2. dst may share src1 or src2. */
+int tt_int_xor(struct tt_int *dst, const struct tt_int *src1,
+		const struct tt_int *src2)
+{
+	_tt_stat_func(TT_STAT_INT_LOGIC);
+	return logic_ints(dst, src1, src2, LOGIC_XOR);
+}
+
+/* |ti| +/- 2^bit
+ * - sub: |ti| >= 2^bit
+ */
+static int add_sub_bit(struct tt_int *ti, int bit, int sub)
+{
+	const int w = bit / _tt_word_bits;
+	const _tt_word one = (_tt_word)1 << (bit % _tt_word_bits);
+
+	if (sub) {
+		tt_assert_fa(w < ti->msb);
+		ti->msb = _tt_int_sub_buf(ti->buf + w, ti->msb - w, &one, 1) + w;
+		ti->msb = _tt_int_get_msb(ti->buf, ti->msb);
+		return 0;
+	}
+
+	int ret = _tt_int_realloc(ti, _tt_max(ti->msb, w + 1) + 1);
+	if (ret)
+		return ret;
+	if (w >= ti->msb) {
+		ti->buf[w] = one;
+		ti->msb = w + 1;
+	} else {
+		ti->msb = _tt_int_add_buf(ti->buf + w, ti->msb - w, &one, 1) + w;
+	}
+	return 0;
+}
+
+/* dst = ~src = -src - 1. dst may share src. */
+int tt_int_not(struct tt_int *dst, const struct tt_int *src)
+{
+	if (dst != src) {
+		int ret = _tt_int_copy(dst, src);
+		if (ret)
+			return ret;
+	}
+
+	if (is_neg(dst)) {
+		/* ~(-x) = x - 1 */
+		add_sub_bit(dst, 0, 1);
+		dst->sign = 0;
+		return 0;
+	}
+
+	/* ~x = -(x + 1) */
+	dst->sign = 1;
+	return add_sub_bit(dst, 0, 0);
+}
+
+/* Test bit (two's complement), return 0 or 1 */
+int tt_int_test_bit(const struct tt_int *ti, int bit)
+{
+	tt_assert(bit >= 0);
+
+	const int w = bit / _tt_word_bits;
+	if (w >= ti->msb)
+		return is_neg(ti);
+
+	_tt_word v = ti->buf[w];
+	if (is_neg(ti)) {
+		/* Carry into word w survives only if all lower words are 0 */
+		_tt_word c = 1;
+		for (int i = 0; i < w && c; i++)
+			c = ti->buf[i] == 0;
+		v = neg_word(v, &c);
+	}
+
+	return (v >> (bit % _tt_word_bits)) & 1;
+}
+
+/* Set bit (two's complement)
+ * - setting a zero bit adds 2^bit, it never changes sign
+ */
+int tt_int_set_bit(struct tt_int *ti, int bit)
+{
+	if (tt_int_test_bit(ti, bit))
+		return 0;
+	return add_sub_bit(ti, bit, is_neg(ti));
+}
+
+/* Clear bit (two's complement)
+ * - clearing a set bit subtracts 2^bit, it never changes sign
+ */
+int tt_int_clr_bit(struct tt_int *ti, int bit)
+{
+	if (!tt_int_test_bit(ti, bit))
+		return 0;
+	return add_sub_bit(ti, bit, !is_neg(ti));
+}
+
+/* Flip bit (two's complement) */
+int tt_int_flip_bit(struct tt_int *ti, int bit)
+{
+	if (tt_int_test_bit(ti, bit))
+		return tt_int_clr_bit(ti, bit);
+	return tt_int_set_bit(ti, bit);
+}
+
+/* Count set bits
+ * - return TT_EINVAL on negative integer (infinite set bits)
+ */
+int tt_int_popcount(const struct tt_int *ti)
+{
+	if (is_neg(ti))
+		return TT_EINVAL;
+
+	int cnt = 0;
+	for (int i = 0; i < ti->msb; i++)
+#ifdef _TT_LP64_
+		cnt += __builtin_popcountll(ti->buf[i]);
+#else
+		cnt += __builtin_popcount(ti->buf[i]);
+#endif
+
+	return cnt;
+}
+
+/* Find first bit equal to "set" from bit "start" (two's complement)
+ * - return bit index, or -1 if not found
+ */
+static int scan_bit(const struct tt_int *ti, int start, int set)
+{
+	tt_assert(start >= 0);
+
+	const int neg = is_neg(ti);
+	int w = start / _tt_word_bits;
+	if (w >= ti->msb)
+		return neg == set ? start : -1;
+
+	/* Carry into word w */
+	_tt_word c = neg;
+	for (int i = 0; i < w && c; i++)
+		c = ti->buf[i] == 0;
+
+	/* Mask out bits below start */
+	_tt_word mask = ~_tt_word_top_bit << (start % _tt_word_bits);
+	for (; w < ti->msb; w++) {
+		_tt_word v = ti->buf[w];
+		if (neg)
+			v = neg_word(v, &c);
+		if (!set)
+			v = ~v & ~_tt_word_top_bit;
+		v &= mask;
+		if (v)
+			return w * _tt_word_bits + _tt_int_word_ctz(v);
+		mask = ~_tt_word_top_bit;
+	}
+
+	/* Sign extension */
+	return neg == set ? w * _tt_word_bits : -1;
+}
+
+/* Index of first set bit from "start", -1 if none */
+int tt_int_scan1(const struct tt_int *ti, int start)
+{
+	return scan_bit(ti, start, 1);
+}
+
+/* Index of first clear bit from "start", -1 if none */
+int tt_int_scan0(const struct tt_int *ti, int start)
+{
+	return scan_bit(ti, start, 0);
+}
+
+/* Count trailing zeros, same for ti and -ti. Return -1 if ti is 0. */
+int tt_int_ctz(const struct tt_int *ti)
+{
+	if (_tt_int_is_zero(ti))
+		return -1;
+
+	int w = 0;
+	while (ti->buf[w] == 0)
+		w++;
+
+	return w * _tt_word_bits + _tt_int_word_ctz(ti->buf[w]);
+}
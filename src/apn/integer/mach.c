@@ -5,8 +5,12 @@
 #include <tt/tt.h>
 #include <tt/apn/integer.h>
 #include <common/lib.h>
+#include <common/stats.h>
 #include "integer.h"
 
+#include <string.h>
+#include <limits.h>
+
 int tt_int_from_uint(struct tt_int *ti, uint64_t num)
 {
 	_tt_int_zero(ti);
@@ -34,3 +38,169 @@ int tt_int_from_sint(struct tt_int *ti, int64_t num)
 
 	return 0;
 }
+
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define HOST_ENDIAN	-1
+#else
+#define HOST_ENDIAN	1
+#endif
+
+static int check_words(int order, size_t size, int endian, size_t nails)
+{
+	if ((order != 1 && order != -1) || endian < -1 || endian > 1 ||
+			size == 0 || nails >= size * 8) {
+		tt_error("Invalid parameter");
+		return TT_EINVAL;
+	}
+	return 0;
+}
+
+/* Raw words layout matches _tt_word limbs */
+static bool is_limb_layout(int order, size_t size, int endian, size_t nails)
+{
+	if (endian == 0)
+		endian = HOST_ENDIAN;
+	return order == -1 && size == _tt_word_sz && endian == HOST_ENDIAN &&
+		nails == 1;
+}
+
+/* Import raw binary words
+ * - data: "count" words, each of "size" bytes
+ * - order: 1 - most significant word first, -1 - least significant first
+ * - endian: byte order in a word, 1 - big, -1 - little, 0 - host
+ * - nails: top bits of each word to be ignored
+ * - sign is not stored, ti is non-negative
+ */
+int tt_int_import(struct tt_int *ti, const void *data, size_t count,
+		int order, size_t size, int endian, size_t nails)
+{
+	_tt_stat_func(TT_STAT_INT_IMPORT);
+	int ret = check_words(order, size, endian, nails);
+	if (ret)
+		return ret;
+
+	const uint64_t bits = (uint64_t)count * (size * 8 - nails);
+	const uint64_t words = bits / _tt_word_bits + 1;
+	if (words > INT_MAX) {
+		tt_error("Integer too large");
+		return TT_APN_EOVERFLOW;
+	}
+
+	_tt_int_zero(ti);
+	ret = _tt_int_realloc(ti, words);
+	if (ret)
+		return ret;
+
+	/* Limb layout, just copy */
+	if (is_limb_layout(order, size, endian, nails)) {
+		memcpy(ti->buf, data, count * size);
+		for (size_t i = 0; i < count; i++)
+			ti->buf[i] &= ~_tt_word_top_bit;
+		ti->msb = _tt_int_get_msb(ti->buf, count ? count : 1);
+		return 0;
+	}
+
+	if (endian == 0)
+		endian = HOST_ENDIAN;
+
+	/* Stream bits from least significant byte to limbs */
+	const uchar *bytes = data;
+	_tt_word_double acc = 0;
+	int accbits = 0, msb = 0;
+	for (size_t i = 0; i < count; i++) {
+		const uchar *w = bytes + (order < 0 ? i : count-1-i) * size;
+		int left = size * 8 - nails;
+
+		for (size_t j = 0; left > 0; j++) {
+			uint b = endian < 0 ? w[j] : w[size-1-j];
+			if (left < 8)
+				b &= BIT(left) - 1;
+			acc |= (_tt_word_double)b << accbits;
+			accbits += _tt_min(left, 8);
+			left -= 8;
+
+			if (accbits >= _tt_word_bits) {
+				ti->buf[msb++] = acc & ~_tt_word_top_bit;
+				acc >>= _tt_word_bits;
+				accbits -= _tt_word_bits;
+			}
+		}
+	}
+	if (accbits)
+		ti->buf[msb++] = acc;
+
+	ti->msb = _tt_int_get_msb(ti->buf, msb ? msb : 1);
+	return 0;
+}
+
+/* Export |ti| to raw binary words
+ * - order, size, endian, nails: same as tt_int_import()
+ * - count: buffer size in words on entry, words written on exit
+ * - data == NULL: only get required words in count
+ * - return TT_ENOBUFS if buffer is too small
+ */
+int tt_int_export(const struct tt_int *ti, void *data, size_t *count,
+		int order, size_t size, int endian, size_t nails)
+{
+	_tt_stat_func(TT_STAT_INT_EXPORT);
+	int ret = check_words(order, size, endian, nails);
+	if (ret)
+		return ret;
+
+	/* Required words */
+	const size_t wbits = size * 8 - nails;
+	uint64_t bits = 0;
+	if (!_tt_int_is_zero(ti))
+		bits = (uint64_t)(ti->msb - 1) * _tt_word_bits +
+			_tt_int_word_bits(ti->buf[ti->msb-1]);
+	const size_t n = (bits + wbits - 1) / wbits;
+
+	if (data == NULL) {
+		*count = n;
+		return 0;
+	}
+	if (*count < n)
+		return TT_ENOBUFS;
+	*count = n;
+
+	/* Limb layout, just copy */
+	if (is_limb_layout(order, size, endian, nails)) {
+		memcpy(data, ti->buf, n * size);
+		return 0;
+	}
+
+	if (endian == 0)
+		endian = HOST_ENDIAN;
+
+	/* Stream bits from limbs to least significant byte */
+	uchar *bytes = data;
+	_tt_word_double acc = 0;
+	int accbits = 0, limb = 0;
+	for (size_t i = 0; i < n; i++) {
+		uchar *w = bytes + (order < 0 ? i : n-1-i) * size;
+		int left = wbits;
+
+		for (size_t j = 0; j < size; j++) {
+			uint b = 0;
+			if (left > 0) {
+				const int nb = _tt_min(left, 8);
+				if (accbits < nb && limb < ti->msb) {
+					acc |= (_tt_word_double)ti->buf[limb++]
+						<< accbits;
+					accbits += _tt_word_bits;
+				}
+				b = acc & (BIT(nb) - 1);
+				acc >>= nb;
+				accbits -= nb;
+				left -= nb;
+			}
+
+			if (endian < 0)
+				w[j] = b;
+			else
+				w[size-1-j] = b;
+		}
+	}
+
+	return 0;
+}
@@ -5,6 +5,7 @@
 #include <tt/tt.h>
 #include <tt/apn/integer.h>
 #include <common/lib.h>
+#include <common/stats.h>
 #include "integer.h"
 
 #include <string.h>
@@ -62,3 +63,255 @@ int _tt_int_mont_reduce(_tt_word *r, int *msbr, const _tt_word *c, int msbc,
 
 	return 0;
 }
+
+/* Product tree of moduli
+ * - node[0]: moduli, not owned
+ * - node[l][i] = node[l-1][2i] * node[l-1][2i+1]
+ * - node[levels-1][0]: product of all moduli
+ */
+struct prod_tree {
+	int levels;
+	int cnt[32];
+	struct tt_int **node[32];
+};
+
+static void free_tree(struct prod_tree *pt)
+{
+	for (int l = 1; l < pt->levels; l++) {
+		for (int i = 0; i < pt->cnt[l]; i++)
+			if (pt->node[l][i])
+				tt_int_free(pt->node[l][i]);
+		free(pt->node[l]);
+	}
+}
+
+static int build_tree(struct prod_tree *pt, struct tt_int **mods, int n)
+{
+	memset(pt, 0, sizeof(*pt));
+	pt->levels = 1;
+	pt->cnt[0] = n;
+	pt->node[0] = mods;
+
+	while (pt->cnt[pt->levels-1] > 1) {
+		const int l = pt->levels;
+		const int m = (pt->cnt[l-1] + 1) / 2;
+
+		pt->node[l] = calloc(m, sizeof(struct tt_int *));
+		if (pt->node[l] == NULL)
+			return TT_ENOMEM;
+		pt->cnt[l] = m;
+		pt->levels++;
+
+		for (int i = 0; i < m; i++) {
+			struct tt_int *t = pt->node[l][i] = tt_int_alloc();
+			if (t == NULL)
+				return TT_ENOMEM;
+
+			struct tt_int **c = pt->node[l-1] + i*2;
+			int ret;
+			if (i*2 + 1 < pt->cnt[l-1])
+				ret = tt_int_mul(t, c[0], c[1]);
+			else
+				ret = _tt_int_copy(t, c[0]);
+			if (ret)
+				return ret;
+		}
+	}
+
+	return 0;
+}
+
+/* r = a mod m, 0 <= r < m, r may share a */
+static int mod_pos(struct tt_int *r, const struct tt_int *a,
+		const struct tt_int *m)
+{
+	int ret = tt_int_div(NULL, r, a, m);
+
+	if (ret == 0 && r->sign) {
+		if (_tt_int_is_zero(r))
+			r->sign = 0;
+		else
+			ret = tt_int_add(r, r, m);
+	}
+	return ret;
+}
+
+/* rem[i] = ti mod m[i] (square = 0), or ti mod m[i]^2 (square = 1)
+ * - each node reduces remainder of its parent, from root to leaves
+ */
+static int rem_tree(struct tt_int **rem, const struct tt_int *ti,
+		const struct prod_tree *pt, int square)
+{
+	int ret = TT_ENOMEM;
+	const int m = pt->levels > 1 ? pt->cnt[1] : 0;
+
+	/* Ping-pong remainders of two levels */
+	struct tt_int **pool = calloc(m * 2 + 1, sizeof(struct tt_int *));
+	if (pool == NULL)
+		return TT_ENOMEM;
+	for (int i = 0; i < m * 2 + 1; i++)
+		if ((pool[i] = tt_int_alloc()) == NULL)
+			goto out;
+	struct tt_int **cur = pool, **next = pool + m;
+	struct tt_int *sq = pool[m * 2];
+
+	for (int l = pt->levels - 1; l >= 0; l--) {
+		struct tt_int **dst = l ? next : rem;
+
+		for (int i = 0; i < pt->cnt[l]; i++) {
+			const struct tt_int *mod = pt->node[l][i];
+			if (square) {
+				ret = tt_int_mul(sq, mod, mod);
+				if (ret)
+					goto out;
+				mod = sq;
+			}
+
+			const struct tt_int *a = ti;
+			if (l < pt->levels - 1)
+				a = cur[i/2];
+			ret = mod_pos(dst[i], a, mod);
+			if (ret)
+				goto out;
+		}
+		__tt_swap(cur, next);
+	}
+	ret = 0;
+
+out:
+	for (int i = 0; i < m * 2 + 1; i++)
+		if (pool[i])
+			tt_int_free(pool[i]);
+	free(pool);
+	return ret;
+}
+
+static int check_mods(struct tt_int **mods, int n)
+{
+	if (n <= 0)
+		return TT_EINVAL;
+	for (int i = 0; i < n; i++) {
+		if (mods[i]->sign || _tt_int_is_zero(mods[i])) {
+			tt_error("Invalid modulus");
+			return TT_EINVAL;
+		}
+	}
+	return 0;
+}
+
+/* rem[i] = ti mod mods[i], i = 0 ~ n-1
+ * - moduli must be positive, remainders are in [0, mods[i])
+ * - product tree and remainder tree, quasi-linear with fast multiplication
+ *   and division
+ */
+int tt_int_mod_multi(struct tt_int **rem, const struct tt_int *ti,
+		struct tt_int **mods, int n)
+{
+	_tt_stat_func(TT_STAT_INT_MOD_MULTI);
+	int ret = check_mods(mods, n);
+	if (ret)
+		return ret;
+
+	struct prod_tree pt;
+	ret = build_tree(&pt, mods, n);
+	if (ret == 0)
+		ret = rem_tree(rem, ti, &pt, 0);
+
+	free_tree(&pt);
+	return ret;
+}
+
+/* Chinese remainder theorem
+ * - x = rems[i] mod mods[i], i = 0 ~ n-1, 0 <= x < prod(mods)
+ * - moduli must be positive and pairwise coprime
+ * - M = prod(mods[i]), c[i] = inverse of M/mods[i] mod mods[i]
+ *   x = sum(rems[i] * c[i] * M/mods[i]) mod M
+ * - M/mods[i] mod mods[i] comes from a remainder tree of M mod mods[i]^2,
+ *   the sum is merged bottom-up in the product tree
+ */
+int tt_int_crt(struct tt_int *x, struct tt_int **rems,
+		struct tt_int **mods, int n)
+{
+	_tt_stat_func(TT_STAT_INT_CRT);
+	int ret = check_mods(mods, n);
+	if (ret)
+		return ret;
+
+	struct prod_tree pt;
+	struct tt_int *g = tt_int_alloc(), *t = tt_int_alloc();
+	struct tt_int *u = tt_int_alloc();
+	struct tt_int **v = calloc(n, sizeof(struct tt_int *));
+	ret = TT_ENOMEM;
+	if (!g || !t || !u || !v)
+		goto out_free;
+	for (int i = 0; i < n; i++)
+		if ((v[i] = tt_int_alloc()) == NULL)
+			goto out_free;
+
+	ret = build_tree(&pt, mods, n);
+	if (ret)
+		goto out;
+	const struct tt_int *M = pt.node[pt.levels-1][0];
+
+	/* v[i] = rems[i] / (M/mods[i]) mod mods[i] */
+	ret = rem_tree(v, M, &pt, 1);
+	if (ret)
+		goto out;
+	for (int i = 0; i < n; i++) {
+		ret = tt_int_divexact(v[i], v[i], mods[i]);
+		if (ret)
+			goto out;
+		ret = tt_int_extgcd(g, u, t, v[i], mods[i]);
+		if (ret)
+			goto out;
+		if (g->msb != 1 || g->buf[0] != 1) {
+			tt_error("Moduli not coprime");
+			ret = TT_APN_EINVAL;
+			goto out;
+		}
+		ret = tt_int_mul(t, rems[i], u);
+		if (ret)
+			goto out;
+		ret = mod_pos(v[i], t, mods[i]);
+		if (ret)
+			goto out;
+	}
+
+	/* Merge: v = v_left * P_right + v_right * P_left */
+	for (int l = 1; l < pt.levels; l++) {
+		struct tt_int **p = pt.node[l-1];
+
+		for (int i = 0; i < pt.cnt[l]; i++) {
+			if (i*2 + 1 < pt.cnt[l-1]) {
+				ret = tt_int_mul(t, v[i*2], p[i*2+1]);
+				if (ret)
+					goto out;
+				ret = tt_int_addmul(t, v[i*2+1], p[i*2]);
+				if (ret)
+					goto out;
+				__tt_swap(v[i], t);
+			} else if (i) {
+				__tt_swap(v[i], v[i*2]);
+			}
+		}
+	}
+
+	ret = mod_pos(x, v[0], M);
+
+out:
+	free_tree(&pt);
+out_free:
+	if (v) {
+		for (int i = 0; i < n; i++)
+			if (v[i])
+				tt_int_free(v[i]);
+		free(v);
+	}
+	if (g)
+		tt_int_free(g);
+	if (t)
+		tt_int_free(t);
+	if (u)
+		tt_int_free(u);
+	return ret;
+}
@@ -0,0 +1,248 @@
+/* Power, square root, n-th root
+ *
+ * Copyright (C) 2016 Yibo Cai
+ */
+#include <tt/tt.h>
+#include <tt/apn/integer.h>
+#include <common/lib.h>
+#include <common/stats.h>
+#include "integer.h"
+
+#include <string.h>
+#include <limits.h>
+
+/* Below this root size (in bits), start Newton iteration from a power of 2 */
+#define ROOT_CROSS	_tt_word_bits
+
+/* Bit length of a non-zero integer */
+static uint64_t int_bits(const struct tt_int *ti)
+{
+	return (uint64_t)(ti->msb - 1) * _tt_word_bits +
+		_tt_int_word_bits(ti->buf[ti->msb-1]);
+}
+
+/* ti = base^exp
+ * - left-to-right binary exponentiation, squaring via _tt_int_mul_buf
+ * - trailing zero bits of base are moved to a final shift
+ * - ti may share base
+ */
+int tt_int_pow(struct tt_int *ti, const struct tt_int *base, uint exp)
+{
+	_tt_stat_func(TT_STAT_INT_POW);
+	if (exp == 0)
+		return tt_int_from_uint(ti, 1);
+	if (_tt_int_is_zero(base)) {
+		_tt_int_zero(ti);
+		return 0;
+	}
+
+	const int sign = base->sign && (exp & 1);
+
+	/* base = odd * 2^zeros */
+	int wz = 0;
+	while (base->buf[wz] == 0)
+		wz++;
+	const uint64_t zeros = (uint64_t)wz * _tt_word_bits +
+		_tt_int_word_ctz(base->buf[wz]);
+	const uint64_t shift = zeros * exp;
+	const uint64_t bits = (int_bits(base) - zeros) * exp;
+	if (shift > INT_MAX || bits / _tt_word_bits + 2 > INT_MAX / 3) {
+		tt_error("Result too large");
+		return TT_APN_EOVERFLOW;
+	}
+
+	/* Working buffer: odd base, two ping-pong product buffers */
+	const int words = bits / _tt_word_bits + 2;
+	_tt_word *workbuf = malloc(words * 3 * _tt_word_sz);
+	if (workbuf == NULL)
+		return TT_ENOMEM;
+	_tt_word *b = workbuf, *x = b + words, *t = x + words;
+
+	int msbb = base->msb - wz;
+	memcpy(b, base->buf + wz, msbb * _tt_word_sz);
+	msbb = _tt_int_shift_buf(b, msbb, -(int)(zeros % _tt_word_bits));
+
+	int ret = 0, msbx = msbb, msbt;
+	memcpy(x, b, msbb * _tt_word_sz);
+
+	if (!(msbb == 1 && b[0] == 1)) {
+		for (int i = 30 - __builtin_clz(exp); i >= 0; i--) {
+			/* x = x^2 */
+			memset(t, 0, msbx * 2 * _tt_word_sz);
+			msbt = _tt_int_mul_buf(t, x, msbx, x, msbx);
+			if (msbt < 0) {
+				ret = msbt;
+				goto out;
+			}
+			__tt_swap(x, t);
+			msbx = msbt;
+
+			if ((exp >> i) & 1) {
+				/* x = x * base */
+				memset(t, 0, (msbx + msbb) * _tt_word_sz);
+				msbt = _tt_int_mul_buf(t, x, msbx, b, msbb);
+				if (msbt < 0) {
+					ret = msbt;
+					goto out;
+				}
+				__tt_swap(x, t);
+				msbx = msbt;
+			}
+		}
+	}
+	tt_assert_fa(msbx <= words);
+
+	_tt_int_zero(ti);
+	ret = _tt_int_realloc(ti, msbx);
+	if (ret)
+		goto out;
+	memcpy(ti->buf, x, msbx * _tt_word_sz);
+	ti->msb = msbx;
+	ti->sign = sign;
+
+	if (shift)
+		ret = tt_int_shift(ti, (int)shift);
+
+out:
+	free(workbuf);
+	return ret;
+}
+
+/* One Newton step for n-th root of a
+ * - y = ((n-1)*x + a/x^(n-1)) / n
+ * - t: temporary integer
+ */
+static int root_step(struct tt_int *y, const struct tt_int *x,
+		const struct tt_int *a, uint n, struct tt_int *t)
+{
+	int ret;
+
+	if (n == 2) {
+		/* y = (x + a/x) / 2 */
+		ret = tt_int_div(t, NULL, a, x);
+		if (ret)
+			return ret;
+		ret = tt_int_add(y, t, x);
+		if (ret)
+			return ret;
+		return tt_int_shift(y, -1);
+	}
+
+	ret = tt_int_pow(t, x, n-1);
+	if (ret)
+		return ret;
+	ret = tt_int_div(t, NULL, a, t);
+	if (ret)
+		return ret;
+	tt_int_from_uint(y, n-1);
+	ret = tt_int_mul(y, y, x);
+	if (ret)
+		return ret;
+	ret = tt_int_add(y, y, t);
+	if (ret)
+		return ret;
+	tt_int_from_uint(t, n);
+	return tt_int_div(y, NULL, y, t);
+}
+
+/* x = floor(a^(1/n)), a > 0
+ * - initial guess comes from the root of the top half bits of a, so only
+ *   a couple of full size Newton steps are required
+ * - x must not share a
+ */
+static int root_newton(struct tt_int *x, const struct tt_int *a, uint n)
+{
+	int ret;
+	const uint64_t bits = int_bits(a);
+	const uint64_t s = bits / (n * 2);
+
+	struct tt_int *y = tt_int_alloc();
+	struct tt_int *t = tt_int_alloc();
+	if (!y || !t) {
+		ret = TT_ENOMEM;
+		goto out;
+	}
+
+	/* Initial guess x0 >= floor(a^(1/n)) */
+	if (s < ROOT_CROSS) {
+		/* x0 = 2^ceil(bits/n) */
+		tt_int_from_uint(x, 1);
+		ret = tt_int_shift(x, (bits + n - 1) / n);
+	} else {
+		/* x0 = (floor((a >> n*s)^(1/n)) + 1) << s */
+		ret = _tt_int_copy(t, a);
+		if (ret)
+			goto out;
+		ret = tt_int_shift(t, -(int)(s * n));
+		if (ret)
+			goto out;
+		ret = root_newton(x, t, n);
+		if (ret)
+			goto out;
+		tt_int_from_uint(t, 1);
+		ret = tt_int_add(x, x, t);
+		if (ret)
+			goto out;
+		ret = tt_int_shift(x, (int)s);
+	}
+	if (ret)
+		goto out;
+
+	/* Iterate till no longer decreasing */
+	while (1) {
+		ret = root_step(y, x, a, n, t);
+		if (ret)
+			goto out;
+		if (tt_int_cmp(y, x) >= 0)
+			break;
+		ret = _tt_int_copy(x, y);
+		if (ret)
+			goto out;
+	}
+
+out:
+	if (y)
+		tt_int_free(y);
+	if (t)
+		tt_int_free(t);
+	return ret;
+}
+
+/* root = floor(ti^(1/n))
+ * - odd n: root of negative ti is -floor(|ti|^(1/n))
+ * - root may share ti
+ */
+int tt_int_root(struct tt_int *root, const struct tt_int *ti, uint n)
+{
+	_tt_stat_func(TT_STAT_INT_ROOT);
+	if (n == 0) {
+		tt_error("Invalid parameter");
+		return TT_EINVAL;
+	}
+	if (ti->sign && (n & 1) == 0 && !_tt_int_is_zero(ti))
+		return TT_APN_EINVAL;
+	if (n == 1 || _tt_int_is_zero(ti) || (ti->msb == 1 && ti->buf[0] == 1))
+		return root == ti ? 0 : _tt_int_copy(root, ti);
+
+	const int sign = ti->sign;
+	struct tt_int *a = tt_int_alloc();
+	if (!a)
+		return TT_ENOMEM;
+	int ret = _tt_int_copy(a, ti);
+	if (ret)
+		goto out;
+	a->sign = 0;
+
+	ret = root_newton(root, a, n);
+	root->sign = sign;
+
+out:
+	tt_int_free(a);
+	return ret;
+}
+
+/* root = floor(sqrt(ti)), root may share ti */
+int tt_int_sqrt(struct tt_int *root, const struct tt_int *ti)
+{
+	return tt_int_root(root, ti, 2);
+}
@@ -5,6 +5,7 @@
 #include <tt/tt.h>
 #include <tt/apn/integer.h>
 #include <common/lib.h>
+#include <common/stats.h>
 #include "integer.h"
 
 #include <string.h>
@@ -296,5 +297,6 @@ bool _tt_int_isprime_buf(const _tt_word *ui, int msb)
 
 bool tt_int_isprime(const struct tt_int *ti)
 {
+	_tt_stat_func(TT_STAT_INT_ISPRIME);
 	return _tt_int_isprime_buf(ti->buf, ti->msb);
 }
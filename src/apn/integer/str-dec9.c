@@ -1360,8 +1360,6 @@ static const uint64_t dec9_norm_4096[] = {
 	0x132349CF6368D827, 0x27926331DECC9856, 0x5E2D188A834BEA16,
 };
 
-#define DEC9_CROSS_IDX	5	/* Convert short integers by basic division */
-
 #else	/* _TT_LP64_ */
 
 #define dec9_shift_1	1
@@ -2741,8 +2739,6 @@ static const uint dec9_norm_4096[] = {
 	0x13C93198, 0x41A5F50B, 0x5E2D188A,
 };
 
-#define DEC9_CROSS_IDX	8	/* Convert short integers by basic division */
-
 #endif	/* _TT_LP64_ */
 
 static const struct {
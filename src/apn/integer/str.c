@@ -4,7 +4,9 @@
  */
 #include <tt/tt.h>
 #include <tt/apn/integer.h>
+#include <tt/common/param.h>
 #include <common/lib.h>
+#include <common/stats.h>
 #include "integer.h"
 
 #include <string.h>
@@ -12,6 +14,10 @@
 
 #include "str-dec9.c"
 
+/* Convert short integers by basic division, tunable at runtime */
+#define DEC9_CROSS_IDX	\
+	_tt_min(_tt_param.dec9_cross_idx, (int)ARRAY_SIZE(dec9) - 1)
+
 static char bin_to_ascii[] = "0123456789ABCDEF";
 
 static char ascii_to_bin[] = {
@@ -153,6 +159,7 @@ out:
 
 int tt_int_from_string(struct tt_int *ti, const char *str)
 {
+	_tt_stat_func(TT_STAT_INT_FROM_STRING);
 	_tt_int_zero(ti);
 
 	/* Check leading "+", "-" */
@@ -298,6 +305,7 @@ int tt_int_from_string(struct tt_int *ti, const char *str)
 
 int tt_int_to_string(const struct tt_int *ti, char **str, int radix)
 {
+	_tt_stat_func(TT_STAT_INT_TO_STRING);
 	if (*str)
 		tt_warn("Possible memory leak: str != NULL");
 
@@ -1,4 +1,4 @@
 lib-y := libttcommon.a
 
-obj-y += lib.o log.o key.o fpe.o round.o rand.o
+obj-y += lib.o log.o key.o fpe.o round.o rand.o param.o stats.o
 obj-y += sort.o stack.o queue.o heap.o tree.o
@@ -63,6 +63,9 @@ int _tt_round(int odd, uint dig, int rnd);
 /* Bit reversal */
 uint _tt_bitrev(uint n, int bits);
 
+/* Tunable parameters, see tt/common/param.h */
+extern struct tt_param _tt_param;
+
 /* Pesudo random number */
 void _tt_srand(uint seed);
 uint _tt_rand(void);
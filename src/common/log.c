@@ -1,10 +1,24 @@
 /* log.c
+ *
+ * Trace target (TT_LOG_TARGET_TRACE)
+ * - each thread appends binary records to its own ring buffer, no locks
+ * - a record keeps format pointer and raw arguments, formatting is deferred
+ *   to tt_log_dump()
+ * - "%s" arguments are copied into the record, truncated if too long
+ * - format string must be a literal (or otherwise outlive the record)
+ * - oldest records are overwritten when the ring is full
+ * - ring of an exited thread is kept for dump and handed to the next new
+ *   thread, memory is bounded by peak live threads
  *
  * Copyright (C) 2014 Yibo Cai
  */
 #include <tt/tt.h>
+#include "lib.h"
 
 #include <string.h>
+#include <stddef.h>
+#include <time.h>
+#include <pthread.h>
 
 static char level2char[] = {
 	[TT_LOG_ERROR]  = 'E',
@@ -15,7 +29,413 @@ static char level2char[] = {
 
 static int __target = TT_LOG_TARGET_STDERR;
 static int __fd = -1;
-static int __level = TT_LOG_DEBUG;
+int _tt_log_level = TT_LOG_DEBUG;
+
+#define TRACE_RECS	1024	/* Records per thread, power of 2 */
+#define TRACE_ARGS	8	/* Arguments per record */
+#define TRACE_STR	40	/* Bytes of copied strings per record */
+
+union trace_arg {
+	uint64_t u;
+	double d;
+};
+
+struct trace_rec {
+	uint64_t ts;		/* Monotonic time in ns */
+	const char *func, *format;
+	uchar level, nargs, strsz;
+	int id;			/* Thread of the record, ring may be reused */
+	union trace_arg arg[TRACE_ARGS];	/* "%s": offset in str */
+	char str[TRACE_STR];
+};
+
+struct trace_ring {
+	struct trace_ring *next;
+	uint64_t head;		/* Written by owner thread only */
+	uint64_t tail;		/* Written by tt_log_dump() only */
+	struct trace_rec rec[TRACE_RECS];
+};
+
+/* Ring lists are changed on thread start and exit only, and walked by
+ * tt_log_dump(), all under trace_lock. Recording takes no lock.
+ */
+static struct trace_ring *trace_rings;	/* Owned by live threads */
+static struct trace_ring *trace_free;	/* Left by exited threads */
+static pthread_mutex_t trace_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t trace_once = PTHREAD_ONCE_INIT;
+static pthread_key_t trace_key;
+static int trace_ids;
+static __thread struct trace_ring *trace_ring;
+static __thread int trace_id;
+
+/* Conversion specification */
+struct spec {
+	char flags[8];
+	int width, prec;	/* -1: not given, -2: '*' */
+	char len;		/* 'H'(hh), 'h', 'l', 'q'(ll), 'j', 'z', 't', 'L' */
+	char conv;
+};
+
+/* Parse conversion specification after '%', return next character */
+static const char *parse_spec(const char *s, struct spec *sp)
+{
+	int n = 0;
+
+	memset(sp, 0, sizeof(*sp));
+	while (strchr("-+ #0'", *s) && *s && n < sizeof(sp->flags) - 1)
+		sp->flags[n++] = *s++;
+
+	sp->width = -1;
+	if (*s == '*') {
+		sp->width = -2;
+		s++;
+	} else if (*s >= '0' && *s <= '9') {
+		sp->width = 0;
+		while (*s >= '0' && *s <= '9')
+			sp->width = sp->width * 10 + *s++ - '0';
+	}
+
+	sp->prec = -1;
+	if (*s == '.') {
+		s++;
+		sp->prec = 0;
+		if (*s == '*') {
+			sp->prec = -2;
+			s++;
+		} else {
+			while (*s >= '0' && *s <= '9')
+				sp->prec = sp->prec * 10 + *s++ - '0';
+		}
+	}
+
+	if (*s == 'h' || *s == 'l') {
+		sp->len = *s++;
+		if (*s == sp->len) {
+			sp->len = sp->len == 'h' ? 'H' : 'q';
+			s++;
+		}
+	} else if (strchr("jztL", *s) && *s) {
+		sp->len = *s++;
+	}
+
+	sp->conv = *s;
+	return *s ? s + 1 : s;
+}
+
+static bool is_signed_conv(char c)
+{
+	return c == 'd' || c == 'i';
+}
+
+static bool is_int_conv(char c)
+{
+	return c && strchr("diouxXc", c);
+}
+
+static bool is_float_conv(char c)
+{
+	return c && strchr("fFeEgGaA", c);
+}
+
+/* Fetch one integer argument, widened to 64 bits */
+static uint64_t fetch_int(va_list *ap, const struct spec *sp)
+{
+	const bool sgn = is_signed_conv(sp->conv);
+
+	switch (sp->len) {
+	case 'l':
+		return sgn ? (int64_t)va_arg(*ap, long) :
+			(uint64_t)va_arg(*ap, unsigned long);
+	case 'q':
+		return sgn ? (int64_t)va_arg(*ap, long long) :
+			(uint64_t)va_arg(*ap, unsigned long long);
+	case 'j':
+		return sgn ? (int64_t)va_arg(*ap, intmax_t) :
+			(uint64_t)va_arg(*ap, uintmax_t);
+	case 'z':
+		return sgn ? (int64_t)va_arg(*ap, ssize_t) :
+			(uint64_t)va_arg(*ap, size_t);
+	case 't':
+		return (int64_t)va_arg(*ap, ptrdiff_t);
+	case 'H':
+		return sgn ? (int64_t)(signed char)va_arg(*ap, int) :
+			(uint64_t)(uchar)va_arg(*ap, int);
+	case 'h':
+		return sgn ? (int64_t)(short)va_arg(*ap, int) :
+			(uint64_t)(unsigned short)va_arg(*ap, int);
+	default:
+		return sgn ? (int64_t)va_arg(*ap, int) :
+			(uint64_t)va_arg(*ap, unsigned int);
+	}
+}
+
+/* Thread exit, move ring to free list, its records are still dumped */
+static void trace_ring_put(void *arg)
+{
+	struct trace_ring *ring = arg, **p;
+
+	pthread_mutex_lock(&trace_lock);
+	for (p = &trace_rings; *p && *p != ring; p = &(*p)->next)
+		;
+	if (*p) {
+		*p = ring->next;
+		ring->next = trace_free;
+		trace_free = ring;
+	}
+	pthread_mutex_unlock(&trace_lock);
+
+	trace_ring = NULL;
+}
+
+static void trace_key_init(void)
+{
+	pthread_key_create(&trace_key, trace_ring_put);
+}
+
+static struct trace_ring *trace_ring_get(void)
+{
+	if (_tt_likely(trace_ring))
+		return trace_ring;
+
+	pthread_once(&trace_once, trace_key_init);
+
+	pthread_mutex_lock(&trace_lock);
+	struct trace_ring *ring = trace_free;
+	if (ring)
+		trace_free = ring->next;
+	else
+		ring = calloc(1, sizeof(struct trace_ring));
+	if (ring) {
+		ring->next = trace_rings;
+		trace_rings = ring;
+	}
+	pthread_mutex_unlock(&trace_lock);
+	if (ring == NULL)
+		return NULL;
+
+	pthread_setspecific(trace_key, ring);
+	trace_id = __atomic_fetch_add(&trace_ids, 1, __ATOMIC_RELAXED);
+	trace_ring = ring;
+	return ring;
+}
+
+static void trace_record(int level, const char *func, const char *format,
+		va_list ap)
+{
+	struct trace_ring *ring = trace_ring_get();
+	if (ring == NULL)
+		return;
+
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	struct trace_rec *rec = &ring->rec[ring->head & (TRACE_RECS - 1)];
+	rec->ts = ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+	rec->func = func;
+	rec->format = format;
+	rec->level = level;
+	rec->id = trace_id;
+
+	/* Copy raw arguments as format specifies */
+	va_list aq;
+	va_copy(aq, ap);
+
+	int n = 0, strsz = 0;
+	const char *s = format;
+	while ((s = strchr(s, '%'))) {
+		struct spec sp;
+
+		if (*++s == '%') {
+			s++;
+			continue;
+		}
+		s = parse_spec(s, &sp);
+
+		/* Stop on unsupported conversion or too many arguments */
+		const int cnt = 1 + (sp.width == -2) + (sp.prec == -2);
+		if (n + cnt > TRACE_ARGS)
+			break;
+		if (sp.width == -2)
+			rec->arg[n++].u = va_arg(aq, int);
+		if (sp.prec == -2)
+			rec->arg[n++].u = va_arg(aq, int);
+
+		if (is_int_conv(sp.conv)) {
+			rec->arg[n++].u = fetch_int(&aq, &sp);
+		} else if (is_float_conv(sp.conv)) {
+			if (sp.len == 'L')
+				rec->arg[n++].d = va_arg(aq, long double);
+			else
+				rec->arg[n++].d = va_arg(aq, double);
+		} else if (sp.conv == 'p') {
+			rec->arg[n++].u = (uintptr_t)va_arg(aq, void *);
+		} else if (sp.conv == 's') {
+			const char *str = va_arg(aq, const char *);
+			if (str == NULL)
+				str = "(null)";
+			int l = strnlen(str, TRACE_STR - 1 - strsz);
+			memcpy(rec->str + strsz, str, l);
+			rec->str[strsz + l] = '\0';
+			rec->arg[n++].u = strsz;
+			strsz += l + (strsz + l < TRACE_STR - 1);
+		} else {
+			break;
+		}
+	}
+	va_end(aq);
+
+	rec->nargs = n;
+	rec->strsz = strsz;
+
+	/* Publish record */
+	__atomic_store_n(&ring->head, ring->head + 1, __ATOMIC_RELEASE);
+}
+
+/* Format one trace record to buf, return length */
+static int trace_format(const struct trace_rec *rec, char *buf, int len)
+{
+	int n = 0, a = 0;
+	const char *s = rec->format;
+
+#define _out(...)							\
+	do {								\
+		if (n < len)						\
+			n += snprintf(buf + n, len - n, __VA_ARGS__);	\
+	} while (0)
+
+	_out("%" PRIu64 ".%06u T%d [%c]%s: ", rec->ts / 1000000000,
+			(uint)(rec->ts % 1000000000 / 1000), rec->id,
+			level2char[rec->level], rec->func);
+
+	while (*s) {
+		const char *p = strchr(s, '%');
+		if (p == NULL)
+			p = s + strlen(s);
+		_out("%.*s", (int)(p - s), s);
+		if (*p == '\0')
+			break;
+		if (p[1] == '%') {
+			_out("%%");
+			s = p + 2;
+			continue;
+		}
+
+		struct spec sp;
+		s = parse_spec(p + 1, &sp);
+
+		const int cnt = 1 + (sp.width == -2) + (sp.prec == -2);
+		if (a + cnt > rec->nargs) {
+			_out("<Truncated>");
+			break;
+		}
+		if (sp.width == -2)
+			sp.width = (int)rec->arg[a++].u;
+		if (sp.prec == -2)
+			sp.prec = (int)rec->arg[a++].u;
+
+		/* Rebuild specification with 64-bit length */
+		char f[32];
+		int fl = snprintf(f, sizeof(f), "%%%s", sp.flags);
+		if (sp.width >= 0)
+			fl += snprintf(f + fl, sizeof(f) - fl, "%d", sp.width);
+		if (sp.prec >= 0)
+			fl += snprintf(f + fl, sizeof(f) - fl, ".%d", sp.prec);
+
+		const union trace_arg *arg = &rec->arg[a++];
+		if (is_int_conv(sp.conv) && sp.conv != 'c') {
+			snprintf(f + fl, sizeof(f) - fl, "ll%c", sp.conv);
+			if (is_signed_conv(sp.conv))
+				_out(f, (long long)arg->u);
+			else
+				_out(f, (unsigned long long)arg->u);
+		} else if (sp.conv == 'c') {
+			snprintf(f + fl, sizeof(f) - fl, "c");
+			_out(f, (int)arg->u);
+		} else if (is_float_conv(sp.conv)) {
+			snprintf(f + fl, sizeof(f) - fl, "%c", sp.conv);
+			_out(f, arg->d);
+		} else if (sp.conv == 'p') {
+			snprintf(f + fl, sizeof(f) - fl, "p");
+			_out(f, (void *)(uintptr_t)arg->u);
+		} else {
+			snprintf(f + fl, sizeof(f) - fl, "s");
+			_out(f, rec->str + arg->u);
+		}
+	}
+
+	if (n >= len)
+		n = len - 1;
+	buf[n++] = '\n';
+
+#undef _out
+	return n;
+}
+
+/* Oldest pending record in ring list, update *min and *minrec */
+static void trace_oldest(struct trace_ring *r, struct trace_ring **min,
+		const struct trace_rec **minrec)
+{
+	for (; r; r = r->next) {
+		const uint64_t head = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+		if (head - r->tail > TRACE_RECS)
+			r->tail = head - TRACE_RECS;	/* Overwritten */
+		if (r->tail == head)
+			continue;
+
+		const struct trace_rec *rec = &r->rec[r->tail & (TRACE_RECS - 1)];
+		if (*minrec == NULL || rec->ts < (*minrec)->ts) {
+			*min = r;
+			*minrec = rec;
+		}
+	}
+}
+
+int tt_log_dump(int fd)
+{
+	char buf[512+1];
+	int ret = 0;
+
+	pthread_mutex_lock(&trace_lock);
+
+	/* Merge records of all threads by time */
+	while (1) {
+		struct trace_ring *min = NULL;
+		const struct trace_rec *minrec = NULL;
+
+		trace_oldest(trace_rings, &min, &minrec);
+		trace_oldest(trace_free, &min, &minrec);
+		if (min == NULL)
+			break;
+
+		const int n = trace_format(minrec, buf, sizeof(buf)-1);
+		min->tail++;
+		if (write(fd, buf, n) != n) {
+			ret = TT_EIO;
+			break;
+		}
+	}
+
+	pthread_mutex_unlock(&trace_lock);
+	return ret;
+}
+
+/* Free rings of exited threads only, live threads may still be recording
+ * to theirs while the process exits
+ */
+static __attribute__ ((destructor)) void trace_deinit(void)
+{
+	struct trace_ring *r, *next;
+
+	pthread_mutex_lock(&trace_lock);
+	r = trace_free;
+	trace_free = NULL;
+	pthread_mutex_unlock(&trace_lock);
+
+	for (; r; r = next) {
+		next = r->next;
+		free(r);
+	}
+}
 
 void tt_log_set_target(int target)
 {
@@ -28,8 +448,8 @@ int tt_log_set_level(int level)
 {
 	tt_assert(level >= 0 && level < TT_LOG_MAX);
 
-	int old_level = __level;
-	__level = level;
+	int old_level = _tt_log_level;
+	_tt_log_level = level;
 
 	return old_level;
 }
@@ -51,12 +471,18 @@ void tt_log(int level, const char *func, const char *format, ...)
 
 	if (__target == TT_LOG_TARGET_NULL)
 		return;
-	if (level > __level)
+	if (level > _tt_log_level)
 		return;
 
 	va_list ap;
 	va_start(ap, format);
 
+	if (__target == TT_LOG_TARGET_TRACE) {
+		trace_record(level, func, format, ap);
+		va_end(ap);
+		return;
+	}
+
 	char msg[512+12];
 	if (vsnprintf(msg, 512, format, ap) >= 512)
 		snprintf(msg+511, 13, "<Truncated>");
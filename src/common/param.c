@@ -0,0 +1,124 @@
+/* Tunable algorithm parameters
+ *
+ * Copyright (C) 2016 Yibo Cai
+ */
+#include <tt/tt.h>
+#include <tt/common/param.h>
+#include "lib.h"
+
+#include <string.h>
+
+struct tt_param _tt_param = {
+#ifdef _TT_LP64_
+	.kara_cross = 16,
+	.bindiv_cross = 30,
+	.dec9_cross_idx = 5,
+#else
+	.kara_cross = 24,
+	.bindiv_cross = 35,
+	.dec9_cross_idx = 8,
+#endif
+	.fft_wn_pts = 8192,
+#if CONFIG_DEC_DIG64
+	.dec_kara_cross = 12,
+	.dec_ntt_cross = 600,
+	.dec_newton_cross = 260,
+#else
+	.dec_kara_cross = 16,
+	.dec_ntt_cross = 400,
+	.dec_newton_cross = 180,
+#endif
+};
+
+static const struct {
+	const char *name;
+	int offset;
+} param_names[] = {
+	{ "kara_cross", offset_of(struct tt_param, kara_cross) },
+	{ "bindiv_cross", offset_of(struct tt_param, bindiv_cross) },
+	{ "dec9_cross_idx", offset_of(struct tt_param, dec9_cross_idx) },
+	{ "fft_wn_pts", offset_of(struct tt_param, fft_wn_pts) },
+	{ "dec_kara_cross", offset_of(struct tt_param, dec_kara_cross) },
+	{ "dec_ntt_cross", offset_of(struct tt_param, dec_ntt_cross) },
+	{ "dec_newton_cross", offset_of(struct tt_param, dec_newton_cross) },
+};
+
+void tt_param_get(struct tt_param *param)
+{
+	*param = _tt_param;
+}
+
+int tt_param_set(const struct tt_param *param)
+{
+	const int pts = param->fft_wn_pts;
+
+	if (param->kara_cross < 4 || param->bindiv_cross < 8 ||
+			param->dec9_cross_idx < 0 ||
+			param->dec_kara_cross < 4 || param->dec_ntt_cross < 4 ||
+			param->dec_newton_cross < 2 ||
+			pts < 4 || pts > (1 << 24) || (pts & (pts - 1))) {
+		tt_error("Invalid parameter");
+		return TT_EINVAL;
+	}
+
+	_tt_param = *param;
+	return 0;
+}
+
+/* Load parameters from file, as written by "make tune"
+ * - one "name = value" per line, '#' starts a comment
+ * - unknown names are ignored
+ */
+int tt_param_load(const char *file)
+{
+	FILE *fp = fopen(file, "r");
+	if (fp == NULL) {
+		tt_error("Cannot open %s", file);
+		return TT_EINVAL;
+	}
+
+	int ret = 0, line = 0;
+	char buf[128], name[64];
+	struct tt_param param = _tt_param;
+
+	while (fgets(buf, sizeof(buf), fp)) {
+		line++;
+
+		char *s = strchr(buf, '#');
+		if (s)
+			*s = '\0';
+
+		int value;
+		int n = sscanf(buf, " %63[a-z0-9_] = %d", name, &value);
+		if (n == EOF || (n == 0 && strspn(buf, " \t\r\n") ==
+					strlen(buf)))
+			continue;
+		if (n != 2) {
+			tt_error("%s:%d: syntax error", file, line);
+			ret = TT_EINVAL;
+			break;
+		}
+
+		for (int i = 0; i < ARRAY_SIZE(param_names); i++) {
+			if (strcmp(name, param_names[i].name) == 0) {
+				*(int *)((char *)&param +
+						param_names[i].offset) = value;
+				break;
+			}
+		}
+	}
+	fclose(fp);
+
+	if (ret == 0)
+		ret = tt_param_set(&param);
+	return ret;
+}
+
+/* Load parameters from file given by environment variable TT_PARAM_FILE */
+static __attribute__ ((constructor)) void param_init(void)
+{
+	const char *file = getenv("TT_PARAM_FILE");
+
+	if (file)
+		tt_param_load(file);
+}
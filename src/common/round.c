@@ -5,8 +5,8 @@
 #include <tt/tt.h>
 #include <tt/common/round.h>
 
-/* Default: round half to even */
-static int _rounding = TT_ROUND_HALF_EVEN;
+/* Per thread, default: round half to even */
+static __thread int _rounding = TT_ROUND_HALF_EVEN;
 
 int tt_set_rounding(uint rnd)
 {
@@ -6,6 +6,7 @@
 #include <tt/common/sort.h>
 #include <tt/common/heap.h>
 #include "lib.h"
+#include "stats.h"
 
 #include <string.h>
 
@@ -302,6 +303,7 @@ static int (*tt_sort_internal[])(struct tt_sort_input *,
 
 int tt_sort(struct tt_sort_input *input)
 {
+	_tt_stat_func(TT_STAT_SORT);
 	tt_assert(input->alg >= 0 && input->alg < TT_SORT_MAX);
 
 	_tt_key_select(&input->num);
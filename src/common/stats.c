@@ -0,0 +1,168 @@
+/* Performance counters
+ *
+ * - counters are shared by all threads, updated with relaxed atomics
+ * - cycles are inclusive, a function calling other counted functions
+ *   accounts their cycles too
+ *
+ * Copyright (C) 2016 Yibo Cai
+ */
+#include <tt/tt.h>
+#include <tt/common/stats.h>
+#include "lib.h"
+#include "stats.h"
+
+#include <string.h>
+
+static const char *stat_names[TT_STAT_MAX] = {
+	[TT_STAT_INT_ADD]		= "int_add",
+	[TT_STAT_INT_SUB]		= "int_sub",
+	[TT_STAT_INT_MUL]		= "int_mul",
+	[TT_STAT_INT_DIV]		= "int_div",
+	[TT_STAT_INT_DIVEXACT]		= "int_divexact",
+	[TT_STAT_INT_ADDMUL]		= "int_addmul",
+	[TT_STAT_INT_MUL_UI]		= "int_mul_ui",
+	[TT_STAT_INT_DIV_UI]		= "int_div_ui",
+	[TT_STAT_INT_SHIFT]		= "int_shift",
+	[TT_STAT_INT_LOGIC]		= "int_logic",
+	[TT_STAT_INT_FROM_STRING]	= "int_from_string",
+	[TT_STAT_INT_TO_STRING]		= "int_to_string",
+	[TT_STAT_INT_IMPORT]		= "int_import",
+	[TT_STAT_INT_EXPORT]		= "int_export",
+	[TT_STAT_INT_POW]		= "int_pow",
+	[TT_STAT_INT_ROOT]		= "int_root",
+	[TT_STAT_INT_FACTORIAL]		= "int_factorial",
+	[TT_STAT_INT_BINOMIAL]		= "int_binomial",
+	[TT_STAT_INT_PRIMORIAL]		= "int_primorial",
+	[TT_STAT_INT_GCD]		= "int_gcd",
+	[TT_STAT_INT_EXTGCD]		= "int_extgcd",
+	[TT_STAT_INT_ISPRIME]		= "int_isprime",
+	[TT_STAT_INT_MOD_MULTI]		= "int_mod_multi",
+	[TT_STAT_INT_CRT]		= "int_crt",
+	[TT_STAT_INT_ALLOC]		= "int_alloc",
+	[TT_STAT_INT_MUL_CLASSIC]	= "int_mul_classic",
+	[TT_STAT_INT_MUL_KARA]		= "int_mul_karatsuba",
+	[TT_STAT_INT_DIV_CLASSIC]	= "int_div_classic",
+	[TT_STAT_INT_DIV_BIN]		= "int_div_binary",
+	[TT_STAT_DEC_ADD]		= "dec_add",
+	[TT_STAT_DEC_SUB]		= "dec_sub",
+	[TT_STAT_DEC_MUL]		= "dec_mul",
+	[TT_STAT_DEC_DIV]		= "dec_div",
+	[TT_STAT_DEC_CMP]		= "dec_cmp",
+	[TT_STAT_DEC_FROM_STRING]	= "dec_from_string",
+	[TT_STAT_DEC_TO_STRING]		= "dec_to_string",
+	[TT_STAT_DEC_FROM_FLOAT]	= "dec_from_float",
+	[TT_STAT_DEC_TO_FLOAT]		= "dec_to_float",
+	[TT_STAT_DEC_SQRT]		= "dec_sqrt",
+	[TT_STAT_DEC_EXP]		= "dec_exp",
+	[TT_STAT_DEC_LN]		= "dec_ln",
+	[TT_STAT_DEC_LOG10]		= "dec_log10",
+	[TT_STAT_DEC_POW]		= "dec_pow",
+	[TT_STAT_DEC_CONST]		= "dec_const",
+	[TT_STAT_DEC_QUANTIZE]		= "dec_quantize",
+	[TT_STAT_DEC_REDUCE]		= "dec_reduce",
+	[TT_STAT_DEC_DOT]		= "dec_dot",
+	[TT_STAT_DEC_SUM]		= "dec_sum",
+	[TT_STAT_DEC_ALLOC]		= "dec_alloc",
+	[TT_STAT_DEC_MUL_CLASSIC]	= "dec_mul_classic",
+	[TT_STAT_DEC_MUL_KARA]		= "dec_mul_karatsuba",
+	[TT_STAT_DEC_MUL_NTT]		= "dec_mul_ntt",
+	[TT_STAT_DEC_DIV_CLASSIC]	= "dec_div_classic",
+	[TT_STAT_DEC_DIV_NEWTON]	= "dec_div_newton",
+	[TT_STAT_DEC_FAST]		= "dec_fast",
+	[TT_STAT_FFT]			= "fft",
+	[TT_STAT_IFFT]			= "ifft",
+	[TT_STAT_FFT_REAL]		= "fft_real",
+	[TT_STAT_FFT_TBL]		= "fft_table",
+	[TT_STAT_DFT]			= "dft",
+	[TT_STAT_IDFT]			= "idft",
+	[TT_STAT_DFT_REAL]		= "dft_real",
+	[TT_STAT_MTX_MUL]		= "mtx_mul",
+	[TT_STAT_MTX_GAUSSJ]		= "mtx_gaussj",
+	[TT_STAT_SORT]			= "sort",
+};
+
+const char *tt_stats_name(int id)
+{
+	if (id < 0 || id >= TT_STAT_MAX || stat_names[id] == NULL)
+		return "unknown";
+	return stat_names[id];
+}
+
+#if CONFIG_STATS
+
+static struct tt_stats _stats;
+static tt_stats_hook _hook;
+static void *_hook_context;
+
+void _tt_stat_add(int id, uint64_t bytes)
+{
+	__atomic_fetch_add(&_stats.stat[id].calls, 1, __ATOMIC_RELAXED);
+	if (bytes)
+		__atomic_fetch_add(&_stats.stat[id].bytes, bytes,
+				__ATOMIC_RELAXED);
+}
+
+void _tt_stat_leave(struct _tt_stat_scope *scope)
+{
+	const uint64_t cycles = _tt_cycles() - scope->t0;
+	struct tt_stat *stat = &_stats.stat[scope->id];
+
+	__atomic_fetch_add(&stat->calls, 1, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&stat->cycles, cycles, __ATOMIC_RELAXED);
+
+	tt_stats_hook hook = _hook;
+	if (_tt_unlikely(hook))
+		hook(scope->id, cycles, _hook_context);
+}
+
+int tt_stats_snapshot(struct tt_stats *stats)
+{
+	for (int i = 0; i < TT_STAT_MAX; i++) {
+		struct tt_stat *s = &_stats.stat[i];
+
+		stats->stat[i].calls = __atomic_load_n(&s->calls,
+				__ATOMIC_RELAXED);
+		stats->stat[i].cycles = __atomic_load_n(&s->cycles,
+				__ATOMIC_RELAXED);
+		stats->stat[i].bytes = __atomic_load_n(&s->bytes,
+				__ATOMIC_RELAXED);
+	}
+	return 0;
+}
+
+void tt_stats_reset(void)
+{
+	for (int i = 0; i < TT_STAT_MAX; i++) {
+		struct tt_stat *s = &_stats.stat[i];
+
+		__atomic_store_n(&s->calls, 0, __ATOMIC_RELAXED);
+		__atomic_store_n(&s->cycles, 0, __ATOMIC_RELAXED);
+		__atomic_store_n(&s->bytes, 0, __ATOMIC_RELAXED);
+	}
+}
+
+/* Hook is not synchronized with running functions, set it at start-up */
+void tt_stats_set_hook(tt_stats_hook hook, void *context)
+{
+	_hook_context = context;
+	_tt_sync();
+	_hook = hook;
+}
+
+#else
+
+int tt_stats_snapshot(struct tt_stats *stats)
+{
+	memset(stats, 0, sizeof(*stats));
+	return TT_ENOTSUP;
+}
+
+void tt_stats_reset(void)
+{
+}
+
+void tt_stats_set_hook(tt_stats_hook hook, void *context)
+{
+}
+
+#endif
@@ -0,0 +1,53 @@
+/* Performance counters, internal
+ *
+ * Copyright (C) 2016 Yibo Cai
+ */
+#pragma once
+
+#include <tt/common/stats.h>
+
+#if CONFIG_STATS
+
+#include <time.h>
+
+/* Cycle counter, or nanoseconds if not available */
+static inline uint64_t _tt_cycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	return __builtin_ia32_rdtsc();
+#elif defined(__aarch64__)
+	uint64_t v;
+	__asm__ __volatile__("mrs %0, cntvct_el0" : "=r" (v));
+	return v;
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+#endif
+}
+
+struct _tt_stat_scope {
+	int id;
+	uint64_t t0;
+};
+
+void _tt_stat_leave(struct _tt_stat_scope *scope);
+void _tt_stat_add(int id, uint64_t bytes);
+
+/* Count calls and cycles of current function, put at function entry */
+#define _tt_stat_func(id)						\
+	struct _tt_stat_scope _tt_stat_scope				\
+		__attribute__ ((cleanup(_tt_stat_leave))) =		\
+		{ (id), _tt_cycles() }
+
+/* Count one event (algorithm tier, allocation) */
+#define _tt_stat_count(id)		_tt_stat_add((id), 0)
+#define _tt_stat_bytes(id, bytes)	_tt_stat_add((id), (bytes))
+
+#else
+
+#define _tt_stat_func(id)		do {} while (0)
+#define _tt_stat_count(id)		do {} while (0)
+#define _tt_stat_bytes(id, bytes)	do {} while (0)
+
+#endif
@@ -5,6 +5,7 @@
 #include <tt/tt.h>
 #include <tt/num/dft.h>
 #include <tt/num/complex.h>
+#include <common/stats.h>
 #include "num.h"
 
 #include <math.h>
@@ -21,6 +22,7 @@
  */
 int tt_dft(double (*out)[2], double (*in)[2], uint N)
 {
+	_tt_stat_func(TT_STAT_DFT);
 	tt_assert(N);
 
 	double em = 0;
@@ -57,6 +59,7 @@ int tt_dft(double (*out)[2], double (*in)[2], uint N)
  */
 int tt_idft(double (*out)[2], double (*in)[2], uint N)
 {
+	_tt_stat_func(TT_STAT_IDFT);
 	tt_assert(N);
 
 	double en = 0;
@@ -86,6 +89,7 @@ int tt_idft(double (*out)[2], double (*in)[2], uint N)
 /* in: [real1, real2, ..., realN] */
 int tt_dft_real(double (*out)[2], const double *in, uint N)
 {
+	_tt_stat_func(TT_STAT_DFT_REAL);
 	tt_assert(N);
 
 	double em = 0;
@@ -5,12 +5,17 @@
 #include <tt/tt.h>
 #include <tt/num/dft.h>
 #include <tt/num/complex.h>
+#include <tt/common/param.h>
+#include <common/lib.h>
+#include <common/stats.h>
 #include "num.h"
 
 #include <math.h>
 
-/* Fast lookup table (1/2 period, how about 1/8 period?) */
-#define WN_PTS	8192	/* Must be 2^n */
+/* Fast lookup table (1/2 period, how about 1/8 period?)
+ * - table size follows tunable parameter fft_wn_pts
+ */
+static int wn_pts;
 static double (*wn_ftbl)[2];
 
 static double (*gen_wn_tbl(int N))[2]
@@ -35,11 +40,19 @@ static double (*gen_wn_tbl(int N))[2]
 	return tbl;
 }
 
+static void fft_init_tbl(void)
+{
+	free(wn_ftbl);
+	wn_pts = _tt_param.fft_wn_pts;
+	wn_ftbl = gen_wn_tbl(wn_pts);
+	_tt_stat_bytes(TT_STAT_FFT_TBL, wn_pts / 2 * sizeof(*wn_ftbl));
+	tt_debug("FFT lookup table created: %d points, %zu KB",
+			wn_pts, wn_pts / 2 * sizeof(*wn_ftbl) / 1024);
+}
+
 static __attribute__ ((constructor)) void fft_init(void)
 {
-	wn_ftbl = gen_wn_tbl(WN_PTS);
-	tt_debug("FFT lookup table created: %d points, %d KB",
-			WN_PTS, WN_PTS / 2 * sizeof(*wn_ftbl) / 1024);
+	fft_init_tbl();
 }
 
 static __attribute__ ((destructor)) void fft_deinit(void)
@@ -50,12 +63,16 @@ static __attribute__ ((destructor)) void fft_deinit(void)
 /* TODO: keep lookup table for some time */
 static double (*get_wn_tbl(int N, int *delta))[2]
 {
-	if (N > WN_PTS) {
-		tt_info("Points > %d, new lookup table created.", WN_PTS);
+	/* Parameter changed */
+	if (wn_pts != _tt_param.fft_wn_pts)
+		fft_init_tbl();
+
+	if (N > wn_pts || wn_ftbl == NULL) {
+		tt_info("Points > %d, new lookup table created.", wn_pts);
 		*delta = 1;
 		return gen_wn_tbl(N);
 	} else {
-		*delta = WN_PTS / N;
+		*delta = wn_pts / N;
 		return wn_ftbl;
 	}
 }
@@ -183,6 +200,7 @@ static int do_stage(double (*out)[2], double (*in)[2], uint N,
 
 int tt_fft(double (*out)[2], double (*in)[2], uint N)
 {
+	_tt_stat_func(TT_STAT_FFT);
 	/* Check if N is 2^n */
 	if (N <= 1 || (N & (N-1))) {
 		tt_warn("%d is not power of 2, fallback to DFT", N);
@@ -194,6 +212,7 @@ int tt_fft(double (*out)[2], double (*in)[2], uint N)
 
 int tt_ifft(double (*out)[2], double (*in)[2], uint N)
 {
+	_tt_stat_func(TT_STAT_IFFT);
 	if (N <= 1 || (N & (N-1))) {
 		tt_warn("%d is not power of 2, fallback to IDFT", N);
 		return tt_idft(out, in, N);
@@ -214,6 +233,7 @@ int tt_ifft(double (*out)[2], double (*in)[2], uint N)
 
 int tt_fft_real(double (*out)[2], const double *in, uint N)
 {
+	_tt_stat_func(TT_STAT_FFT_REAL);
 	if (N <= 1 || (N & (N-1))) {
 		tt_warn("%d is not power of 2, fallback to DFT", N);
 		return tt_dft_real(out, in, N);
@@ -4,6 +4,7 @@
  */
 #include <tt/tt.h>
 #include <tt/num/matrix.h>
+#include <common/stats.h>
 #include "num.h"
 #include "mtx.h"
 
@@ -18,6 +19,7 @@
  */
 int tt_mtx_gaussj(struct tt_mtx *ma, struct tt_mtx *mb)
 {
+	_tt_stat_func(TT_STAT_MTX_GAUSSJ);
 	int ret = 0;
 	int i, j;
 	int *status_buf;
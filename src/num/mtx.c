@@ -4,6 +4,7 @@
  */
 #include <tt/tt.h>
 #include <tt/num/matrix.h>
+#include <common/stats.h>
 #include "num.h"
 #include "mtx.h"
 
@@ -17,6 +18,7 @@
 int tt_mtx_mul(struct tt_mtx *mo,
 		const struct tt_mtx *mi1, const struct tt_mtx *mi2)
 {
+	_tt_stat_func(TT_STAT_MTX_MUL);
 	tt_assert(mi1->cols == mi2->rows);
 	tt_assert(mo->rows == mi1->rows);
 	tt_assert(mo->cols == mi2->cols);
@@ -8,5 +8,6 @@ dft-objs		:= dft.o
 decimal-objs		:= decimal.o
 integer-objs		:= integer.o
 number-objs		:= number.o
+log-objs		:= log.o
 
-bin-y += matrix sort stack_queue heap tree graph dft decimal integer number
+bin-y += matrix sort stack_queue heap tree graph dft decimal integer number log
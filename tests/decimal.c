@@ -4,11 +4,18 @@
  */
 #include <tt/tt.h>
 #include <tt/apn/decimal.h>
+#include <tt/apn/integer.h>
+#include <tt/common/param.h>
+#include <tt/common/round.h>
+#include <tt/common/stats.h>
 #include <apn/decimal/decimal.h>
 
 #include <math.h>
 #include <time.h>
 #include <string.h>
+#include <assert.h>
+#include <unistd.h>
+#include <pthread.h>
 
 #pragma GCC diagnostic ignored "-Wunused-function"
 
@@ -62,6 +69,14 @@ static bool deq(double d1, double d2, double prec)
 	return dd < prec;
 }
 
+/* Relative tolerance of float add/sub: operand errors grow by cancellation */
+static double cancel_prec(double d1, double d2, double ds)
+{
+	if (ds == 0)
+		return 1E-15;
+	return 1E-15 * (fabs(d1) + fabs(d2)) / fabs(ds);
+}
+
 static long double get_num(char *s, int lmin, int lmax)
 {
 	long double ld = 0;
@@ -184,9 +199,6 @@ static void verify_add(int count)
 	for (int i = 0; i < count; i++) {
 		double d1 = gen_float(307);
 		double d2 = gen_float(307);
-		double prec = 1E-15;
-		if (signbit(d1) != signbit(d2))
-			prec = 1E-14;
 
 		tt_dec_from_float(dec1, d1);
 		tt_dec_from_float(dec2, d2);
@@ -206,6 +218,7 @@ static void verify_add(int count)
 		tt_dec_to_float(dec1, &vd2);
 
 		double ds = d1 + d2;
+		double prec = cancel_prec(d1, d2, ds);
 		if (!deq(vd1, ds, prec) || !deq(vd2, ds, prec)) {
 			tt_warn("Float add mismatch: %.18E + %.18E\n"
 					"Mach: %.18E\nDEC:  %.18E\nDEC:  %.18E",
@@ -278,9 +291,6 @@ static void verify_sub(int count)
 	for (int i = 0; i < count; i++) {
 		double d1 = gen_float(307);
 		double d2 = gen_float(307);
-		double prec = 1E-15;
-		if (signbit(d1) == signbit(d2))
-			prec = 1E-14;
 
 		tt_dec_from_float(dec1, d1);
 		tt_dec_from_float(dec2, d2);
@@ -300,6 +310,7 @@ static void verify_sub(int count)
 		tt_dec_to_float(dec1, &vd2);
 
 		double ds = d1 - d2;
+		double prec = cancel_prec(d1, d2, ds);
 		if (!deq(vd1, ds, prec) || !deq(-vd2, ds, prec)) {
 			tt_warn("Float sub mismatch: %.18E - %.18E\n"
 					"Mach: %.18E\nDEC:  %.18E\nDEC:  %.18E",
@@ -649,6 +660,938 @@ struct tt_dec *factorial(int i, int j)
 	return dec;
 }
 
+/* Random integer string of 1 ~ digs digits, biased to runs of 0 and 9 */
+static void gen_digits(char *s, int digs)
+{
+	int len = rand() % digs + 1;
+
+	for (int i = 0; i < len; i++) {
+		int r = rand() % 4;
+		s[i] = r == 0 ? '0' : r == 1 ? '9' : '0' + rand() % 10;
+	}
+	if (s[0] == '0')
+		s[0] = '1';
+	s[len] = '\0';
+}
+
+/* Compare exact integer results against tt_int, crossing word boundaries */
+static void verify_exact(int count, const int digs)
+{
+	char s1[digs+1], s2[digs+1], s[digs*2+16], *si = NULL;
+
+	int old_level = tt_log_set_level(TT_LOG_WARN);
+	printf("Exact big number, %d digits...\n", digs);
+	struct tt_dec *dec1 = tt_dec_alloc(digs*2);
+	struct tt_dec *dec2 = tt_dec_alloc(digs*2);
+	struct tt_dec *dec3 = tt_dec_alloc(digs*2);
+	struct tt_int *ti1 = tt_int_alloc(), *ti2 = tt_int_alloc();
+	struct tt_int *ti3 = tt_int_alloc();
+
+	for (int i = 0; i < count; i++) {
+		gen_digits(s1, digs);
+		gen_digits(s2, digs);
+		tt_dec_from_string(dec1, s1);
+		tt_dec_from_string(dec2, s2);
+		tt_int_from_string(ti1, s1);
+		tt_int_from_string(ti2, s2);
+
+		const int op = i % 4;
+		switch (op) {
+		case 0:
+			assert(tt_dec_add(dec3, dec1, dec2) == 0);
+			tt_int_add(ti3, ti1, ti2);
+			break;
+		case 1:
+			assert(tt_dec_sub(dec3, dec1, dec2) == 0);
+			tt_int_sub(ti3, ti1, ti2);
+			break;
+		case 2:
+			assert(tt_dec_mul(dec3, dec1, dec2) == 0);
+			tt_int_mul(ti3, ti1, ti2);
+			break;
+		default:
+			/* (s1 * s2) / s2 == s1 */
+			tt_dec_mul(dec3, dec1, dec2);
+			assert(tt_dec_div(dec3, dec3, dec2) == 0);
+			tt_int_from_string(ti3, s1);
+			break;
+		}
+		assert(_tt_dec_sanity(dec3) == 0);
+
+		/* Division may leave trailing zeros in exponent */
+		tt_dec_to_string(dec3, s, sizeof(s));
+		tt_int_to_string(ti3, &si, 10);
+		tt_dec_from_string(dec1, si);
+		if (tt_dec_cmp(dec3, dec1)) {
+			tt_error("Exact op %d mismatch: %s, %s\nDEC: %s\n"
+					"INT: %s", op, s1, s2, s, si);
+			abort();
+		}
+		free(si);
+		si = NULL;
+	}
+
+	tt_dec_free(dec1);
+	tt_dec_free(dec2);
+	tt_dec_free(dec3);
+	tt_int_free(ti1);
+	tt_int_free(ti2);
+	tt_int_free(ti3);
+	tt_log_set_level(old_level);
+}
+
+/* Running sums with destination aliasing a source
+ * - results must match non-aliased operations
+ * - once scratch has grown, aliased ops allocate nothing ("make STATS=1")
+ */
+static void verify_inplace(int count, const int digs)
+{
+	char s1[digs+1];
+	struct tt_stats st;
+
+	int old_level = tt_log_set_level(TT_LOG_WARN);
+	printf("In place ops, %d digits...\n", digs);
+	struct tt_dec *acc = tt_dec_alloc(digs*2);
+	struct tt_dec *ref = tt_dec_alloc(digs*2);
+	struct tt_dec *tmp = tt_dec_alloc(digs*2);
+	struct tt_dec *x = tt_dec_alloc(digs*2);
+
+	/* Warm up scratch, mul and div need most with operands of full size */
+	char sw[digs*2+1];
+	memset(sw, '7', digs*2);
+	sw[digs*2] = '\0';
+	tt_dec_from_string(x, sw + digs);
+	tt_dec_from_string(acc, sw);
+	tt_dec_mul(acc, acc, x);
+	tt_dec_from_string(acc, sw);
+	tt_dec_div(acc, acc, x);
+
+	tt_dec_from_uint(acc, 1);
+	tt_dec_from_uint(ref, 1);
+	uint64_t allocs = 0;
+	for (int i = 0; i < count; i++) {
+		gen_digits(s1, digs);
+		tt_dec_from_string(x, s1);
+
+		int (*op)(struct tt_dec *, const struct tt_dec *,
+				const struct tt_dec *);
+		op = i % 4 == 0 ? tt_dec_add : i % 4 == 1 ? tt_dec_sub :
+			i % 4 == 2 ? tt_dec_mul : tt_dec_div;
+
+		/* May return TT_APN_EROUNDED */
+		tt_stats_snapshot(&st);
+		const uint64_t calls = st.stat[TT_STAT_DEC_ALLOC].calls;
+		const int ret = op(acc, acc, x);
+		tt_stats_snapshot(&st);
+		allocs += st.stat[TT_STAT_DEC_ALLOC].calls - calls;
+
+		assert(ret >= 0 && op(tmp, ref, x) == ret);
+		struct tt_dec *t = ref;
+		ref = tmp;
+		tmp = t;
+		assert(_tt_dec_sanity(acc) == 0);
+		assert(tt_dec_cmp(acc, ref) == 0);
+	}
+	assert(allocs == 0);
+
+	/* Both sources alias destination */
+	assert(tt_dec_add(acc, acc, acc) >= 0);
+	assert(tt_dec_add(tmp, ref, ref) >= 0);
+	assert(tt_dec_cmp(acc, tmp) == 0);
+	assert(tt_dec_mul(acc, acc, acc) >= 0);
+	assert(tt_dec_mul(tmp, tmp, tmp) >= 0);
+	assert(tt_dec_cmp(acc, tmp) == 0);
+	assert(tt_dec_sub(acc, acc, acc) == 0);
+	assert(_tt_dec_is_zero(acc));
+
+	tt_dec_free(acc);
+	tt_dec_free(ref);
+	tt_dec_free(tmp);
+	tt_dec_free(x);
+	tt_log_set_level(old_level);
+}
+
+/* IEEE 754-2008 decimal interchange encoding */
+/* String syntax, round trip, length delimited parsing */
+static void verify_string(int count)
+{
+	static const struct {
+		const char *in, *out;
+	} vec[] = {
+		{ "+123", "123" }, { "0.00", "0.00" }, { "1.2345e+3", "1234.5" },
+		{ "12.E+7", "1.2E+8" }, { "-.23E-12", "-2.3E-13" },
+		{ "0.001234567", "0.001234567" }, { "-0E-7", "-0E-7" },
+		{ "00000000000000000000001.5", "1.5" }, { "-nAn", "-NaN" },
+		{ "inf", "Inf" }, { "123456789012345678901234567891.5",
+			"123456789012345678901234567892" },
+		{ "-", NULL }, { "+E1", NULL }, { ".", NULL }, { ".E12", NULL },
+		{ "1.2E3.", NULL }, { "-3#5", NULL }, { "3E", NULL },
+		{ "3E+", NULL }, { "1.1.E1", NULL }, { "infinity", NULL },
+		{ "1E99999999999", NULL }, { "", NULL },
+	};
+
+	printf("String...\n");
+	int old_level = tt_log_set_level(TT_LOG_WARN);
+	struct tt_dec *dec = tt_dec_alloc(30);
+	struct tt_dec *dec2 = tt_dec_alloc(30);
+	char s[128], s2[128];
+
+	for (int i = 0; i < sizeof(vec) / sizeof(vec[0]); i++) {
+		const int ret = tt_dec_from_string(dec, vec[i].in);
+		if (vec[i].out == NULL) {
+			assert(ret == TT_EINVAL);
+			continue;
+		}
+		assert(ret >= 0);
+		tt_dec_to_string(dec, s, sizeof(s));
+		assert(strcmp(s, vec[i].out) == 0);
+	}
+
+	/* Random digits, point and exponent, parsed within a longer buffer */
+	for (int i = 0; i < count; i++) {
+		int len = 0;
+		if (rand() % 2)
+			s[len++] = '-';
+		const int digs = rand() % 30 + 1;
+		const int pt = rand() % (digs + 1);
+		for (int j = 0; j < digs; j++) {
+			if (j == pt && rand() % 2)
+				s[len++] = '.';
+			s[len++] = '0' + rand() % 10;
+		}
+		if (rand() % 2)
+			len += sprintf(s + len, "E%d", rand() % 200 - 100);
+		memcpy(s2, s, len);
+		strcpy(s + len, "123E5");
+
+		assert(tt_dec_from_strn(dec, s, len) == 0);
+		assert(_tt_dec_sanity(dec) == 0);
+		s2[len] = '\0';
+		assert(tt_dec_from_string(dec2, s2) == 0);
+		assert(tt_dec_cmp(dec, dec2) == 0);
+
+		/* to_string then from_string gives identical string */
+		tt_dec_to_string(dec, s, sizeof(s));
+		tt_dec_from_string(dec2, s);
+		tt_dec_to_string(dec2, s2, sizeof(s2));
+		assert(strcmp(s, s2) == 0);
+	}
+
+	tt_dec_free(dec);
+	tt_dec_free(dec2);
+	tt_log_set_level(old_level);
+}
+
+/* Chunked parsing and file loading of a long number */
+static void verify_stream(void)
+{
+	const int digs = 20000;
+	char *s = malloc(digs + 32), o[64];
+
+	printf("Stream...\n");
+	int old_level = tt_log_set_level(TT_LOG_WARN);
+	struct tt_dec *dec = tt_dec_alloc(digs);
+	struct tt_dec *dec2 = tt_dec_alloc(digs);
+
+	/* Random chunks, longer and shorter than precision */
+	for (int i = 0; i < 20; i++) {
+		int len = sprintf(s, "-000");
+		const int n = digs - 10 + rand() % 20;
+		for (int j = 0; j < n; j++)
+			s[len++] = j == n / 3 ? '.' : '0' + rand() % 10;
+		len += sprintf(s + len, "E-%d", rand() % 1000);
+
+		struct tt_dec_parser *ps = tt_dec_parser_alloc(dec);
+		for (int pos = 0, n; pos < len; pos += n) {
+			n = rand() % (i % 2 ? 30 : 3000) + 1;
+			if (n > len - pos)
+				n = len - pos;
+			assert(tt_dec_parser_feed(ps, s + pos, n) == 0);
+		}
+		const int ret = tt_dec_parser_finish(ps);
+		tt_dec_parser_free(ps);
+
+		assert(ret == tt_dec_from_string(dec2, s));
+		assert(_tt_dec_sanity(dec) == 0);
+		assert(tt_dec_cmp(dec, dec2) == 0);
+	}
+
+	/* Split words, trailing white space, invalid input */
+	static const char *chunks[][3] = {
+		{ "-N", "a", "N" }, { "in", "F\n", "" }, { "1.", "5e", "-3 \n" },
+		{ "12", "x", "" }, { "1", "e", "" }, { "nan", "1", "" },
+		{ "1 ", " 2", "" }, { "-", "", "" },
+	};
+	static const char *res[] = {
+		"-NaN", "Inf", "0.0015", NULL, NULL, NULL, NULL, NULL,
+	};
+	for (int i = 0; i < sizeof(chunks) / sizeof(chunks[0]); i++) {
+		struct tt_dec_parser *ps = tt_dec_parser_alloc(dec2);
+		for (int j = 0; j < 3; j++)
+			tt_dec_parser_feed(ps, chunks[i][j], strlen(chunks[i][j]));
+		const int ret = tt_dec_parser_finish(ps);
+		tt_dec_parser_free(ps);
+		if (res[i] == NULL) {
+			assert(ret == TT_EINVAL);
+			continue;
+		}
+		assert(ret == 0);
+		tt_dec_to_string(dec2, o, sizeof(o));
+		assert(strcmp(o, res[i]) == 0);
+	}
+
+	/* Regular file is mapped, pipe is read */
+	FILE *f = tmpfile();
+	tt_dec_to_string(dec, s, digs + 32);
+	fprintf(f, "%s\n", s);
+	fflush(f);
+	rewind(f);
+	assert(tt_dec_from_fd(dec2, fileno(f)) == 0);
+	assert(tt_dec_cmp(dec, dec2) == 0);
+	fclose(f);
+
+	int fds[2];
+	assert(pipe(fds) == 0);
+	assert(write(fds[1], "+12.50E3\n", 9) == 9);
+	close(fds[1]);
+	assert(tt_dec_from_fd(dec2, fds[0]) == 0);
+	close(fds[0]);
+	tt_dec_to_string(dec2, o, sizeof(o));
+	assert(strcmp(o, "1.250E+4") == 0);
+
+	free(s);
+	tt_dec_free(dec);
+	tt_dec_free(dec2);
+	tt_log_set_level(old_level);
+}
+
+/* Round 2.5 and 3.5 to one digit with rounding of thread context */
+static void *ctx_thread(void *arg)
+{
+	const int *r = arg;
+	struct tt_dec *x = tt_dec_alloc(0), *z = tt_dec_alloc(0);
+	struct tt_dec *y = tt_dec_alloc(0), *e = tt_dec_alloc(0);
+	struct tt_dec_ctx *ctx = tt_dec_ctx();
+	char s[8];
+
+	ctx->prec = 1;
+	ctx->rounding = r[0];
+	ctx->traps = 0;
+	tt_dec_from_uint(z, 0);
+	for (int i = 0; i < 20000; i++) {
+		sprintf(s, "%d.5", 2 + i % 2);
+		tt_dec_from_string(x, s);
+		tt_dec_from_uint(e, r[1 + i % 2]);
+		assert(tt_dec_add_ctx(y, x, z, NULL) == 0);
+		assert(tt_dec_cmp(y, e) == 0);
+	}
+	assert(ctx->flags == TT_DEC_F_ROUNDED);
+
+	tt_dec_free(x);
+	tt_dec_free(y);
+	tt_dec_free(z);
+	tt_dec_free(e);
+	return NULL;
+}
+
+/* Context precision, rounding, traps, flags, and per thread rounding */
+static void verify_ctx(void)
+{
+	printf("Context...\n");
+	int old_level = tt_log_set_level(TT_LOG_WARN);
+	struct tt_dec *a = tt_dec_alloc(30), *b = tt_dec_alloc(30);
+	struct tt_dec *c = tt_dec_alloc(30), *e = tt_dec_alloc(30);
+	struct tt_dec_ctx ctx = { .prec = 5, .rounding = TT_ROUND_DOWN };
+
+	/* 1.23456 + 0.00009 = 1.23465 */
+	tt_dec_from_string(a, "1.23456");
+	tt_dec_from_string(b, "0.00009");
+	assert(tt_dec_add_ctx(c, a, b, &ctx) == 0);
+	tt_dec_from_string(e, "1.2346");
+	assert(tt_dec_cmp(c, e) == 0);
+	ctx.rounding = TT_ROUND_HALF_AWAY0;
+	ctx.traps = TT_DEC_F_ROUNDED;
+	assert(tt_dec_add_ctx(c, a, b, &ctx) == TT_APN_EROUNDED);
+	tt_dec_from_string(e, "1.2347");
+	assert(tt_dec_cmp(c, e) == 0);
+	assert(ctx.flags == TT_DEC_F_ROUNDED);
+
+	/* Full precision of destination if context is wider */
+	ctx.prec = 100;
+	assert(tt_dec_mul_ctx(c, a, b, &ctx) == 0);
+	tt_dec_from_string(e, "0.0001111104");
+	assert(tt_dec_cmp(c, e) == 0);
+
+	/* Untrapped division by zero and 0 / 0 */
+	ctx.flags = ctx.traps = 0;
+	tt_dec_from_uint(b, 0);
+	assert(tt_dec_div_ctx(c, a, b, &ctx) == 0);
+	assert(c->_inf_nan == TT_DEC_INF);
+	assert(tt_dec_div_ctx(c, b, b, &ctx) == 0);
+	assert(c->_inf_nan == TT_DEC_NAN);
+	assert(ctx.flags == (TT_DEC_F_DIV_0 | TT_DEC_F_INVALID));
+	ctx.traps = TT_DEC_F_ALL;
+	assert(tt_dec_div_ctx(c, a, b, &ctx) == TT_APN_EDIV_0);
+
+	/* Operands wider than context, rounded once, near half way decided by
+	 * exact result
+	 */
+	static const struct {
+		char op;
+		int prec, rnd;
+		const char *a, *b, *r;
+	} wide[] = {
+		{ '+', 3, TT_ROUND_HALF_EVEN, "910854E9", "37661E10", "1.29E+15" },
+		{ '+', 1, TT_ROUND_HALF_EVEN, "2629E4", "2E-12", "3E+7" },
+		{ '+', 10, TT_ROUND_HALF_EVEN, "-1E1", "4038912111111E-12",
+			"-5.961087889" },
+		{ '+', 2, TT_ROUND_HALF_EVEN, "1.25", "1E-30", "1.3" },
+		{ '+', 2, TT_ROUND_HALF_EVEN, "-1.25", "1E-30", "-1.2" },
+		{ '-', 2, TT_ROUND_HALF_AWAY0, "1.35", "1E-22", "1.3" },
+		{ '*', 3, TT_ROUND_DOWN, "1.0000000000001", "1.245", "1.25" },
+		{ '/', 2, TT_ROUND_HALF_AWAY0, "5", "4.0000000000000000000001",
+			"1.2" },
+	};
+	ctx.flags = ctx.traps = 0;
+	for (int i = 0; i < sizeof(wide) / sizeof(wide[0]); i++) {
+		ctx.prec = wide[i].prec;
+		ctx.rounding = wide[i].rnd;
+		tt_dec_from_string(a, wide[i].a);
+		tt_dec_from_string(b, wide[i].b);
+		tt_dec_from_string(e, wide[i].r);
+		int (*op)(struct tt_dec *, const struct tt_dec *,
+				const struct tt_dec *, struct tt_dec_ctx *) =
+			wide[i].op == '+' ? tt_dec_add_ctx :
+			wide[i].op == '-' ? tt_dec_sub_ctx :
+			wide[i].op == '*' ? tt_dec_mul_ctx : tt_dec_div_ctx;
+
+		assert(op(c, a, b, &ctx) == 0 && _tt_dec_sanity(c) == 0);
+		assert(tt_dec_cmp(c, e) == 0);
+		assert(op(a, a, b, &ctx) == 0 && tt_dec_cmp(a, e) == 0);
+	}
+	assert(ctx.flags == TT_DEC_F_ROUNDED);
+	ctx.traps = TT_DEC_F_ALL;
+
+	/* Threads rounding differently at the same time */
+	static int rnd[3][3] = {
+		{ TT_ROUND_HALF_EVEN, 2, 4 },
+		{ TT_ROUND_HALF_AWAY0, 3, 4 },
+		{ TT_ROUND_DOWN, 2, 3 },
+	};
+	pthread_t tid[3];
+	for (int i = 0; i < 3; i++)
+		assert(pthread_create(&tid[i], NULL, ctx_thread, rnd[i]) == 0);
+	for (int i = 0; i < 3; i++)
+		pthread_join(tid[i], NULL);
+	assert(tt_dec_ctx()->prec == 0 && tt_dec_ctx()->flags == 0);
+
+	tt_dec_free(a);
+	tt_dec_free(b);
+	tt_dec_free(c);
+	tt_dec_free(e);
+	tt_log_set_level(old_level);
+}
+
+struct func_vec {
+	char op;	/* sqrt, exp, ln, log10 (g), pow */
+	const char *x, *y, *r;
+};
+
+/* r = op(x, y), e = expected */
+static int func_run(const struct func_vec *v, struct tt_dec *r,
+		struct tt_dec *x, struct tt_dec *y, struct tt_dec *e)
+{
+	tt_dec_from_string(x, v->x);
+	if (v->y)
+		tt_dec_from_string(y, v->y);
+	tt_dec_from_string(e, v->r);
+
+	switch (v->op) {
+	case 's':
+		return tt_dec_sqrt(r, x);
+	case 'e':
+		return tt_dec_exp(r, x);
+	case 'l':
+		return tt_dec_ln(r, x);
+	case 'g':
+		return tt_dec_log10(r, x);
+	default:
+		return tt_dec_pow(r, x, y);
+	}
+}
+
+/* Elementary functions against 40 digit values, exact and special cases */
+static void verify_func(void)
+{
+	static const struct func_vec vec[] = {
+		{ 's', "2", 0, "1.414213562373095048801688724209698078570" },
+		{ 's', "0.0123", 0, "0.1109053650640941716205160010260993291846" },
+		{ 'e', "1", 0, "2.718281828459045235360287471352662497757" },
+		{ 'e', "-123.456", 0,
+			"2.419582541264600766134751746950674065445E-54" },
+		{ 'e', "1E-30", 0, "1.000000000000000000000000000001000000000" },
+		{ 'l', "2", 0, "0.6931471805599453094172321214581765680755" },
+		{ 'l', "1.0000000001", 0,
+			"9.999999999500000000033333333330833333334E-11" },
+		{ 'l', "1E-500", 0, "-1151.292546497022842008995727342182103801" },
+		{ 'g', "2", 0, "0.3010299956639811952137388947244930267682" },
+		{ 'g', "123456789", 0, "8.091514977169270447518333623059547258515" },
+		{ 'p', "1.5", "2.5", "2.755675960631075360471944584044127815962" },
+		{ 'p', "3", "-5", "0.004115226337448559670781893004115226337449" },
+		{ 'p', "0.98", "1000",
+			"1.682967357215955633879535961016367368730E-9" },
+	};
+	static const struct func_vec exact[] = {
+		{ 's', "2.25", 0, "1.5" },
+		{ 's', "1E-30", 0, "1E-15" },
+		{ 'e', "0", 0, "1" },
+		{ 'l', "1.000", 0, "0" },
+		{ 'g', "0.001", 0, "-3" },
+		{ 'p', "2", "-3", "0.125" },
+		{ 'p', "-3", "3", "-27" },
+		{ 'p', "7", "0", "1" },
+	};
+
+	printf("Elementary functions...\n");
+	int old_level = tt_log_set_level(TT_LOG_WARN);
+	struct tt_dec *x = tt_dec_alloc(40), *y = tt_dec_alloc(40);
+	struct tt_dec *r = tt_dec_alloc(40), *e = tt_dec_alloc(40);
+
+	for (int i = 0; i < sizeof(vec) / sizeof(vec[0]); i++) {
+		assert(func_run(&vec[i], r, x, y, e) == TT_APN_EROUNDED);
+		assert(_tt_dec_sanity(r) == 0);
+		assert(tt_dec_cmp(r, e) == 0);
+	}
+	for (int i = 0; i < sizeof(exact) / sizeof(exact[0]); i++) {
+		assert(func_run(&exact[i], r, x, y, e) == 0);
+		assert(tt_dec_cmp(r, e) == 0);
+	}
+
+	/* Newton square root and e^(ln(x)/2) round to the same value */
+	struct tt_dec *r2 = tt_dec_alloc(300);
+	tt_dec_free(r);
+	r = tt_dec_alloc(300);
+	tt_dec_from_uint(x, 2);
+	tt_dec_from_string(y, "0.5");
+	assert(tt_dec_sqrt(r, x) == TT_APN_EROUNDED);
+	assert(tt_dec_pow(r2, x, y) == TT_APN_EROUNDED);
+	assert(tt_dec_cmp(r, r2) == 0);
+	tt_dec_free(r2);
+
+	/* Special values */
+	tt_dec_from_sint(x, -1);
+	assert(tt_dec_sqrt(r, x) == TT_APN_EINVAL && r->_inf_nan == TT_DEC_NAN);
+	assert(tt_dec_ln(r, x) == TT_APN_EINVAL && r->_inf_nan == TT_DEC_NAN);
+	assert(tt_dec_pow(r, x, y) == TT_APN_EINVAL);
+	tt_dec_from_uint(x, 0);
+	assert(tt_dec_ln(r, x) == TT_APN_EDIV_0 && r->_inf_nan == TT_DEC_INF);
+	tt_dec_from_sint(y, -1);
+	assert(tt_dec_pow(r, x, y) == TT_APN_EDIV_0);
+	tt_dec_from_string(x, "1E10");
+	assert(tt_dec_exp(r, x) == TT_APN_EOVERFLOW &&
+			r->_inf_nan == TT_DEC_INF);
+	tt_dec_from_string(x, "-1E10");
+	assert(tt_dec_exp(r, x) == TT_APN_EUNDERFLOW && _tt_dec_is_zero(r));
+	tt_dec_from_string(x, "nan");
+	assert(tt_dec_sqrt(r, x) == TT_APN_EINVAL && r->_inf_nan == TT_DEC_NAN);
+
+	tt_dec_free(x);
+	tt_dec_free(y);
+	tt_dec_free(r);
+	tt_dec_free(e);
+	tt_log_set_level(old_level);
+}
+
+/* Quantize to exponent with each rounding method, reduce */
+static void verify_quantize(void)
+{
+	static const struct {
+		const char *x;
+		int exp, rnd, ret;
+		const char *r;
+	} vec[] = {
+		{ "1.235", -2, TT_ROUND_HALF_EVEN, TT_APN_EROUNDED, "1.24" },
+		{ "1.225", -2, TT_ROUND_HALF_EVEN, TT_APN_EROUNDED, "1.22" },
+		{ "1.225", -2, TT_ROUND_HALF_AWAY0, TT_APN_EROUNDED, "1.23" },
+		{ "1.225", -2, TT_ROUND_DOWN, TT_APN_EROUNDED, "1.22" },
+		{ "1.2250001", -2, TT_ROUND_DOWN, TT_APN_EROUNDED, "1.23" },
+		{ "-9.995", -2, 0, TT_APN_EROUNDED, "-10.00" },
+		{ "0.004", -2, 0, TT_APN_EROUNDED, "0.00" },
+		{ "0.006", -2, 0, TT_APN_EROUNDED, "0.01" },
+		{ "0.0006", -2, 0, TT_APN_EROUNDED, "0.00" },
+		{ "12", -3, 0, 0, "12.000" },
+		{ "1200", 2, 0, 0, "12E2" },
+		{ "0E-5", -2, 0, 0, "0.00" },
+		{ "0.1", 3, 0, TT_APN_EROUNDED, "0" },
+		{ "1", -20, 0, TT_APN_EINVAL, NULL },
+		{ "99999999999999999999.5", 0, 0, TT_APN_EINVAL, NULL },
+	};
+	static const struct {
+		const char *x, *r;
+		int ret;
+	} reduce[] = {
+		{ "1.2000", "1.2", 0 },
+		{ "-1200", "-12E2", 0 },
+		{ "0.000", "0", 0 },
+		{ "10000000000000000000000000000", "1E28", 0 },
+		{ "123456789012345678999999", "1.23456789012345679E23",
+			TT_APN_EROUNDED },
+	};
+
+	printf("Quantize...\n");
+	int old_level = tt_log_set_level(TT_LOG_WARN);
+	struct tt_dec *x = tt_dec_alloc(40), *e = tt_dec_alloc(40);
+	struct tt_dec *r = tt_dec_alloc(20);
+
+	for (int i = 0; i < sizeof(vec) / sizeof(vec[0]); i++) {
+		tt_dec_from_string(x, vec[i].x);
+		assert(tt_dec_quantize(r, x, vec[i].exp, vec[i].rnd) ==
+				vec[i].ret);
+		if (vec[i].r == NULL) {
+			assert(r->_inf_nan == TT_DEC_NAN);
+			continue;
+		}
+		tt_dec_from_string(e, vec[i].r);
+		assert(_tt_dec_sanity(r) == 0);
+		assert(tt_dec_cmp(r, e) == 0 && r->_exp == e->_exp);
+
+		/* In place, and to exponent of reference */
+		assert(tt_dec_rescale(x, x, e, vec[i].rnd) == vec[i].ret);
+		assert(tt_dec_cmp(x, e) == 0 && x->_exp == e->_exp);
+	}
+
+	for (int i = 0; i < sizeof(reduce) / sizeof(reduce[0]); i++) {
+		tt_dec_from_string(x, reduce[i].x);
+		tt_dec_from_string(e, reduce[i].r);
+		assert(tt_dec_reduce(r, x) == reduce[i].ret);
+		assert(_tt_dec_sanity(r) == 0);
+		assert(tt_dec_cmp(r, e) == 0 && r->_exp == e->_exp);
+	}
+
+	tt_dec_free(x);
+	tt_dec_free(e);
+	tt_dec_free(r);
+	tt_log_set_level(old_level);
+}
+
+/* Fused dot product and sum, b == NULL for sum */
+static void verify_dot(void)
+{
+	static const struct {
+		const char *a[3], *b[3];
+		int n, ret;
+		const char *r;
+	} vec[] = {
+		{ { "1.5", "2.25" }, { "2", "4" }, 2, 0, "12.00" },
+		{ { "12345678901234567890", "-0.5" }, { "3", "7" }, 2,
+			TT_APN_EROUNDED, "37037036703703703666" },
+		{ { "1.23456789", "0.1", "1E-25" }, { "-9.87654321", "0.2", "1" },
+			3, TT_APN_EROUNDED, "-12.173263111263526900" },
+		{ { "0E-10", "2" }, { "5", "3" }, 2, 0, "6" },
+		{ { "1", "1E-30" }, { NULL }, 2, TT_APN_EROUNDED,
+			"1.0000000000000000000" },
+		{ { "1E100000", "1", "-1E100000" }, { NULL }, 3, 0, "1" },
+		{ { "1E70000", "0.1", "-0.1" }, { NULL }, 3, 0,
+			"1.0000000000000000000E+70000" },
+		{ { "1E70000", "0.2", "-0.1" }, { NULL }, 3, TT_APN_EROUNDED,
+			"1.0000000000000000000E+70000" },
+		{ { "1.5", "-1.50" }, { NULL }, 2, 0, "0.00" },
+		{ { "1", "-inf", "nan" }, { NULL }, 3, TT_APN_EINVAL, "NaN" },
+		{ { "1", "-inf", "inf" }, { NULL }, 3, TT_APN_EOVERFLOW, "-Inf" },
+	};
+
+	printf("Dot...\n");
+	int old_level = tt_log_set_level(TT_LOG_WARN);
+	struct tt_dec *a[3], *b[3], *r = tt_dec_alloc(20);
+	char s[64];
+
+	for (int i = 0; i < 3; i++) {
+		a[i] = tt_dec_alloc(40);
+		b[i] = tt_dec_alloc(40);
+	}
+
+	for (int i = 0; i < sizeof(vec) / sizeof(vec[0]); i++) {
+		for (int j = 0; j < vec[i].n; j++) {
+			tt_dec_from_string(a[j], vec[i].a[j]);
+			if (vec[i].b[0])
+				tt_dec_from_string(b[j], vec[i].b[j]);
+		}
+		if (vec[i].b[0])
+			assert(tt_dec_dot(r, a, b, vec[i].n) == vec[i].ret);
+		else
+			assert(tt_dec_sum(r, a, vec[i].n) == vec[i].ret);
+		assert(_tt_dec_sanity(r) == 0);
+		tt_dec_to_string(r, s, sizeof(s));
+		assert(strcmp(s, vec[i].r) == 0);
+	}
+
+	/* dst shares inputs, sum of squares */
+	tt_dec_from_string(a[0], "3");
+	tt_dec_from_string(a[1], "4");
+	assert(tt_dec_dot(a[0], a, a, 2) == 0);
+	tt_dec_to_string(a[0], s, sizeof(s));
+	assert(strcmp(s, "25") == 0);
+
+	for (int i = 0; i < 3; i++) {
+		tt_dec_free(a[i]);
+		tt_dec_free(b[i]);
+	}
+	tt_dec_free(r);
+	tt_log_set_level(old_level);
+}
+
+/* Constants against 100 digit values, rounded from cache, cross checked
+ * with elementary functions
+ */
+static void verify_const(void)
+{
+	static const struct {
+		int (*get)(struct tt_dec *dec);
+		const char *r100, *r50;
+	} vec[] = {
+		{ tt_dec_pi,
+			"3.14159265358979323846264338327950288419716939937510"
+			"5820974944592307816406286208998628034825342117068",
+			"3.1415926535897932384626433832795028841971693993751" },
+		{ tt_dec_e,
+			"2.71828182845904523536028747135266249775724709369995"
+			"9574966967627724076630353547594571382178525166427",
+			"2.7182818284590452353602874713526624977572470937000" },
+		{ tt_dec_ln2,
+			"0.69314718055994530941723212145817656807550013436025"
+			"52541206800094933936219696947156058633269964186875",
+			"0.69314718055994530941723212145817656807550013436026" },
+	};
+
+	printf("Constants...\n");
+	int old_level = tt_log_set_level(TT_LOG_WARN);
+	struct tt_dec *r = tt_dec_alloc(100), *e = tt_dec_alloc(100);
+	struct tt_dec *r50 = tt_dec_alloc(50), *e50 = tt_dec_alloc(50);
+	struct tt_dec *big = tt_dec_alloc(1000);
+
+	for (int i = 0; i < sizeof(vec) / sizeof(vec[0]); i++) {
+		tt_dec_from_string(e, vec[i].r100);
+		tt_dec_from_string(e50, vec[i].r50);
+		assert(vec[i].get(r) == TT_APN_EROUNDED);
+		assert(_tt_dec_sanity(r) == 0);
+		assert(tt_dec_cmp(r, e) == 0);
+
+		/* Lower precision after higher one is rounded from cache */
+		assert(vec[i].get(big) == TT_APN_EROUNDED);
+		assert(vec[i].get(r50) == TT_APN_EROUNDED);
+		assert(tt_dec_cmp(r50, e50) == 0);
+		assert(vec[i].get(r) == TT_APN_EROUNDED);
+		assert(tt_dec_cmp(r, e) == 0);
+	}
+
+	/* e = exp(1), ln(2) */
+	struct tt_dec *x = tt_dec_alloc(20), *r2 = tt_dec_alloc(1000);
+	tt_dec_from_uint(x, 1);
+	assert(tt_dec_exp(r2, x) == TT_APN_EROUNDED);
+	assert(tt_dec_e(big) == TT_APN_EROUNDED);
+	assert(tt_dec_cmp(r2, big) == 0);
+	tt_dec_from_uint(x, 2);
+	assert(tt_dec_ln(r2, x) == TT_APN_EROUNDED);
+	assert(tt_dec_ln2(big) == TT_APN_EROUNDED);
+	assert(tt_dec_cmp(r2, big) == 0);
+
+	tt_dec_free(x);
+	tt_dec_free(r2);
+	tt_dec_free(big);
+	tt_dec_free(r);
+	tt_dec_free(e);
+	tt_dec_free(r50);
+	tt_dec_free(e50);
+	tt_log_set_level(old_level);
+}
+
+static void verify_ieee(void)
+{
+	static const struct {
+		const char *s;
+		int fmt;
+		uint64_t lo, hi;
+	} vec[] = {
+		{ "1", TT_DEC_BID32, 0x32800001 },
+		{ "1", TT_DEC_DPD32, 0x22500001 },
+		{ "-7.50", TT_DEC_DPD32, 0xA23003D0 },
+		{ "1", TT_DEC_BID64, 0x31C0000000000001ULL },
+		{ "1", TT_DEC_DPD64, 0x2238000000000001ULL },
+		{ "9999999999999999E369", TT_DEC_BID64, 0x77FB86F26FC0FFFFULL },
+		{ "9999999999999999E369", TT_DEC_DPD64, 0x77FCFF3FCFF3FCFFULL },
+		{ "1", TT_DEC_BID128, 1, 0x3040000000000000ULL },
+		{ "1", TT_DEC_DPD128, 1, 0x2208000000000000ULL },
+		{ "-Inf", TT_DEC_DPD64, 0xF800000000000000ULL },
+	};
+
+	printf("IEEE decimal...\n");
+	struct tt_dec *dec = tt_dec_alloc(40);
+	struct tt_dec *dec2 = tt_dec_alloc(40);
+	uint64_t buf[2];
+	char s[64];
+
+	for (int i = 0; i < sizeof(vec) / sizeof(vec[0]); i++) {
+		tt_dec_from_string(dec, vec[i].s);
+		buf[0] = buf[1] = 0;
+		const int ret = tt_dec_to_ieee(dec, buf, vec[i].fmt);
+		if (ret == TT_ENOTSUP)
+			continue;	/* No 128-bit integer */
+		assert(ret == 0);
+		if (vec[i].fmt % 3 == 0)
+			buf[0] &= 0xFFFFFFFF;
+		assert(buf[0] == vec[i].lo && buf[1] == vec[i].hi);
+		assert(tt_dec_from_ieee(dec2, buf, vec[i].fmt) == 0);
+		assert(tt_dec_cmp(dec, dec2) == 0);
+	}
+
+	/* Every declet value in both declets of decimal32, round trip */
+	for (int i = 0; i < 10000; i++) {
+		const int v = i % 1000;
+		sprintf(s, "%d%03d%03dE%d", i / 1000, v, 999 - v, i % 180 - 90);
+		tt_dec_from_string(dec, s);
+		for (int fmt = TT_DEC_BID32; fmt <= TT_DEC_DPD128; fmt++) {
+			const int ret = tt_dec_to_ieee(dec, buf, fmt);
+			if (ret == TT_ENOTSUP)
+				continue;
+			assert(ret == 0);
+			assert(tt_dec_from_ieee(dec2, buf, fmt) == 0);
+			assert(_tt_dec_sanity(dec2) == 0);
+			assert(tt_dec_cmp(dec, dec2) == 0);
+		}
+	}
+
+	/* Rounding, clamping, overflow, underflow */
+	tt_dec_from_string(dec, "12345675");
+	assert(tt_dec_to_ieee(dec, buf, TT_DEC_DPD32) == TT_APN_EROUNDED);
+	tt_dec_from_ieee(dec2, buf, TT_DEC_DPD32);
+	tt_dec_from_string(dec, "1234568E1");
+	assert(tt_dec_cmp(dec, dec2) == 0);
+	tt_dec_from_string(dec, "1E96");
+	assert(tt_dec_to_ieee(dec, buf, TT_DEC_BID32) == 0);
+	tt_dec_from_ieee(dec2, buf, TT_DEC_BID32);
+	assert(tt_dec_cmp(dec, dec2) == 0);
+	tt_dec_from_string(dec, "1E97");
+	assert(tt_dec_to_ieee(dec, buf, TT_DEC_BID32) == TT_APN_EOVERFLOW);
+	tt_dec_from_string(dec, "1E-101");
+	assert(tt_dec_to_ieee(dec, buf, TT_DEC_BID32) == 0);
+	tt_dec_from_string(dec, "1E-103");
+	assert(tt_dec_to_ieee(dec, buf, TT_DEC_BID32) == TT_APN_EUNDERFLOW);
+
+	/* "5" followed by non zero digits rounds up, exact half to even */
+	static const char *const half[][2] = {
+		{ "1.23456850001", "1.234569" },
+		{ "1.2345685", "1.234568" },
+		{ "1234567890123456789012345645000001",
+			"123456789012345678901234565E7" },
+		{ "1234567890123456789012345645000000",
+			"123456789012345678901234564E7" },
+	};
+	struct tt_dec *dec27 = tt_dec_alloc(27);
+	for (int i = 0; i < 2; i++) {
+		tt_dec_from_string(dec, half[i][0]);
+		assert(tt_dec_to_ieee(dec, buf, TT_DEC_DPD32) ==
+				TT_APN_EROUNDED);
+		tt_dec_from_ieee(dec2, buf, TT_DEC_DPD32);
+		tt_dec_from_string(dec, half[i][1]);
+		assert(tt_dec_cmp(dec, dec2) == 0);
+	}
+	for (int i = 2; i < 4; i++) {
+		tt_dec_from_string(dec, half[i][0]);
+		if (tt_dec_to_ieee(dec, buf, TT_DEC_BID128) == TT_ENOTSUP)
+			break;
+		assert(tt_dec_from_ieee(dec27, buf, TT_DEC_BID128) ==
+				TT_APN_EROUNDED);
+		tt_dec_from_string(dec, half[i][1]);
+		assert(tt_dec_cmp(dec, dec27) == 0);
+	}
+	tt_dec_free(dec27);
+
+	tt_dec_free(dec);
+	tt_dec_free(dec2);
+}
+
+#ifdef __STDC_IEC_559__
+/* Shortest round trip from double, correctly rounded to double */
+static void verify_float(int count)
+{
+	static const struct {
+		double d;
+		const char *s;
+	} shortest[] = {
+		{ 0.1, "0.1" },
+		{ 123.456, "123.456" },
+		{ 1E23, "1E+23" },
+		{ 5E-324, "5E-324" },
+		{ 2.2250738585072014E-308, "2.2250738585072014E-308" },
+		{ 1.7976931348623157E308, "1.7976931348623157E+308" },
+		{ 9007199254740991.0, "9007199254740991" },
+		{ -2.5, "-2.5" },
+	};
+	static const char *to_float[] = {
+		"9007199254740993",	/* Tie, to even */
+		"9007199254740995",
+		"2.4703282292062328E-324",
+		"1.7976931348623158E308",
+		"4.9406564584124654417656879286822137236505980E-324",
+		"8.98846567431158E307",
+		"1.00000000000000011102230246251565404236316680908203125",
+		"1.00000000000000011102230246251565404236316680908203124",
+		"1.00000000000000011102230246251565404236316680908203126",
+		"7.2057594037927933E16",
+	};
+
+	printf("Float conversion...\n");
+	int old_level = tt_log_set_level(TT_LOG_ERROR);
+	struct tt_dec *dec = tt_dec_alloc(0);
+	char s[64];
+	double d;
+
+	for (int i = 0; i < sizeof(shortest) / sizeof(shortest[0]); i++) {
+		tt_dec_from_float(dec, shortest[i].d);
+		tt_dec_to_string(dec, s, sizeof(s));
+		if (strcmp(s, shortest[i].s)) {
+			tt_error("%.17g: %s != %s", shortest[i].d, s,
+					shortest[i].s);
+			abort();
+		}
+	}
+
+	for (int i = 0; i < sizeof(to_float) / sizeof(to_float[0]); i++) {
+		tt_dec_from_string(dec, to_float[i]);
+		assert(tt_dec_to_float(dec, &d) == 0);
+		assert(d == strtod(to_float[i], NULL));
+	}
+	tt_dec_from_string(dec, "1.7976931348623159E308");
+	assert(tt_dec_to_float(dec, &d) == TT_APN_EOVERFLOW && isinf(d));
+	tt_dec_from_string(dec, "-2.4703282292062327E-324");
+	assert(tt_dec_to_float(dec, &d) == TT_APN_EUNDERFLOW && d == 0);
+
+	/* Random bits round trip in at most 17 digits */
+	for (int i = 0; i < count; i++) {
+		union {
+			uint64_t i;
+			double d;
+		} v;
+		v.i = (uint64_t)rand() << 42 ^ (uint64_t)rand() << 21 ^ rand();
+		if (i & 1)
+			v.i ^= (uint64_t)rand() << 62;
+		if (!isfinite(v.d))
+			continue;
+
+		tt_dec_from_float(dec, v.d);
+		assert(_tt_dec_sanity(dec) == 0);
+		assert(dec->_msb <= 17);
+		assert(tt_dec_to_float(dec, &d) == 0 || v.d == 0);
+		assert(d == v.d);
+		tt_dec_to_string(dec, s, sizeof(s));
+		assert(strtod(s, NULL) == v.d);
+	}
+
+	tt_dec_free(dec);
+	tt_log_set_level(old_level);
+}
+#endif
+
 int main(void)
 {
 #if 0
@@ -778,6 +1721,36 @@ int main(void)
 	verify_mul(count);
 	verify_div(count);
 	verify_cmp(count);
+	verify_exact(count / 10, 19);
+	verify_exact(count / 10, 200);
+	verify_inplace(count / 10, 30);
+	verify_string(count);
+	verify_stream();
+	verify_ctx();
+	verify_quantize();
+	verify_dot();
+	verify_func();
+	verify_const();
+	verify_ieee();
+#ifdef __STDC_IEC_559__
+	verify_float(count);
+#endif
+
+	/* Force Karatsuba, then NTT multiplication and Newton division on
+	 * small operands
+	 */
+	struct tt_param param, saved;
+	tt_param_get(&saved);
+	param = saved;
+	param.dec_kara_cross = 4;
+	param.dec_ntt_cross = 1 << 30;
+	param.dec_newton_cross = 2;
+	assert(tt_param_set(&param) == 0);
+	verify_exact(count / 100, 2000);
+	param.dec_ntt_cross = 4;
+	assert(tt_param_set(&param) == 0);
+	verify_exact(count / 100, 2000);
+	tt_param_set(&saved);
 
 	return 0;
 }
@@ -4,6 +4,8 @@
  */
 #include <tt/tt.h>
 #include <tt/apn/integer.h>
+#include <tt/common/param.h>
+#include <tt/common/stats.h>
 #include <apn/integer/integer.h>
 
 #include <math.h>
@@ -244,6 +246,126 @@ static void verify_mul_div(int count)
 	tt_int_free(r);
 }
 
+static void verify_logic(int count)
+{
+	printf("Bitwise...\n");
+
+	struct tt_int *a = tt_int_alloc();
+	struct tt_int *b = tt_int_alloc();
+	struct tt_int *t1 = tt_int_alloc();
+	struct tt_int *t2 = tt_int_alloc();
+	struct tt_int *t3 = tt_int_alloc();
+
+	for (int i = 1; i <= count; i++) {
+		int ret, radix;
+		char *str;
+
+		/* Generate a, b */
+		str = gen_int_str(&radix);
+		tt_int_from_string(a, str);
+		free(str);
+		str = gen_int_str(&radix);
+		tt_int_from_string(b, str);
+		free(str);
+
+		/* (a | b) + (a & b) == a + b */
+		ret = tt_int_or(t1, a, b);
+		assert(ret == 0 && _tt_int_sanity(t1) == 0);
+		ret = tt_int_and(t2, a, b);
+		assert(ret == 0 && _tt_int_sanity(t2) == 0);
+		tt_int_add(t3, t1, t2);
+		tt_int_add(t1, a, b);
+		if (tt_int_cmp(t1, t3)) {
+			tt_error("and/or mismatch");
+			break;
+		}
+
+		/* (a ^ b) + 2 * (a & b) == a + b */
+		ret = tt_int_xor(t3, a, b);
+		assert(ret == 0 && _tt_int_sanity(t3) == 0);
+		tt_int_add(t3, t3, t2);
+		tt_int_add(t3, t3, t2);
+		if (tt_int_cmp(t1, t3)) {
+			tt_error("xor mismatch");
+			break;
+		}
+
+		/* ~~a == a, ~a + a == -1 */
+		ret = tt_int_not(t1, a);
+		assert(ret == 0 && _tt_int_sanity(t1) == 0);
+		tt_int_add(t3, t1, a);
+		tt_int_not(t1, t1);
+		if (tt_int_cmp(t1, a) || tt_int_popcount(t3) >= 0 ||
+				tt_int_scan0(t3, 0) != -1) {
+			tt_error("not mismatch");
+			break;
+		}
+
+		/* Bit operations against a & b */
+		const int bit = rand() % (a->msb * _tt_word_bits + 64);
+		_tt_int_copy(t1, a);
+		tt_int_flip_bit(t1, bit);
+		if (tt_int_test_bit(t1, bit) == tt_int_test_bit(a, bit) ||
+				_tt_int_sanity(t1)) {
+			tt_error("flip bit mismatch");
+			break;
+		}
+		tt_int_flip_bit(t1, bit);
+		tt_int_set_bit(t2, bit);
+		tt_int_clr_bit(t3, bit);
+		if (tt_int_cmp(t1, a) || !tt_int_test_bit(t2, bit) ||
+				tt_int_test_bit(t3, bit)) {
+			tt_error("bit mismatch");
+			break;
+		}
+		tt_int_and(t2, a, b);
+		if (tt_int_test_bit(t2, bit) !=
+				(tt_int_test_bit(a, bit) & tt_int_test_bit(b, bit))) {
+			tt_error("test bit mismatch");
+			break;
+		}
+		const int s1 = tt_int_scan1(a, bit);
+		if (s1 >= 0 && (!tt_int_test_bit(a, s1) ||
+					(s1 > bit && tt_int_test_bit(a, s1-1)))) {
+			tt_error("scan mismatch");
+			break;
+		}
+	}
+
+	/* Carry and borrow across zero and all ones low words
+	 * - x = 2^(2 * word bits), m = x - 1
+	 */
+	struct tt_int *x = tt_int_alloc(), *m = tt_int_alloc();
+	tt_int_from_uint(x, 1);
+	tt_int_shift(x, _tt_word_bits * 2);
+	tt_int_from_uint(t1, 1);
+	tt_int_sub(m, x, t1);
+	x->sign = 1;
+
+	/* ~(-x) == m, ~m == -x */
+	assert(tt_int_not(t1, x) == 0 && _tt_int_sanity(t1) == 0);
+	assert(tt_int_cmp(t1, m) == 0);
+	assert(tt_int_not(t1, m) == 0 && _tt_int_sanity(t1) == 0);
+	assert(tt_int_cmp(t1, x) == 0);
+
+	/* set_bit(-x, 0) == -m, clr_bit(-m, 0) == -x */
+	_tt_int_copy(t1, x);
+	assert(tt_int_set_bit(t1, 0) == 0 && _tt_int_sanity(t1) == 0);
+	m->sign = 1;
+	assert(tt_int_cmp(t1, m) == 0);
+	assert(tt_int_clr_bit(t1, 0) == 0 && _tt_int_sanity(t1) == 0);
+	assert(tt_int_cmp(t1, x) == 0);
+
+	tt_int_free(x);
+	tt_int_free(m);
+
+	tt_int_free(a);
+	tt_int_free(b);
+	tt_int_free(t1);
+	tt_int_free(t2);
+	tt_int_free(t3);
+}
+
 struct tt_int *rand_int(int msb)
 {
 	struct tt_int *ti = tt_int_alloc();
@@ -273,6 +395,437 @@ struct tt_int *rand_int(int msb)
 	return ti;
 }
 
+static void verify_addmul(int count)
+{
+	printf("Addmul & Word ops...\n");
+
+	struct tt_int *d = tt_int_alloc();
+	struct tt_int *t = tt_int_alloc();
+	struct tt_int *u = tt_int_alloc();
+
+	for (int i = 0; i < count; i++) {
+		int ret;
+		struct tt_int *a = rand_int(rand() % 40 + 1);
+		struct tt_int *b = rand_int(rand() % 40 + 1);
+		struct tt_int *c = rand_int(rand() % 80 + 1);
+		a->sign = rand() & 1;
+		b->sign = rand() & 1;
+		c->sign = rand() & 1;
+		const int sub = rand() & 1;
+		uint64_t num = ((uint64_t)rand() << 33) ^ ((uint64_t)rand() << 2) ^
+			rand();
+		if (rand() & 1)
+			num >>= rand() % 64;
+
+		/* d = c +/- a*b */
+		_tt_int_copy(d, c);
+		if (sub)
+			ret = tt_int_submul(d, a, b);
+		else
+			ret = tt_int_addmul(d, a, b);
+		assert(ret == 0 && _tt_int_sanity(d) == 0);
+		tt_int_mul(t, a, b);
+		if (sub)
+			tt_int_sub(t, c, t);
+		else
+			tt_int_add(t, c, t);
+		if (tt_int_cmp(d, t)) {
+			tt_error("addmul mismatch");
+			break;
+		}
+
+		/* a += a*a, aliased */
+		_tt_int_copy(d, a);
+		tt_int_addmul(d, d, d);
+		tt_int_mul(t, a, a);
+		tt_int_add(t, t, a);
+		if (tt_int_cmp(d, t)) {
+			tt_error("addmul alias mismatch");
+			break;
+		}
+
+		/* Word ops */
+		tt_int_from_uint(u, num);
+		tt_int_mul_ui(d, c, num);
+		tt_int_mul(t, c, u);
+		if (tt_int_cmp(d, t)) {
+			tt_error("mul_ui mismatch");
+			break;
+		}
+		_tt_int_copy(d, c);
+		tt_int_addmul_ui(d, a, num);
+		tt_int_mul(t, a, u);
+		tt_int_add(t, t, c);
+		if (tt_int_cmp(d, t)) {
+			tt_error("addmul_ui mismatch");
+			break;
+		}
+		if (num) {
+			uint64_t r;
+			ret = tt_int_div_ui(d, &r, c, num);
+			assert(ret == 0 && _tt_int_sanity(d) == 0);
+			tt_int_mul_ui(t, d, num);
+			tt_int_from_uint(u, r);
+			u->sign = c->sign;
+			tt_int_add(t, t, u);
+			if (tt_int_cmp(c, t) || r >= num) {
+				tt_error("div_ui mismatch");
+				break;
+			}
+		}
+
+		tt_int_free(a);
+		tt_int_free(b);
+		tt_int_free(c);
+	}
+
+	/* All ones dst, carry of product buffer runs through every word
+	 * - t = 2^(24 * word bits) - 1, not below Karatsuba cross point
+	 * - d = 2^(60 * word bits) - 1
+	 */
+	struct tt_int *e = tt_int_alloc();
+	tt_int_from_uint(u, 1);
+	tt_int_from_uint(t, 1);
+	tt_int_shift(t, _tt_word_bits * 24);
+	tt_int_sub(t, t, u);
+	tt_int_from_uint(d, 1);
+	tt_int_shift(d, _tt_word_bits * 60);
+	tt_int_sub(d, d, u);
+	tt_int_mul(e, t, t);
+	tt_int_add(e, e, d);
+	assert(tt_int_addmul(d, t, t) == 0 && _tt_int_sanity(d) == 0);
+	assert(tt_int_cmp(d, e) == 0);
+	tt_int_free(e);
+
+	tt_int_free(d);
+	tt_int_free(t);
+	tt_int_free(u);
+}
+
+static void verify_divexact(int count)
+{
+	printf("Exact division...\n");
+
+	struct tt_int *p = tt_int_alloc();
+	struct tt_int *q = tt_int_alloc();
+	struct tt_int *one = tt_int_alloc();
+	tt_int_from_uint(one, 1);
+
+	for (int i = 0; i < count; i++) {
+		struct tt_int *a = rand_int(rand() % 80 + 1);
+		struct tt_int *b = rand_int(rand() % 80 + 1);
+		if (_tt_int_is_zero(b))
+			tt_int_from_uint(b, 3);
+		a->sign = rand() & 1;
+		b->sign = rand() & 1;
+		if (rand() & 1)
+			tt_int_shift(b, rand() % 200);
+
+		/* (a*b) / b == a */
+		tt_int_mul(p, a, b);
+		int ret = tt_int_divexact(q, p, b);
+		assert(ret == 0 && _tt_int_sanity(q) == 0);
+		if (tt_int_cmp(q, a)) {
+			tt_error("divexact mismatch");
+			break;
+		}
+		if (!tt_int_isdivisible(p, b) || !tt_int_isdivisible(p, a)) {
+			tt_error("divisible mismatch");
+			break;
+		}
+
+		/* a*b + 1 is not divisible by b (|b| > 1) */
+		tt_int_add(p, p, one);
+		if (tt_int_cmp_abs(b, one) > 0 && tt_int_isdivisible(p, b)) {
+			tt_error("not divisible mismatch");
+			break;
+		}
+
+		tt_int_free(a);
+		tt_int_free(b);
+	}
+
+	tt_int_free(p);
+	tt_int_free(q);
+	tt_int_free(one);
+}
+
+static void verify_mod_multi(int count)
+{
+	printf("Multi-modulus & CRT...\n");
+
+	struct tt_int *r = tt_int_alloc();
+	struct tt_int *x = tt_int_alloc();
+	struct tt_int *M = tt_int_alloc();
+	struct tt_int *two = tt_int_alloc();
+	tt_int_from_uint(two, 2);
+
+	for (int i = 0; i < count; i++) {
+		const int n = rand() % 40 + 1;
+		struct tt_int *mods[40], *rems[40];
+
+		/* Distinct primes of 1 ~ 3 words */
+		tt_int_from_uint(M, 1);
+		for (int j = 0; j < n; j++) {
+			struct tt_int *p = rand_int(rand() % 3 + 1);
+			p->buf[0] |= 1;
+			while (1) {
+				int k;
+				for (k = 0; k < j; k++)
+					if (tt_int_cmp(p, mods[k]) == 0)
+						break;
+				if (k == j && tt_int_isprime(p))
+					break;
+				tt_int_add(p, p, two);
+			}
+			mods[j] = p;
+			rems[j] = tt_int_alloc();
+			tt_int_mul(M, M, p);
+		}
+
+		/* Reduce random x, -M < x < M */
+		struct tt_int *a = rand_int(M->msb);
+		a->sign = rand() & 1;
+		tt_int_div(NULL, a, a, M);
+
+		int ret = tt_int_mod_multi(rems, a, mods, n), bad = 0;
+		assert(ret == 0);
+		for (int j = 0; j < n && !bad; j++) {
+			tt_int_div(NULL, r, a, mods[j]);
+			if (r->sign && !_tt_int_is_zero(r))
+				tt_int_add(r, r, mods[j]);
+			bad = tt_int_cmp(r, rems[j]);
+		}
+		if (bad)
+			tt_error("mod_multi mismatch");
+
+		/* CRT gives back a mod M */
+		ret = tt_int_crt(x, rems, mods, n);
+		assert(ret == 0 && _tt_int_sanity(x) == 0);
+		if (a->sign)
+			tt_int_add(a, a, M);
+		if (!bad && tt_int_cmp(x, a)) {
+			tt_error("crt mismatch");
+			bad = 1;
+		}
+
+		for (int j = 0; j < n; j++) {
+			tt_int_free(mods[j]);
+			tt_int_free(rems[j]);
+		}
+		tt_int_free(a);
+		if (bad)
+			break;
+	}
+
+	tt_int_free(r);
+	tt_int_free(x);
+	tt_int_free(M);
+	tt_int_free(two);
+}
+
+static void verify_pow_root(int count)
+{
+	printf("Pow & Root...\n");
+
+	struct tt_int *p = tt_int_alloc();
+	struct tt_int *r = tt_int_alloc();
+	struct tt_int *t = tt_int_alloc();
+	struct tt_int *one = tt_int_alloc();
+	tt_int_from_uint(one, 1);
+
+	for (int i = 1; i <= count; i++) {
+		int ret;
+		struct tt_int *a = rand_int(rand() % 200 + 1);
+		const uint n = rand() % 6 + 2;
+
+		/* p = a^n, check against repeated multiplication */
+		ret = tt_int_pow(p, a, n);
+		assert(ret == 0 && _tt_int_sanity(p) == 0);
+		_tt_int_copy(t, a);
+		for (int j = 1; j < n; j++)
+			tt_int_mul(t, t, a);
+		if (tt_int_cmp(p, t)) {
+			tt_error("pow mismatch");
+			break;
+		}
+
+		/* r = floor(a^(1/n)), r^n <= a < (r+1)^n */
+		ret = tt_int_root(r, a, n);
+		assert(ret == 0 && _tt_int_sanity(r) == 0);
+		tt_int_pow(t, r, n);
+		if (tt_int_cmp(t, a) > 0) {
+			tt_error("root too large");
+			break;
+		}
+		tt_int_add(r, r, one);
+		tt_int_pow(t, r, n);
+		if (tt_int_cmp(t, a) <= 0) {
+			tt_error("root too small");
+			break;
+		}
+
+		/* sqrt(p^2) == p */
+		tt_int_mul(t, p, p);
+		ret = tt_int_sqrt(t, t);
+		assert(ret == 0 && _tt_int_sanity(t) == 0);
+		if (tt_int_cmp(t, p)) {
+			tt_error("sqrt mismatch");
+			break;
+		}
+
+		tt_int_free(a);
+	}
+
+	tt_int_free(p);
+	tt_int_free(r);
+	tt_int_free(t);
+	tt_int_free(one);
+}
+
+static void verify_factorial(int count)
+{
+	printf("Factorial & Binomial...\n");
+
+	struct tt_int *f = tt_int_alloc();
+	struct tt_int *t = tt_int_alloc();
+	struct tt_int *t2 = tt_int_alloc();
+
+	for (int i = 1; i <= count; i++) {
+		int ret;
+		const uint n = rand() % 3000 + 1;
+		const uint k = rand() % (n + 1);
+
+		/* n! against naive product */
+		ret = tt_int_factorial(f, n);
+		assert(ret == 0 && _tt_int_sanity(f) == 0);
+		tt_int_from_uint(t, 1);
+		for (uint j = 2; j <= n; j++) {
+			tt_int_from_uint(t2, j);
+			tt_int_mul(t, t, t2);
+		}
+		if (tt_int_cmp(f, t)) {
+			tt_error("factorial mismatch: %u", n);
+			break;
+		}
+
+		/* C(n,k) * k! * (n-k)! == n! */
+		ret = tt_int_binomial(t, n, k);
+		assert(ret == 0 && _tt_int_sanity(t) == 0);
+		if (k) {
+			tt_int_factorial(t2, k);
+			tt_int_mul(t, t, t2);
+		}
+		if (n - k) {
+			tt_int_factorial(t2, n - k);
+			tt_int_mul(t, t, t2);
+		}
+		if (tt_int_cmp(f, t)) {
+			tt_error("binomial mismatch: C(%u, %u)", n, k);
+			break;
+		}
+	}
+
+	/* 30# = 6469693230 */
+	tt_int_primorial(f, 30);
+	tt_int_from_uint(t, 6469693230ULL);
+	if (tt_int_cmp(f, t))
+		tt_error("primorial mismatch");
+
+	/* Large enough for threaded products, against serial word products */
+	const uint n = 50000;
+	int ret = tt_int_factorial(f, n);
+	assert(ret == 0 && _tt_int_sanity(f) == 0);
+	tt_int_from_uint(t, 1);
+	for (uint j = 2; j <= n; j++)
+		tt_int_mul_ui(t, t, j);
+	if (tt_int_cmp(f, t))
+		tt_error("factorial mismatch: %u", n);
+
+	/* C(n, n/2) * (n/2)!^2 == n! */
+	ret = tt_int_binomial(t, n, n / 2);
+	assert(ret == 0 && _tt_int_sanity(t) == 0);
+	tt_int_factorial(t2, n / 2);
+	tt_int_mul(t, t, t2);
+	tt_int_mul(t, t, t2);
+	if (tt_int_cmp(f, t))
+		tt_error("binomial mismatch: C(%u, %u)", n, n / 2);
+
+	/* n# against product of primes by trial division */
+	ret = tt_int_primorial(f, n);
+	assert(ret == 0 && _tt_int_sanity(f) == 0);
+	tt_int_from_uint(t, 1);
+	for (uint j = 2; j <= n; j++) {
+		uint d = 2;
+		while (d * d <= j && j % d)
+			d++;
+		if (d * d > j)
+			tt_int_mul_ui(t, t, j);
+	}
+	if (tt_int_cmp(f, t))
+		tt_error("primorial mismatch: %u", n);
+
+	tt_int_free(f);
+	tt_int_free(t);
+	tt_int_free(t2);
+}
+
+static void verify_import_export(int count)
+{
+	printf("Import & Export...\n");
+
+	struct tt_int *t = tt_int_alloc();
+
+	/* Known value, big endian bytes */
+	const uchar be[] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 };
+	struct tt_int *ti = tt_int_alloc();
+	tt_int_from_string(ti, "0x0102030405060708090A");
+	tt_int_import(t, be, sizeof(be), 1, 1, 1, 0);
+	if (tt_int_cmp(t, ti))
+		tt_error("import mismatch");
+	tt_int_free(ti);
+
+	for (int i = 0; i < count; i++) {
+		int ret;
+		struct tt_int *a = rand_int(rand() % 100 + 1);
+		a->sign = 0;
+
+		const int order = rand() & 1 ? 1 : -1;
+		const int endian = rand() % 3 - 1;
+		const size_t size = rand() % 12 + 1;
+		const size_t nails = rand() % (size * 8);
+
+		size_t n;
+		tt_int_export(a, NULL, &n, order, size, endian, nails);
+		uchar *buf = malloc(n * size + a->msb * _tt_word_sz);
+		size_t n2 = n;
+		ret = tt_int_export(a, buf, &n2, order, size, endian, nails);
+		assert(ret == 0 && n2 == n);
+		ret = tt_int_import(t, buf, n, order, size, endian, nails);
+		assert(ret == 0 && _tt_int_sanity(t) == 0);
+		if (tt_int_cmp(a, t)) {
+			tt_error("import/export mismatch: order=%d, size=%zu, "
+				"endian=%d, nails=%zu", order, size, endian,
+				nails);
+			break;
+		}
+
+		/* Limb layout */
+		n = a->msb;
+		tt_int_export(a, buf, &n, -1, _tt_word_sz, 0, 1);
+		tt_int_import(t, buf, n, -1, _tt_word_sz, 0, 1);
+		if (tt_int_cmp(a, t)) {
+			tt_error("import/export limb mismatch");
+			break;
+		}
+
+		free(buf);
+		tt_int_free(a);
+	}
+
+	tt_int_free(t);
+}
+
 void gen_exp10(int e)
 {
 	char *s = malloc(e+2);
@@ -319,6 +872,57 @@ void gen_exp10(int e)
 	printf("\n};\n\n");
 }
 
+static int stats_hooked;
+
+static void stats_hook(int id, uint64_t cycles, void *context)
+{
+	if (id == TT_STAT_INT_MUL)
+		(*(int *)context)++;
+}
+
+/* Counters are built in only by "make STATS=1" */
+static void verify_stats(void)
+{
+	struct tt_stats st;
+
+	tt_stats_reset();
+	if (tt_stats_snapshot(&st) == TT_ENOTSUP) {
+		assert(st.stat[TT_STAT_INT_MUL].calls == 0);
+		return;
+	}
+	for (int i = 0; i < TT_STAT_MAX; i++)
+		assert(st.stat[i].calls == 0);
+
+	struct tt_param param;
+	tt_param_get(&param);
+
+	struct tt_int *ti1 = tt_int_alloc(), *ti2 = tt_int_alloc();
+	tt_stats_set_hook(stats_hook, &stats_hooked);
+
+	/* One classic and one Karatsuba multiplication */
+	tt_int_from_uint(ti1, 12345);
+	tt_int_mul(ti2, ti1, ti1);
+	tt_int_from_uint(ti1, 1);
+	tt_int_shift(ti1, param.kara_cross * _tt_word_bits);
+	tt_int_mul(ti2, ti1, ti1);
+
+	tt_stats_set_hook(NULL, NULL);
+	tt_stats_snapshot(&st);
+	assert(st.stat[TT_STAT_INT_MUL].calls == 2);
+	assert(st.stat[TT_STAT_INT_MUL].cycles > 0);
+	assert(st.stat[TT_STAT_INT_MUL_CLASSIC].calls >= 1);
+	assert(st.stat[TT_STAT_INT_MUL_KARA].calls >= 1);
+	assert(st.stat[TT_STAT_INT_SHIFT].calls == 1);
+	assert(st.stat[TT_STAT_INT_ALLOC].calls >= 2);
+	assert(st.stat[TT_STAT_INT_ALLOC].bytes > 0);
+	assert(stats_hooked == 2);
+	assert(strcmp(tt_stats_name(TT_STAT_INT_MUL_KARA),
+				"int_mul_karatsuba") == 0);
+
+	tt_int_free(ti1);
+	tt_int_free(ti2);
+}
+
 int main(void)
 {
 	srand(time(NULL));
@@ -412,5 +1016,26 @@ int main(void)
 	verify_add_sub(count);
 	verify_mul_div(count);
 
+	/* Small cross points exercise Karatsuba and divide and conquer */
+	struct tt_param param, saved;
+	tt_param_get(&saved);
+	param = saved;
+	param.kara_cross = 4;
+	param.bindiv_cross = 8;
+	assert(tt_param_set(&param) == 0);
+	verify_mul_div(count / 10);
+	tt_param_set(&saved);
+	param.kara_cross = 1;
+	assert(tt_param_set(&param) == TT_EINVAL);
+
+	verify_logic(count);
+	verify_addmul(count);
+	verify_divexact(count);
+	verify_mod_multi(count / 100);
+	verify_pow_root(count / 10);
+	verify_factorial(count / 50);
+	verify_import_export(count);
+	verify_stats();
+
 	return 0;
 }
@@ -0,0 +1,162 @@
+/* Test trace logging
+ *
+ * Copyright (C) 2016 Yibo Cai
+ */
+#include <tt/tt.h>
+#include <common/lib.h>
+
+#include <string.h>
+#include <pthread.h>
+#include <assert.h>
+#include <time.h>
+
+#define THREADS	4
+#define LOOPS	100
+
+static void *log_thread(void *arg)
+{
+	const int id = (intptr_t)arg;
+
+	for (int i = 0; i < LOOPS; i++)
+		tt_info("thread %d, loop %03u, %.2f, %s", id, i, i / 4.0,
+				i & 1 ? "odd" : "even");
+	return NULL;
+}
+
+/* Dump traces to a temporary file, return its content */
+static char *dump(void)
+{
+	FILE *f = tmpfile();
+	assert(f);
+	assert(tt_log_dump(fileno(f)) == 0);
+
+	long sz = ftell(f);
+	fseek(f, 0, SEEK_SET);
+	char *s = calloc(sz + 1, 1);
+	assert(fread(s, 1, sz, f) == sz);
+	fclose(f);
+	return s;
+}
+
+static int count_lines(const char *s)
+{
+	int n = 0;
+
+	while ((s = strchr(s, '\n'))) {
+		n++;
+		s++;
+	}
+	return n;
+}
+
+/* Thread id of the line containing msg */
+static int line_tid(const char *s, const char *msg)
+{
+	const char *l = strstr(s, msg);
+	assert(l);
+	while (l > s && l[-1] != '\n')
+		l--;
+
+	int id = -1;
+	assert(sscanf(l, "%*s T%d", &id) == 1);
+	return id;
+}
+
+static void verify_trace(void)
+{
+	tt_log_set_target(TT_LOG_TARGET_TRACE);
+
+	/* Deferred formatting */
+	char tmp[16] = "transient";
+	tt_warn("%d %5ld %-4x| %llu %c %5.1e", -1, 12L, 0xab, 1ULL << 63, 'z',
+			12345.0);
+	tt_warn("%*d %.*s %s %%", 3, 7, 4, "abcdef", tmp);
+	strcpy(tmp, "overwritten");
+	char *s = dump();
+	assert(strstr(s, "[W]verify_trace: -1    12 ab  | "
+				"9223372036854775808 z 1.2e+04\n"));
+	assert(strstr(s, "[W]verify_trace:   7 abcd transient %\n"));
+	assert(count_lines(s) == 2);
+	free(s);
+
+	/* Arguments exceeding record capacity */
+	tt_warn("%d %d %d %d %d %d %d %d %d", 1, 2, 3, 4, 5, 6, 7, 8, 9);
+	s = dump();
+	assert(strstr(s, ": 1 2 3 4 5 6 7 8 <Truncated>\n"));
+	assert(count_lines(s) == 1);
+	free(s);
+
+	/* Nothing left after dump */
+	s = dump();
+	assert(s[0] == '\0');
+	free(s);
+
+	/* Filtered by level */
+	int level = tt_log_set_level(TT_LOG_WARN);
+	tt_info("filtered");
+	tt_log_set_level(level);
+	s = dump();
+	assert(s[0] == '\0');
+	free(s);
+
+	/* Multiple threads */
+	pthread_t th[THREADS];
+	for (int i = 0; i < THREADS; i++)
+		assert(pthread_create(&th[i], NULL, log_thread,
+					(void *)(intptr_t)i) == 0);
+	for (int i = 0; i < THREADS; i++)
+		pthread_join(th[i], NULL);
+
+	s = dump();
+	assert(count_lines(s) == THREADS * LOOPS);
+	assert(strstr(s, "[I]log_thread: thread 2, loop 099, 24.75, odd\n"));
+	assert(strstr(s, "[I]log_thread: thread 0, loop 000, 0.00, even\n"));
+	free(s);
+
+	/* Threads one after another reuse ring of exited thread, records of
+	 * each thread keep its own id
+	 */
+	for (int i = 0; i < THREADS; i++) {
+		assert(pthread_create(&th[0], NULL, log_thread,
+					(void *)(intptr_t)i) == 0);
+		pthread_join(th[0], NULL);
+	}
+
+	s = dump();
+	assert(count_lines(s) == THREADS * LOOPS);
+	int tid[THREADS];
+	for (int i = 0; i < THREADS; i++) {
+		char msg[32];
+		snprintf(msg, sizeof(msg), "thread %d, loop 099", i);
+		tid[i] = line_tid(s, msg);
+		for (int j = 0; j < i; j++)
+			assert(tid[i] != tid[j]);
+	}
+	free(s);
+
+	tt_log_set_target(TT_LOG_TARGET_STDERR);
+}
+
+static void bench_trace(void)
+{
+	const int loops = 100000;
+	struct timespec t0, t1;
+
+	tt_log_set_target(TT_LOG_TARGET_TRACE);
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	for (int i = 0; i < loops; i++)
+		tt_info("loop %d, %f", i, i * 0.5);
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	tt_log_set_target(TT_LOG_TARGET_STDERR);
+
+	printf("trace: %.1f ns per message\n", ((t1.tv_sec - t0.tv_sec) * 1e9 +
+				(t1.tv_nsec - t0.tv_nsec)) / loops);
+}
+
+int main(void)
+{
+	verify_trace();
+	bench_trace();
+
+	return 0;
+}
@@ -0,0 +1,3 @@
+tune-objs		:= tune.o
+
+bin-y += tune
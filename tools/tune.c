@@ -0,0 +1,330 @@
+/* Tune algorithm cross points on host
+ *
+ * Usage: tune [output-file]
+ * - time each algorithm pair around its cross point
+ * - write parameters in tt_param_load() format, to stdout by default
+ *
+ * Copyright (C) 2016 Yibo Cai
+ */
+#include <tt/tt.h>
+#include <tt/apn/integer.h>
+#include <tt/apn/decimal.h>
+#include <tt/num/dft.h>
+#include <tt/common/param.h>
+#include <common/lib.h>
+#include <apn/integer/integer.h>
+#include <apn/decimal/decimal.h>
+
+#include <time.h>
+#include <string.h>
+
+#define SAMPLES		7	/* Median of samples */
+#define SAMPLE_NS	2000000	/* Minimal time of one sample */
+#define CONFIRM		3	/* Consecutive wins to confirm a cross point */
+
+struct op {
+	void (*run)(struct op *op);
+	struct tt_int *r, *q, *a, *b;
+	struct tt_dec *dr, *da, *db;
+	double (*in)[2], (*out)[2];
+	int n;
+};
+
+static double now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static int cmp_double(const void *a, const void *b)
+{
+	const double d = *(const double *)a - *(const double *)b;
+
+	return (d > 0) - (d < 0);
+}
+
+/* Median time of one operation in ns */
+static double time_op(struct op *op)
+{
+	/* Calibrate repetitions */
+	int reps = 1;
+	while (1) {
+		double t = now_ns();
+		for (int i = 0; i < reps; i++)
+			op->run(op);
+		if (now_ns() - t >= SAMPLE_NS / 4 || reps >= (1 << 24))
+			break;
+		reps *= 2;
+	}
+	reps *= 4;
+
+	double samples[SAMPLES];
+	for (int s = 0; s < SAMPLES; s++) {
+		double t = now_ns();
+		for (int i = 0; i < reps; i++)
+			op->run(op);
+		samples[s] = (now_ns() - t) / reps;
+	}
+	qsort(samples, SAMPLES, sizeof(double), cmp_double);
+
+	return samples[SAMPLES / 2];
+}
+
+static void rand_int(struct tt_int *ti, int msb)
+{
+	_tt_int_zero(ti);
+	_tt_int_realloc(ti, msb);
+
+	for (int i = 0; i < msb; i++) {
+		ti->buf[i] = ((uint64_t)rand() << 32) | rand();
+		ti->buf[i] &= ~_tt_word_top_bit;
+	}
+	if (ti->buf[msb-1] == 0)
+		ti->buf[msb-1] = 1;
+	ti->msb = msb;
+}
+
+static void run_mul(struct op *op)
+{
+	tt_int_mul(op->r, op->a, op->b);
+}
+
+static void run_dec_mul(struct op *op)
+{
+	tt_dec_mul(op->dr, op->da, op->db);
+}
+
+static void run_dec_div(struct op *op)
+{
+	tt_dec_div(op->dr, op->da, op->db);
+}
+
+static void run_div(struct op *op)
+{
+	tt_int_div(op->q, op->r, op->a, op->b);
+}
+
+static void run_str(struct op *op)
+{
+	char *s = NULL;
+
+	if (tt_int_to_string(op->a, &s, 10) == 0)
+		free(s);
+}
+
+static void run_fft(struct op *op)
+{
+	tt_fft(op->out, op->in, op->n);
+}
+
+/* Find first size where the cross point algorithm wins
+ * - set(param, n): use fast algorithm on size n
+ * - set(param, n+1): use basic algorithm on size n
+ */
+static int tune_cross(struct op *op, struct tt_param *param, int *value,
+		int from, int to, int step, void (*prep)(struct op *op, int n))
+{
+	const int old = *value;
+	int wins = 0;
+
+	for (int n = from; n <= to; n += step) {
+		prep(op, n);
+
+		*value = n + 1;
+		tt_param_set(param);
+		const double t_basic = time_op(op);
+
+		*value = n;
+		tt_param_set(param);
+		const double t_fast = time_op(op);
+
+		if (t_fast < t_basic) {
+			if (++wins == CONFIRM) {
+				*value = n - (CONFIRM - 1) * step;
+				tt_param_set(param);
+				return *value;
+			}
+		} else {
+			wins = 0;
+		}
+	}
+
+	*value = old;
+	tt_param_set(param);
+	return old;
+}
+
+static void prep_mul(struct op *op, int n)
+{
+	rand_int(op->a, n);
+	rand_int(op->b, n);
+}
+
+/* Decimal of n significand words, all digits non-zero */
+static void rand_dec(struct tt_dec **dec, int n)
+{
+	const int digs = n * _TT_DEC_DIGS;
+	char *s = malloc(digs + 1);
+
+	for (int i = 0; i < digs; i++)
+		s[i] = '1' + rand() % 9;
+	s[digs] = '\0';
+
+	if (*dec)
+		tt_dec_free(*dec);
+	*dec = tt_dec_alloc(digs);
+	tt_dec_from_string(*dec, s);
+	free(s);
+}
+
+static void prep_dec_mul(struct op *op, int n)
+{
+	rand_dec(&op->da, n);
+	rand_dec(&op->db, n);
+	if (op->dr)
+		tt_dec_free(op->dr);
+	op->dr = tt_dec_alloc(n * _TT_DEC_DIGS * 2);
+}
+
+/* Quotient and divisor of n words */
+static void prep_dec_div(struct op *op, int n)
+{
+	prep_dec_mul(op, n);
+	tt_dec_free(op->dr);
+	op->dr = tt_dec_alloc(n * _TT_DEC_DIGS);
+}
+
+static void prep_div(struct op *op, int n)
+{
+	rand_int(op->a, n * 2);
+	rand_int(op->b, n);
+}
+
+/* Pick the candidate with least total time */
+static int tune_min(struct op *op, struct tt_param *param, int *value,
+		const int *cand, int ncand, void (*prep)(struct op *op, int n),
+		const int *sizes, int nsizes)
+{
+	int best = *value;
+	double best_t = 0;
+
+	for (int c = 0; c < ncand; c++) {
+		*value = cand[c];
+		if (tt_param_set(param))
+			continue;
+
+		double t = 0;
+		for (int s = 0; s < nsizes; s++) {
+			prep(op, sizes[s]);
+			t += time_op(op);
+		}
+		if (c == 0 || t < best_t) {
+			best_t = t;
+			best = cand[c];
+		}
+	}
+
+	*value = best;
+	tt_param_set(param);
+	return best;
+}
+
+static void prep_str(struct op *op, int n)
+{
+	rand_int(op->a, n);
+}
+
+static void prep_fft(struct op *op, int n)
+{
+	op->n = n;
+	for (int i = 0; i < n; i++) {
+		op->in[i][0] = rand() / (double)RAND_MAX;
+		op->in[i][1] = 0;
+	}
+}
+
+int main(int argc, char **argv)
+{
+	FILE *fp = stdout;
+	if (argc > 1) {
+		fp = fopen(argv[1], "w");
+		if (fp == NULL) {
+			tt_error("Cannot open %s", argv[1]);
+			return 1;
+		}
+	}
+
+	struct tt_param param;
+	tt_param_get(&param);
+	tt_log_set_level(TT_LOG_WARN);
+	srand(1);
+
+	struct op op = {
+		.r = tt_int_alloc(),
+		.q = tt_int_alloc(),
+		.a = tt_int_alloc(),
+		.b = tt_int_alloc(),
+		.in = malloc((1 << 16) * sizeof(*op.in)),
+		.out = malloc((1 << 16) * sizeof(*op.out)),
+	};
+
+	op.run = run_mul;
+	fprintf(stderr, "Tuning kara_cross...\n");
+	tune_cross(&op, &param, &param.kara_cross, 8, 120, 1, prep_mul);
+
+	op.run = run_div;
+	fprintf(stderr, "Tuning bindiv_cross...\n");
+	tune_cross(&op, &param, &param.bindiv_cross, 10, 200, 2, prep_div);
+
+	op.run = run_dec_mul;
+	fprintf(stderr, "Tuning dec_kara_cross...\n");
+	tune_cross(&op, &param, &param.dec_kara_cross, 8, 120, 1,
+			prep_dec_mul);
+	fprintf(stderr, "Tuning dec_ntt_cross...\n");
+	tune_cross(&op, &param, &param.dec_ntt_cross, 100, 4000, 50,
+			prep_dec_mul);
+	op.run = run_dec_div;
+	fprintf(stderr, "Tuning dec_newton_cross...\n");
+	tune_cross(&op, &param, &param.dec_newton_cross, 20, 1000, 20,
+			prep_dec_div);
+
+	op.run = run_str;
+	fprintf(stderr, "Tuning dec9_cross_idx...\n");
+	const int idx[] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 };
+	const int words[] = { 8, 16, 32, 64, 128, 256, 512 };
+	tune_min(&op, &param, &param.dec9_cross_idx, idx, ARRAY_SIZE(idx),
+			prep_str, words, ARRAY_SIZE(words));
+
+	op.run = run_fft;
+	fprintf(stderr, "Tuning fft_wn_pts...\n");
+	const int pts[] = { 1024, 2048, 4096, 8192, 16384, 32768, 65536 };
+	const int points[] = { 64, 256, 1024, 4096, 16384, 65536 };
+	tune_min(&op, &param, &param.fft_wn_pts, pts, ARRAY_SIZE(pts),
+			prep_fft, points, ARRAY_SIZE(points));
+
+	char host[64] = "unknown";
+	gethostname(host, sizeof(host) - 1);
+	fprintf(fp, "# Generated by \"make tune\" on %s\n", host);
+	fprintf(fp, "kara_cross = %d\n", param.kara_cross);
+	fprintf(fp, "bindiv_cross = %d\n", param.bindiv_cross);
+	fprintf(fp, "dec9_cross_idx = %d\n", param.dec9_cross_idx);
+	fprintf(fp, "fft_wn_pts = %d\n", param.fft_wn_pts);
+	fprintf(fp, "dec_kara_cross = %d\n", param.dec_kara_cross);
+	fprintf(fp, "dec_ntt_cross = %d\n", param.dec_ntt_cross);
+	fprintf(fp, "dec_newton_cross = %d\n", param.dec_newton_cross);
+
+	if (fp != stdout)
+		fclose(fp);
+	tt_int_free(op.r);
+	tt_int_free(op.q);
+	tt_int_free(op.a);
+	tt_int_free(op.b);
+	tt_dec_free(op.dr);
+	tt_dec_free(op.da);
+	tt_dec_free(op.db);
+	free(op.in);
+	free(op.out);
+	return 0;
+}